@@ -0,0 +1,45 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.cpp
+//
+// Identification: src/buffer/buffer_access_strategy.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_access_strategy.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+BufferAccessStrategy::BufferAccessStrategy(size_t ring_size) : ring_size_(ring_size) {
+  BUSTUB_ASSERT(ring_size > 0, "ring must not be empty");
+}
+
+bool BufferAccessStrategy::Advance(const BufferPoolManager *bpm, frame_id_t *frame_id, page_id_t *page_id) {
+  std::scoped_lock lock{latch_};
+  Ring &ring = rings_[bpm];
+  // The ring fills up one slot per miss, after that it wraps around
+  if (ring.slots_.size() < ring_size_) {
+    ring.current_ = ring.slots_.size();
+    ring.slots_.emplace_back(-1, INVALID_PAGE_ID);
+    return false;
+  }
+  ring.current_ = (ring.current_ + 1) % ring_size_;
+  *frame_id = ring.slots_[ring.current_].first;
+  *page_id = ring.slots_[ring.current_].second;
+  return *page_id != INVALID_PAGE_ID;
+}
+
+void BufferAccessStrategy::SetCurrent(const BufferPoolManager *bpm, frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock lock{latch_};
+  Ring &ring = rings_[bpm];
+  BUSTUB_ASSERT(ring.current_ < ring.slots_.size(), "SetCurrent must follow Advance");
+  ring.slots_[ring.current_] = {frame_id, page_id};
+}
+
+}  // namespace bustub
@@ -12,17 +12,54 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <list>
+#include <memory>
+#include <new>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+#include "common/macros.h"
 #include "include/common/logger.h"  // 日志调试
 
 namespace bustub {
 
 BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+    : BufferPoolManager(pool_size, 1, 0, disk_manager, log_manager) {}
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, ReplacerType replacer_type,
+                                     size_t replacer_k, LogManager *log_manager)
+    : BufferPoolManager(pool_size, 1, 0, disk_manager, log_manager, replacer_type, replacer_k) {}
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                     DiskManager *disk_manager, LogManager *log_manager, ReplacerType replacer_type,
+                                     size_t replacer_k)
+    : pool_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "a buffer pool has at least one instance");
+  BUSTUB_ASSERT(instance_index < num_instances, "instance index must be less than the number of instances");
   // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  frame_arena_ = new FrameArena(pool_size_);
+  pages_ = frame_arena_->GetPages();
+  in_write_back_.resize(pool_size_, false);
+  in_prefetch_.resize(pool_size_, false);
+  switch (replacer_type) {
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(pool_size, replacer_k);
+      break;
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(pool_size);
+      break;
+    case ReplacerType::LRU:
+    default:
+      replacer_ = new LRUReplacer(pool_size);
+      break;
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -30,8 +67,19 @@ BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager
   }
 }
 
+BufferPoolManager::BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager, size_t pool_size)
+    : pool_size_(pool_size),
+      frame_arena_(nullptr),
+      pages_(nullptr),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      replacer_(nullptr) {}
+
 BufferPoolManager::~BufferPoolManager() {
-  delete[] pages_;
+  WaitForWarmUp();
+  StopPrefetcher();
+  StopBackgroundWriter();
+  delete frame_arena_;
   delete replacer_;
 }
 
@@ -54,9 +102,15 @@ BufferPoolManager::~BufferPoolManager() {
 */
 void BufferPoolManager::UpdatePage(Page *page, page_id_t new_page_id, frame_id_t new_frame_id) {
   // 1 如果是脏页，一定要写回磁盘，并且把dirty置为false
-  if (page->IsDirty()) {
+  // 后台写线程已经选中、但还没写完的page也要当作脏页：它会发现page已被替换而放弃写回
+  // 这是同步写回（后台写线程没来得及清理这个victim），顺便唤醒后台写线程
+  frame_id_t frame_id = static_cast<frame_id_t>(page - pages_);
+  if (page->IsDirty() || in_write_back_[frame_id]) {
     disk_manager_->WritePage(page->page_id_, page->data_);
     page->is_dirty_ = false;
+    in_write_back_[frame_id] = false;
+    num_sync_write_backs_++;
+    writer_cv_.notify_one();
   }
 
   // 2 更新page table
@@ -70,11 +124,29 @@ void BufferPoolManager::UpdatePage(Page *page, page_id_t new_page_id, frame_id_t
   page->page_id_ = new_page_id;
 }
 
+/*
+分配一个新的page id。非分片时交给DiskManager；作为ParallelBufferPoolManager的分片时，
+只分配满足 page_id % num_instances_ == instance_index_ 的page id，这样page id能被路由回本分片
+*/
+page_id_t BufferPoolManager::AllocatePage(segment_id_t segment) {
+  return disk_manager_->AllocatePage(num_instances_, instance_index_, segment);
+}
+
 /*
 从free_list或replacer中得到*frame_id；返回bool类型
 （自己补充的函数）
 */
-bool BufferPoolManager::FindVictimPage(frame_id_t *frame_id) {
+bool BufferPoolManager::FindVictimPage(frame_id_t *frame_id, BufferAccessStrategy *strategy) {
+  // 0 通过strategy访问时，先看ring中轮到的frame能不能复用：它还保存着ring读入的page，而且没有被pin
+  // 调用者读入新page后要调用strategy->SetCurrent，把这个frame（或者从下面得到的frame）记到ring中
+  if (strategy != nullptr) {
+    page_id_t ring_page_id;
+    if (strategy->Advance(this, frame_id, &ring_page_id) && pages_[*frame_id].page_id_ == ring_page_id &&
+        pages_[*frame_id].pin_count_ == 0 && !in_prefetch_[*frame_id]) {
+      replacer_->Pin(*frame_id);  // 从replacer中取出
+      return true;
+    }
+  }
   // 1 缓冲池还有freepages（缓冲池未满），即free_list非空，直接从free_list取出一个
   // 注意，在此函数中从free_list首部取出frame_id，在DeletePage函数中从free_list尾部添加frame_id
   if (!free_list_.empty()) {
@@ -86,6 +158,361 @@ bool BufferPoolManager::FindVictimPage(frame_id_t *frame_id) {
   return replacer_->Victim(frame_id);
 }
 
+void BufferPoolManager::RunBackgroundWriter(const BackgroundWriterOptions &options) {
+  std::scoped_lock lock{writer_latch_};
+  if (background_writer_ != nullptr) {
+    return;
+  }
+  writer_running_ = true;
+  background_writer_ = new std::thread(&BufferPoolManager::BackgroundWriterLoop, this, options);
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  std::thread *writer;
+  {
+    std::scoped_lock lock{writer_latch_};
+    if (background_writer_ == nullptr) {
+      return;
+    }
+    writer_running_ = false;
+    writer = background_writer_;
+    background_writer_ = nullptr;
+  }
+  writer_cv_.notify_one();
+  writer->join();
+  delete writer;
+}
+
+void BufferPoolManager::BackgroundWriterLoop(BackgroundWriterOptions options) {
+  std::unique_lock lock{writer_latch_};
+  while (writer_running_) {
+    writer_cv_.wait_for(lock, options.interval_);
+    if (!writer_running_) {
+      break;
+    }
+    lock.unlock();
+    WriteBackVictimCandidates(options);
+    lock.lock();
+  }
+}
+
+bool BufferPoolManager::PrefetchPage(page_id_t page_id, next_page_fn next_page, size_t num_pages,
+                                     const std::shared_ptr<BufferAccessStrategy> &strategy) {
+  if (page_id == INVALID_PAGE_ID || num_pages == 0) {
+    return true;
+  }
+  {
+    std::scoped_lock lock{prefetch_latch_};
+    // 队列最多排pool_size_个请求，预读的page比缓冲池还多就没有意义了
+    if (prefetch_queue_.size() >= pool_size_) {
+      return false;
+    }
+    prefetch_queue_.push_back({page_id, next_page, num_pages, strategy});
+    if (prefetcher_ == nullptr) {
+      prefetcher_running_ = true;
+      prefetcher_ = new std::thread(&BufferPoolManager::PrefetcherLoop, this);
+    }
+  }
+  prefetch_cv_.notify_one();
+  return true;
+}
+
+void BufferPoolManager::StopPrefetcher() {
+  std::thread *prefetcher;
+  {
+    std::scoped_lock lock{prefetch_latch_};
+    if (prefetcher_ == nullptr) {
+      return;
+    }
+    prefetcher_running_ = false;
+    prefetch_queue_.clear();
+    prefetcher = prefetcher_;
+    prefetcher_ = nullptr;
+  }
+  prefetch_cv_.notify_one();
+  prefetcher->join();
+  delete prefetcher;
+}
+
+void BufferPoolManager::PrefetcherLoop() {
+  std::unique_lock lock{prefetch_latch_};
+  while (true) {
+    prefetch_cv_.wait(lock, [&] { return !prefetcher_running_ || !prefetch_queue_.empty(); });
+    if (!prefetcher_running_) {
+      break;
+    }
+    PrefetchRequest request = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    lock.unlock();
+    // 沿着链表依次预读，读不了（没有可淘汰的frame）或者链表到头了就停下
+    page_id_t page_id = request.page_id_;
+    for (size_t i = 0; i < request.num_pages_ && page_id != INVALID_PAGE_ID; i++) {
+      next_page_fn next_page = i + 1 < request.num_pages_ ? request.next_page_ : nullptr;
+      page_id = PrefetchPageImpl(page_id, next_page, request.strategy_.get());
+    }
+    lock.lock();
+  }
+}
+
+/*
+预读一个page到缓冲池，但不pin它（自己补充的函数）
+读盘时不持有latch_，而是持有page的写锁，并在in_prefetch_中做标记，FetchPage命中这个page时会等在读锁上
+*/
+page_id_t BufferPoolManager::PrefetchPageImpl(page_id_t page_id, next_page_fn next_page,
+                                             BufferAccessStrategy *strategy) {
+  frame_id_t frame_id = -1;
+  Page *page;
+  bool resident;
+  {
+    std::scoped_lock lock{latch_};
+    auto iter = page_table_.find(page_id);
+    resident = iter != page_table_.end();
+    if (!resident) {
+      // 1 page不在缓冲池中，找一个victim frame，在写锁保护下读盘
+      // 排队期间page可能已被删除（比如B+树合并掉的leaf），不能把释放了的page id放进页表：NewPage会重新分配它
+      if (!disk_manager_->IsAllocated(page_id) || !FindVictimPage(&frame_id, strategy)) {
+        return INVALID_PAGE_ID;
+      }
+      page = &pages_[frame_id];
+      page->WLatch();
+      UpdatePage(page, page_id, frame_id);
+      in_prefetch_[frame_id] = true;
+      if (strategy != nullptr) {
+        strategy->SetCurrent(this, frame_id, page_id);
+      }
+    } else {
+      // 2 page已经在缓冲池中，不用读盘，但如果要沿着链表继续预读，需要pin住它来读下一个page id
+      if (next_page == nullptr) {
+        return INVALID_PAGE_ID;
+      }
+      frame_id = iter->second;
+      page = &pages_[frame_id];
+      replacer_->Pin(frame_id);
+      page->pin_count_++;
+    }
+  }
+
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  if (resident) {
+    page->RLatch();
+    next_page_id = next_page(page);
+    page->RUnlatch();
+    UnpinPageImpl(page_id, false);
+    return next_page_id;
+  }
+
+  disk_manager_->ReadPage(page_id, page->data_);
+  if (next_page != nullptr) {
+    next_page_id = next_page(page);
+  }
+  page->WUnlatch();
+
+  // 3 读完了。预读的page放进replacer，除非这期间有人fetch了它（pin_count > 0）或者删除了它
+  std::scoped_lock lock{latch_};
+  in_prefetch_[frame_id] = false;
+  num_prefetches_++;
+  if (page->page_id_ == page_id && page->pin_count_ == 0) {
+    replacer_->Unpin(frame_id);
+  }
+  return next_page_id;
+}
+
+bool BufferPoolManager::SaveResidentPages(const std::string &file_name) {
+  std::vector<page_id_t> page_ids;
+  GetResidentPages(&page_ids);
+  std::ofstream out(file_name, std::ios::trunc);
+  for (page_id_t page_id : page_ids) {
+    out << page_id << '\n';
+  }
+  out.close();
+  return !out.fail();
+}
+
+bool BufferPoolManager::WarmUp(const std::string &file_name) {
+  if (warm_up_ != nullptr) {
+    return false;
+  }
+  std::ifstream in(file_name);
+  if (!in.is_open()) {
+    return false;
+  }
+  // 文件中越靠前的page越热，只取缓冲池放得下的那部分；再按page id排序，连续的page可以一次顺序读进来
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  while (page_ids.size() < GetPoolSize() && in >> page_id) {
+    if (page_id >= 0) {
+      page_ids.push_back(page_id);
+    }
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+  warm_up_ = new std::thread(&BufferPoolManager::WarmUpLoop, this, std::move(page_ids));
+  return true;
+}
+
+void BufferPoolManager::WaitForWarmUp() {
+  if (warm_up_ == nullptr) {
+    return;
+  }
+  warm_up_->join();
+  delete warm_up_;
+  warm_up_ = nullptr;
+}
+
+void BufferPoolManager::GetResidentPages(std::vector<page_id_t> *page_ids) {
+  std::scoped_lock lock{latch_};
+  // 1 pin住的page正在被使用，最热
+  for (const auto &[page_id, frame_id] : page_table_) {
+    if (pages_[frame_id].pin_count_ > 0 || in_prefetch_[frame_id]) {
+      page_ids->push_back(page_id);
+    }
+  }
+  // 2 其余page在replacer中，按淘汰顺序的逆序（最近使用的在前）
+  std::vector<frame_id_t> candidates;
+  replacer_->VictimCandidates(pool_size_, &candidates);
+  for (auto iter = candidates.rbegin(); iter != candidates.rend(); ++iter) {
+    page_ids->push_back(pages_[*iter].page_id_);
+  }
+}
+
+/*
+为预热找一个空闲frame（自己补充的函数）
+和预读一样，page放进page table并持有写锁、在in_prefetch_中做标记，但不pin它
+预热只用free list中的frame，不淘汰任何page：预热开始后被访问的page比上次关机前的热点更有价值
+保存的page在保存后或预热期间可能已被删除，和预读一样不能把释放了的page id放进页表
+*/
+Page *BufferPoolManager::ClaimWarmUpFrame(page_id_t page_id) {
+  std::scoped_lock lock{latch_};
+  if (page_table_.find(page_id) != page_table_.end() || free_list_.empty() || !disk_manager_->IsAllocated(page_id)) {
+    return nullptr;
+  }
+  frame_id_t frame_id = free_list_.front();
+  free_list_.pop_front();
+  Page *page = &pages_[frame_id];
+  page->WLatch();
+  UpdatePage(page, page_id, frame_id);
+  in_prefetch_[frame_id] = true;
+  return page;
+}
+
+void BufferPoolManager::ReleaseWarmUpFrame(page_id_t page_id, Page *page) {
+  page->WUnlatch();
+  // 和预读一样，读完的page放进replacer，除非这期间有人fetch了它或者删除了它
+  std::scoped_lock lock{latch_};
+  auto frame_id = static_cast<frame_id_t>(page - pages_);
+  in_prefetch_[frame_id] = false;
+  num_warm_up_reads_++;
+  if (page->page_id_ == page_id && page->pin_count_ == 0) {
+    replacer_->Unpin(frame_id);
+  }
+}
+
+void BufferPoolManager::WarmUpLoop(const std::vector<page_id_t> &page_ids) {
+  // 最多WARM_UP_QUEUE_DEPTH批page同时在读，每批占一个槽：一段暂存缓冲区
+  // 读盘期间不占frame：否则FetchPage命中被占的frame时要等整批读完；读完后逐个占frame，只锁住拷贝一个page的时间
+  std::unique_ptr<AsyncIOContext> io = disk_manager_->NewAsyncIOContext(WARM_UP_QUEUE_DEPTH);
+  // 暂存缓冲区按PAGE_SIZE对齐，direct I/O模式下异步读要求对齐
+  size_t buffer_size = WARM_UP_QUEUE_DEPTH * WARM_UP_BATCH_PAGES * PAGE_SIZE;
+  char *buffer = static_cast<char *>(::operator new[](buffer_size, std::align_val_t{PAGE_SIZE}));
+  std::vector<page_id_t> first_page_ids(WARM_UP_QUEUE_DEPTH);
+  std::vector<size_t> num_pages(WARM_UP_QUEUE_DEPTH);
+  std::vector<size_t> free_slots;
+  for (size_t slot = 0; slot < WARM_UP_QUEUE_DEPTH; slot++) {
+    free_slots.push_back(slot);
+  }
+  std::vector<AsyncIOCompletion> completions;
+  // 一批读完了，逐个page占frame并拷贝进去，已经在缓冲池中的page（预热期间被fetch了）不用拷贝
+  auto finish = [&](size_t min_completions) {
+    completions.clear();
+    io->Complete(&completions, min_completions);
+    for (const AsyncIOCompletion &completion : completions) {
+      size_t slot = completion.tag_;
+      const char *data = buffer + slot * WARM_UP_BATCH_PAGES * PAGE_SIZE;
+      for (size_t i = 0; i < num_pages[slot]; i++) {
+        page_id_t page_id = first_page_ids[slot] + static_cast<page_id_t>(i);
+        Page *page = ClaimWarmUpFrame(page_id);
+        if (page != nullptr) {
+          memcpy(page->GetData(), data + i * PAGE_SIZE, PAGE_SIZE);
+          ReleaseWarmUpFrame(page_id, page);
+        }
+      }
+      free_slots.push_back(slot);
+    }
+  };
+
+  size_t begin = 0;
+  while (begin < page_ids.size()) {
+    // 1 一批连续的page id，最多WARM_UP_BATCH_PAGES个
+    size_t end = begin + 1;
+    while (end < page_ids.size() && end - begin < static_cast<size_t>(WARM_UP_BATCH_PAGES) &&
+           page_ids[end] == page_ids[end - 1] + 1) {
+      end++;
+    }
+    if (free_slots.empty()) {
+      finish(1);
+    }
+    // 2 一次顺序读进整批page，马上开始读，不等它读完
+    size_t slot = free_slots.back();
+    free_slots.pop_back();
+    first_page_ids[slot] = page_ids[begin];
+    num_pages[slot] = end - begin;
+    io->SubmitRead(page_ids[begin], end - begin, buffer + slot * WARM_UP_BATCH_PAGES * PAGE_SIZE, slot);
+    finish(0);
+    begin = end;
+  }
+  while (io->GetNumPending() > 0) {
+    finish(1);
+  }
+  ::operator delete[](buffer, std::align_val_t{PAGE_SIZE});
+}
+
+void BufferPoolManager::WriteBackVictimCandidates(const BackgroundWriterOptions &options) {
+  // 1 持有latch_，找出即将被淘汰的脏页，标记为正在写回，并提前清除dirty标志
+  // 先清dirty再写：如果写的过程中有人修改了这个page，他Unpin时会重新置dirty，修改不会丢失
+  // 注意这里不pin这些page，以免写回改变它们在replacer中的位置，或者让缓冲池暂时找不到victim
+  std::vector<std::pair<frame_id_t, page_id_t>> to_write;
+  {
+    std::scoped_lock lock{latch_};
+    size_t clean = free_list_.size();
+    if (clean >= options.low_watermark_ || clean >= options.high_watermark_) {
+      return;
+    }
+    std::vector<frame_id_t> candidates;
+    replacer_->VictimCandidates(options.high_watermark_ - clean, &candidates);
+    for (frame_id_t frame_id : candidates) {
+      if (to_write.size() >= options.max_writes_per_round_) {
+        break;
+      }
+      Page *page = &pages_[frame_id];
+      if (page->IsDirty() && !in_write_back_[frame_id]) {
+        in_write_back_[frame_id] = true;
+        page->is_dirty_ = false;
+        to_write.emplace_back(frame_id, page->page_id_);
+      }
+    }
+  }
+
+  // 2 不持有latch_，在page的读锁保护下写盘。替换或删除page的线程会持有写锁（见FetchPageImpl），
+  // 所以读锁下page_id没变就说明data还是选中时的那个page；如果已经被替换，它已经同步写回过了，这里跳过
+  size_t written = 0;
+  for (auto [frame_id, page_id] : to_write) {
+    Page *page = &pages_[frame_id];
+    page->RLatch();
+    if (page->page_id_ == page_id) {
+      disk_manager_->WritePage(page_id, page->data_);
+      written++;
+    }
+    page->RUnlatch();
+  }
+
+  // 3 清除写回标记
+  std::scoped_lock lock{latch_};
+  for (auto [frame_id, page_id] : to_write) {
+    in_write_back_[frame_id] = false;
+  }
+  num_background_write_backs_ += written;
+}
+
 /**
  * Fetch the requested page from the buffer pool.
  * 如果页表中存在page_id（说明该page在缓冲池中），并且pin_count++。
@@ -93,7 +520,15 @@ bool BufferPoolManager::FindVictimPage(frame_id_t *frame_id) {
  * @param page_id id of page to be fetched
  * @return the requested page
  */
-Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
+Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) { return FetchPageWithStrategy(page_id, nullptr); }
+
+/**
+ * Fetch the requested page, reading it through the ring of the strategy if it is not in the buffer pool.
+ * @param page_id id of page to be fetched
+ * @param strategy the buffer access strategy, nullptr to use the whole buffer pool
+ * @return the requested page
+ */
+Page *BufferPoolManager::FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -101,27 +536,43 @@ Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  std::scoped_lock lock{latch_};
+  std::unique_lock lock{latch_};
   auto iter = page_table_.find(page_id);
   // 1 该page在页表中存在（说明该page在缓冲池中）
   if (iter != page_table_.end()) {
     frame_id_t frame_id = iter->second;  // iter是pair类型，其second是page_id对应的frame_id
     Page *page = &pages_[frame_id];      // 由frame_id得到page
+    replacer_->RecordAccess(frame_id);   // 命中也算一次访问（LRU-K需要）
     replacer_->Pin(frame_id);            // pin it
     page->pin_count_++;                  // 更新pin_count
+    num_hits_++;
+    // 预读线程还在读这个page，等它读完（它持有写锁，且读完之前不需要latch_）
+    // 先释放latch_再等：page已经pin住不会被换出，读盘期间其他page的fetch/unpin不受影响
+    if (in_prefetch_[frame_id]) {
+      lock.unlock();
+      page->RLatch();
+      page->RUnlatch();
+    }
     return page;
   }
   // 2 该page在页表中不存在（说明该page不在缓冲池中，而在磁盘中）
   frame_id_t frame_id = -1;
   // 2.1 没有找到victim page
-  if (!FindVictimPage(&frame_id)) {
+  if (!FindVictimPage(&frame_id, strategy)) {
     return nullptr;
   }
   // 2.2 找到victim page，将其data替换为磁盘中该page的内容
   Page *page = &pages_[frame_id];
+  page->WLatch();                       // 等后台写线程写完这个frame（见WriteBackVictimCandidates）
   UpdatePage(page, page_id, frame_id);  // data置为空，dirty页写入磁盘，然后dirty状态置false
   disk_manager_->ReadPage(page_id, page->data_);  // 注意，从磁盘文件database file中page_id的位置读取内容到新page->data
-  replacer_->Pin(frame_id);                       // pin it
+  page->WUnlatch();
+  if (strategy != nullptr) {
+    strategy->SetCurrent(this, frame_id, page_id);
+  }
+  replacer_->RecordAccess(frame_id);
+  replacer_->Pin(frame_id);  // pin it
+  num_misses_++;
   // page->pin_count_++;                          // FIX BUG in project2 checkpoint2（pin count置1也可以）
   page->pin_count_ = 1;
   assert(page->pin_count_ == 1);  // DEBUG
@@ -179,6 +630,10 @@ bool BufferPoolManager::FlushPageImpl(page_id_t page_id) {
   // 2 该page在页表中存在
   frame_id_t frame_id = iter->second;  // iter是pair类型，其second是page_id对应的frame_id
   Page *page = &pages_[frame_id];      // 由frame_id得到page
+  // 预读线程还在读的page是干净的，而且data还不完整，不能写
+  if (in_prefetch_[frame_id]) {
+    return true;
+  }
   // 不管dirty状态如何，都写入磁盘
   disk_manager_->WritePage(page->page_id_, page->data_);
   page->is_dirty_ = false;  // 注意这句话！刷新到磁盘后，dirty要重置false
@@ -193,6 +648,18 @@ bool BufferPoolManager::FlushPageImpl(page_id_t page_id) {
  * @return nullptr if no new pages could be created, otherwise pointer to new page
  */
 Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
+  return NewPageWithStrategy(page_id, nullptr, INVALID_SEGMENT_ID);
+}
+
+/**
+ * Creates a new page in a frame of the ring of the strategy.
+ * @param[out] page_id id of created page
+ * @param strategy the buffer access strategy, nullptr to use the whole buffer pool
+ * @param segment the segment to allocate the page in, INVALID_SEGMENT_ID for none
+ * @return nullptr if no new pages could be created, otherwise pointer to new page
+ */
+Page *BufferPoolManager::NewPageWithStrategy(page_id_t *page_id, BufferAccessStrategy *strategy,
+                                             segment_id_t segment) {
   // 0.   Make sure you call DiskManager::AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
@@ -201,15 +668,32 @@ Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
   std::scoped_lock lock{latch_};
   frame_id_t frame_id = -1;
   // 1 无法得到victim frame_id
-  if (!FindVictimPage(&frame_id)) {
+  if (!FindVictimPage(&frame_id, strategy)) {
     // LOG_INFO("无victim frame_id");
     return nullptr;
   }
   // 2 得到victim frame_id（从free_list或replacer中得到）
-  *page_id = disk_manager_->AllocatePage();  // 分配一个新的page_id（修改了外部参数*page_id）
+  *page_id = AllocatePage(segment);  // 分配一个新的page_id（修改了外部参数*page_id）
+  // 新分配的page id如果还在页表中，说明有frame还留着它被释放前的内容，UpdatePage的emplace不会覆盖页表，要先丢掉它
+  auto stale = page_table_.find(*page_id);
+  if (stale != page_table_.end()) {
+    assert(pages_[stale->second].pin_count_ == 0 && !in_prefetch_[stale->second]);
+    if (stale->second == frame_id) {
+      pages_[frame_id].is_dirty_ = false;  // 旧内容不写回
+      in_write_back_[frame_id] = false;
+    } else {
+      DiscardFrame(stale->second);
+    }
+  }
   Page *page = &pages_[frame_id];            // 由frame_id得到page
   // pages_[frame_id]就是首地址偏移frame_id，左边的*page表示是一个指针指向那个地址，所以右边加&
+  page->WLatch();
   UpdatePage(page, *page_id, frame_id);
+  page->WUnlatch();
+  if (strategy != nullptr) {
+    strategy->SetCurrent(this, frame_id, *page_id);
+  }
+  replacer_->RecordAccess(frame_id);
   replacer_->Pin(frame_id);  // FIX BUG in project2 checkpoint1（这里忘记pin了）
   // page->pin_count_++;     // FIX BUG in project2 checkpoint2（pin count置1也可以）
   page->pin_count_ = 1;
@@ -232,8 +716,9 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
   std::scoped_lock lock{latch_};
   auto iter = page_table_.find(page_id);
-  // 1 该page在页表中不存在
+  // 1 该page在页表中不存在，直接在磁盘上释放
   if (iter == page_table_.end()) {
+    disk_manager_->DeallocatePage(page_id);
     return true;
   }
   // 2 该page在页表中存在
@@ -246,26 +731,130 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   }
 
   // pin_count = 0
-  disk_manager_->DeallocatePage(page_id);  // This does not actually need to do anything for now
-  UpdatePage(page, INVALID_PAGE_ID, frame_id);  // FIX BUG in project2 checkpoint2（此处不要把INVALID_PAGE_ID加到页表）
-  free_list_.push_back(frame_id);               // 加到尾部
+  // 被删除的page不再写回（它的page id可能马上被重新分配），frame从replacer中取出，加到free_list尾部
+  disk_manager_->DeallocatePage(page_id);  // 释放后的page id可以被AllocatePage重新分配
+  DiscardFrame(frame_id);
   return true;
 }
 
+bool BufferPoolManager::DiscardDataFile(file_id_t file_id, bool drop) {
+  std::scoped_lock lock{latch_};
+  if (IsDataFileInUse(file_id)) {
+    return false;
+  }
+  DiscardPages(file_id);
+  if (drop) {
+    disk_manager_->DropDataFile(file_id);
+  } else {
+    disk_manager_->TruncateDataFile(file_id);
+  }
+  return true;
+}
+
+bool BufferPoolManager::IsDataFileInUse(file_id_t file_id) {
+  for (const auto &[page_id, frame_id] : page_table_) {
+    if (DiskManager::GetFileId(page_id) == file_id && (pages_[frame_id].pin_count_ > 0 || in_prefetch_[frame_id])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void BufferPoolManager::DiscardPages(file_id_t file_id) {
+  std::vector<frame_id_t> frame_ids;
+  for (const auto &[page_id, frame_id] : page_table_) {
+    if (DiskManager::GetFileId(page_id) == file_id) {
+      frame_ids.push_back(frame_id);
+    }
+  }
+  for (frame_id_t frame_id : frame_ids) {
+    DiscardFrame(frame_id);
+  }
+}
+
+void BufferPoolManager::DiscardFrame(frame_id_t frame_id) {
+  // page不再写回：清掉dirty，UpdatePage就不会写
+  Page *page = &pages_[frame_id];
+  page->WLatch();
+  page->is_dirty_ = false;
+  in_write_back_[frame_id] = false;
+  UpdatePage(page, INVALID_PAGE_ID, frame_id);
+  page->WUnlatch();
+  replacer_->Pin(frame_id);  // 从replacer中取出，只留在free_list中
+  free_list_.push_back(frame_id);
+}
+
 /**
  * Flushes all the pages in the buffer pool to disk.
  */
 void BufferPoolManager::FlushAllPagesImpl() {
   // You can do it!
-  std::scoped_lock lock{latch_};
+  {
+    std::scoped_lock lock{latch_};
+    std::vector<Page *> pages;
+    CollectDirtyPages(&pages);
+    WritePagesSorted(&pages);
+  }
+  // 所有page都写完之后只sync一次，sync时不需要持有latch_
+  disk_manager_->SyncDataFile();
+}
+
+void BufferPoolManager::CollectDirtyPages(std::vector<Page *> *pages) {
   for (size_t i = 0; i < pool_size_; i++) {
     // FlushPageImpl(i); // 这样写有问题，因为FlushPageImpl传入的参数是page id，其值可以>=pool size
     Page *page = &pages_[i];
-    if (page->page_id_ != INVALID_PAGE_ID && page->IsDirty()) {
-      disk_manager_->WritePage(page->page_id_, page->data_);
-      page->is_dirty_ = false;
+    // 后台写回已经清除了dirty标志但可能还没写完的page也要写，否则之后的sync可能赶在它写盘之前
+    if (page->page_id_ != INVALID_PAGE_ID && (page->IsDirty() || in_write_back_[i])) {
+      pages->push_back(page);
+    }
+  }
+}
+
+void BufferPoolManager::WritePagesSorted(std::vector<Page *> *pages) {
+  // 按page id排序，page id连续的一段page（同一个数据文件中）用一次pwritev写入，而不是按frame的顺序逐个随机写
+  std::sort(pages->begin(), pages->end(), [](Page *a, Page *b) { return a->page_id_ < b->page_id_; });
+  std::vector<const char *> run;
+  for (size_t i = 0; i < pages->size(); i++) {
+    Page *page = (*pages)[i];
+    run.push_back(page->data_);
+    page->is_dirty_ = false;
+    if (i + 1 == pages->size() || (*pages)[i + 1]->page_id_ != page->page_id_ + 1 ||
+        DiskManager::GetFileId((*pages)[i + 1]->page_id_) != DiskManager::GetFileId(page->page_id_)) {
+      disk_manager_->WritePages(page->page_id_ - static_cast<page_id_t>(run.size()) + 1, run.data(), run.size());
+      num_flush_writes_++;
+      run.clear();
     }
   }
+  num_flushed_pages_ += pages->size();
+}
+
+BasicPageGuard BufferPoolManager::FetchPageBasic(page_id_t page_id) {
+  return BasicPageGuard(this, FetchPage(page_id));
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id,
+                                               const std::shared_ptr<BufferAccessStrategy> &strategy) {
+  Page *page = strategy == nullptr ? FetchPage(page_id) : FetchPage(page_id, strategy);
+  if (page != nullptr) {
+    page->RLatch();
+  }
+  return ReadPageGuard(this, page);
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page != nullptr) {
+    page->WLatch();
+  }
+  return WritePageGuard(this, page);
+}
+
+BasicPageGuard BufferPoolManager::NewPageGuarded(page_id_t *page_id, segment_id_t segment) {
+  BasicPageGuard guard(this, segment == INVALID_SEGMENT_ID ? NewPage(page_id)
+                                                           : NewPageWithStrategy(page_id, nullptr, segment));
+  // A new page must reach the disk even if nobody writes into it, or reading it back would fail
+  guard.is_dirty_ = guard.IsValid();
+  return guard;
 }
 
 }  // namespace bustub
@@ -12,18 +12,93 @@
 
 #include "buffer/clock_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_pages_(num_pages),
+      in_replacer_(new std::atomic<bool>[num_pages]),
+      ref_(new std::atomic<bool>[num_pages]) {
+  for (size_t i = 0; i < num_pages_; i++) {
+    in_replacer_[i].store(false, std::memory_order_relaxed);
+    ref_[i].store(false, std::memory_order_relaxed);
+  }
+}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+/**
+ * Sweep the clock hand until it finds a frame in the replacer whose reference bit is clear.
+ * Reference bits of the frames it passes are cleared. Two full rounds are enough to find a victim when nobody
+ * unpins concurrently, since the first round clears every reference bit.
+ * @param[out] frame_id id of frame that was removed
+ * @return true if a victim frame was found, false otherwise
+ */
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock{victim_latch_};
+  for (size_t step = 0; step < 2 * num_pages_ && size_.load() > 0; step++) {
+    size_t frame = clock_hand_;
+    clock_hand_ = (clock_hand_ + 1) % num_pages_;
+    if (!in_replacer_[frame].load()) {
+      continue;
+    }
+    if (ref_[frame].exchange(false)) {
+      continue;  // second chance
+    }
+    // a concurrent Pin may have taken the frame out of the replacer in the meantime
+    bool expected = true;
+    if (in_replacer_[frame].compare_exchange_strong(expected, false)) {
+      size_--;
+      *frame_id = static_cast<frame_id_t>(frame);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Take the frame out of the replacer.
+ * @param frame_id the id of the frame to pin
+ */
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "invalid frame id");
+  if (in_replacer_[frame_id].exchange(false)) {
+    size_--;
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+/**
+ * Put the frame into the replacer and set its reference bit.
+ * @param frame_id the id of the frame to unpin
+ */
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "invalid frame id");
+  ref_[frame_id].store(true);
+  if (!in_replacer_[frame_id].exchange(true)) {
+    size_++;
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+/**
+ * List the frames in the replacer in the order the clock hand reaches them, frames whose reference bit is
+ * already clear first. The hand and the reference bits are left untouched.
+ * @param max_candidates the maximum number of frames to return
+ * @param[out] candidates the frames closest to the eviction end of the replacer
+ */
+void ClockReplacer::VictimCandidates(size_t max_candidates, std::vector<frame_id_t> *candidates) {
+  std::scoped_lock lock{victim_latch_};
+  for (bool want_ref : {false, true}) {
+    for (size_t step = 0; step < num_pages_ && candidates->size() < max_candidates; step++) {
+      size_t frame = (clock_hand_ + step) % num_pages_;
+      if (in_replacer_[frame].load() && ref_[frame].load() == want_ref) {
+        candidates->push_back(static_cast<frame_id_t>(frame));
+      }
+    }
+  }
+}
 
-size_t ClockReplacer::Size() { return 0; }
+/** @return the number of frames in the replacer */
+size_t ClockReplacer::Size() { return size_.load(); }
 
 }  // namespace bustub
@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <new>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames, bool use_huge_pages)
+    : num_frames_(num_frames), mapped_size_(num_frames * PAGE_SIZE), data_(nullptr), pages_(nullptr) {
+  BUSTUB_ASSERT(num_frames > 0, "a frame arena has at least one frame");
+  void *data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  // Explicit huge pages only pay off, and are only worth reserving, once the arena spans at least one of them
+  if (use_huge_pages && mapped_size_ >= HUGE_PAGE_SIZE) {
+    size_t huge_size = (mapped_size_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    data = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      mapped_size_ = huge_size;
+      huge_pages_ = true;
+    }
+  }
+#endif
+  if (data == MAP_FAILED) {
+    // No huge pages reserved (the common case): fall back to regular pages
+    data = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate the frames of the buffer pool");
+    }
+#ifdef MADV_HUGEPAGE
+    if (use_huge_pages) {
+      // Only a hint, it fails harmlessly if transparent huge pages are disabled
+      madvise(data, mapped_size_, MADV_HUGEPAGE);
+    }
+#endif
+  }
+  data_ = static_cast<char *>(data);
+
+  // Anonymous mappings are zeroed, so the pages only need to be pointed at their frame
+  pages_ = static_cast<Page *>(::operator new[](num_frames_ * sizeof(Page), std::align_val_t{alignof(Page)}));
+  for (size_t i = 0; i < num_frames_; i++) {
+    new (&pages_[i]) Page(GetFrameData(static_cast<frame_id_t>(i)));
+  }
+}
+
+FrameArena::~FrameArena() {
+  for (size_t i = 0; i < num_frames_; i++) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_, std::align_val_t{alignof(Page)});
+  munmap(data_, mapped_size_);
+}
+
+}  // namespace bustub
@@ -0,0 +1,130 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : k_(k), frames_(num_pages) {
+  BUSTUB_ASSERT(k > 0, "k must be positive");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+/**
+ * Evict the frame with the largest backward k-distance.
+ * Frames with fewer than k accesses (+inf distance) always go first, the one accessed earliest among them.
+ * @param[out] frame_id id of frame that was removed
+ * @return true if a victim frame was found, false otherwise
+ */
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock{latch_};
+  std::set<EvictionKey> *victim_set = !history_set_.empty() ? &history_set_ : &cache_set_;
+  if (victim_set->empty()) {
+    return false;
+  }
+  *frame_id = victim_set->begin()->second;
+  victim_set->erase(victim_set->begin());
+
+  // the page in the frame is gone, so is its access history
+  FrameHistory &history = frames_[*frame_id];
+  history.accesses_.clear();
+  history.evictable_ = false;
+  return true;
+}
+
+/**
+ * Remove the frame from the replacer. Its access history is kept.
+ * @param frame_id the id of the frame to pin
+ */
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  FrameHistory &history = frames_[frame_id];
+  if (!history.evictable_) {
+    return;
+  }
+  EvictionSetOf(history)->erase({history.accesses_.front(), frame_id});
+  history.evictable_ = false;
+}
+
+/**
+ * Add the frame to the replacer. A frame that was never accessed counts its unpinning as its first access.
+ * @param frame_id the id of the frame to unpin
+ */
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  FrameHistory &history = frames_[frame_id];
+  if (history.evictable_) {
+    return;
+  }
+  if (history.accesses_.empty()) {
+    RecordAccessLocked(frame_id);
+  }
+  history.evictable_ = true;
+  EvictionSetOf(history)->emplace(history.accesses_.front(), frame_id);
+}
+
+/**
+ * Record an access to the frame at the current timestamp.
+ * @param frame_id the id of the accessed frame
+ */
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  std::scoped_lock lock{latch_};
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  RecordAccessLocked(frame_id);
+}
+
+/**
+ * List the next frames Victim would return, in order, without removing them.
+ * @param max_candidates the maximum number of frames to return
+ * @param[out] candidates the frames closest to the eviction end of the replacer
+ */
+void LRUKReplacer::VictimCandidates(size_t max_candidates, std::vector<frame_id_t> *candidates) {
+  std::scoped_lock lock{latch_};
+  for (const std::set<EvictionKey> *eviction_set : {&history_set_, &cache_set_}) {
+    for (auto iter = eviction_set->begin(); iter != eviction_set->end() && candidates->size() < max_candidates;
+         ++iter) {
+      candidates->push_back(iter->second);
+    }
+  }
+}
+
+/** @return the number of evictable frames */
+size_t LRUKReplacer::Size() {
+  std::scoped_lock lock{latch_};
+  return history_set_.size() + cache_set_.size();
+}
+
+void LRUKReplacer::RecordAccessLocked(frame_id_t frame_id) {
+  FrameHistory &history = frames_[frame_id];
+  // an evictable frame changes its position in the eviction order, so take it out and put it back afterwards
+  if (history.evictable_) {
+    EvictionSetOf(history)->erase({history.accesses_.front(), frame_id});
+  }
+  history.accesses_.push_back(current_timestamp_++);
+  if (history.accesses_.size() > k_) {
+    history.accesses_.pop_front();
+  }
+  if (history.evictable_) {
+    EvictionSetOf(history)->emplace(history.accesses_.front(), frame_id);
+  }
+}
+
+std::set<LRUKReplacer::EvictionKey> *LRUKReplacer::EvictionSetOf(const FrameHistory &history) {
+  return history.accesses_.size() < k_ ? &history_set_ : &cache_set_;
+}
+
+}  // namespace bustub
@@ -74,6 +74,18 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   LRUhash.emplace(frame_id, LRUlist.begin());
 }
 
+/**
+ * 按淘汰顺序（从链表尾部开始）列出最多max_candidates个即将被淘汰的frame，不从replacer中删除
+ * @param max_candidates the maximum number of frames to return
+ * @param[out] candidates the frames closest to the eviction end of the replacer
+ */
+void LRUReplacer::VictimCandidates(size_t max_candidates, std::vector<frame_id_t> *candidates) {
+  std::scoped_lock lock{mut};
+  for (auto iter = LRUlist.rbegin(); iter != LRUlist.rend() && candidates->size() < max_candidates; ++iter) {
+    candidates->push_back(*iter);
+  }
+}
+
 /** @return replacer中能够victim的数量 */
 size_t LRUReplacer::Size() { return LRUlist.size(); }
 
@@ -0,0 +1,230 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerType replacer_type, size_t replacer_k)
+    : BufferPoolManager(disk_manager, log_manager, num_instances * pool_size) {
+  // Allocate and create individual BufferPoolManager shards
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.push_back(new BufferPoolManager(pool_size, static_cast<uint32_t>(num_instances),
+                                               static_cast<uint32_t>(i), disk_manager, log_manager, replacer_type,
+                                               replacer_k));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // The warm-up and the prefetcher use the shards, stop them before they are gone
+  WaitForWarmUp();
+  StopPrefetcher();
+  for (BufferPoolManager *instance : instances_) {
+    delete instance;
+  }
+}
+
+BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
+  // Get BufferPoolManager responsible for handling given page id
+  return instances_[static_cast<size_t>(page_id) % instances_.size()];
+}
+
+size_t ParallelBufferPoolManager::GetNumHits() {
+  size_t num_hits = 0;
+  for (BufferPoolManager *instance : instances_) {
+    num_hits += instance->GetNumHits();
+  }
+  return num_hits;
+}
+
+size_t ParallelBufferPoolManager::GetNumMisses() {
+  size_t num_misses = 0;
+  for (BufferPoolManager *instance : instances_) {
+    num_misses += instance->GetNumMisses();
+  }
+  return num_misses;
+}
+
+void ParallelBufferPoolManager::RunBackgroundWriter(const BackgroundWriterOptions &options) {
+  for (BufferPoolManager *instance : instances_) {
+    instance->RunBackgroundWriter(options);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (BufferPoolManager *instance : instances_) {
+    instance->StopBackgroundWriter();
+  }
+}
+
+size_t ParallelBufferPoolManager::GetNumSyncWriteBacks() {
+  size_t num_write_backs = 0;
+  for (BufferPoolManager *instance : instances_) {
+    num_write_backs += instance->GetNumSyncWriteBacks();
+  }
+  return num_write_backs;
+}
+
+size_t ParallelBufferPoolManager::GetNumBackgroundWriteBacks() {
+  size_t num_write_backs = 0;
+  for (BufferPoolManager *instance : instances_) {
+    num_write_backs += instance->GetNumBackgroundWriteBacks();
+  }
+  return num_write_backs;
+}
+
+size_t ParallelBufferPoolManager::GetNumPrefetches() {
+  size_t num_prefetches = 0;
+  for (BufferPoolManager *instance : instances_) {
+    num_prefetches += instance->GetNumPrefetches();
+  }
+  return num_prefetches;
+}
+
+size_t ParallelBufferPoolManager::GetNumWarmUpReads() {
+  size_t num_warm_up_reads = 0;
+  for (BufferPoolManager *instance : instances_) {
+    num_warm_up_reads += instance->GetNumWarmUpReads();
+  }
+  return num_warm_up_reads;
+}
+
+Page *ParallelBufferPoolManager::FetchPageImpl(page_id_t page_id) {
+  // Fetch page for page_id from responsible BufferPoolManager
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) {
+  // The strategy keeps a separate ring for every shard
+  return GetBufferPoolManager(page_id)->FetchPageWithStrategy(page_id, strategy);
+}
+
+bool ParallelBufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
+  // Unpin page_id from responsible BufferPoolManager
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPageImpl(page_id_t page_id) {
+  // Flush page_id from responsible BufferPoolManager
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::NewPageImpl(page_id_t *page_id) {
+  // create new page. We will request page allocation in a round robin manner from the underlying
+  // BufferPoolManagers. If there is no free or evictable frame in a shard we move on to the next one,
+  // and only give up after every shard has been tried once.
+  size_t start = next_instance_.fetch_add(1) % instances_.size();
+  for (size_t i = 0; i < instances_.size(); i++) {
+    Page *page = instances_[(start + i) % instances_.size()]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  *page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+Page *ParallelBufferPoolManager::NewPageWithStrategy(page_id_t *page_id, BufferAccessStrategy *strategy,
+                                                     segment_id_t segment) {
+  size_t start = next_instance_.fetch_add(1) % instances_.size();
+  for (size_t i = 0; i < instances_.size(); i++) {
+    Page *page = instances_[(start + i) % instances_.size()]->NewPageWithStrategy(page_id, strategy, segment);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  *page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+bool ParallelBufferPoolManager::DeletePageImpl(page_id_t page_id) {
+  // Delete page_id from responsible BufferPoolManager
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPagesImpl() {
+  // Flush all pages from all BufferPoolManagers together: the shards hold interleaved page ids, so adjacent pages
+  // can only be written with one call once the dirty pages of every shard are sorted together. The latches are
+  // always taken in shard order, nothing else holds two of them.
+  {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    std::vector<Page *> pages;
+    for (BufferPoolManager *instance : instances_) {
+      locks.emplace_back(instance->latch_);
+      instance->CollectDirtyPages(&pages);
+    }
+    WritePagesSorted(&pages);
+  }
+  disk_manager_->SyncDataFile();
+}
+
+bool ParallelBufferPoolManager::DiscardDataFile(file_id_t file_id, bool drop) {
+  std::vector<std::unique_lock<std::mutex>> locks;
+  for (BufferPoolManager *instance : instances_) {
+    locks.emplace_back(instance->latch_);
+    if (instance->IsDataFileInUse(file_id)) {
+      return false;
+    }
+  }
+  for (BufferPoolManager *instance : instances_) {
+    instance->DiscardPages(file_id);
+  }
+  if (drop) {
+    disk_manager_->DropDataFile(file_id);
+  } else {
+    disk_manager_->TruncateDataFile(file_id);
+  }
+  return true;
+}
+
+page_id_t ParallelBufferPoolManager::PrefetchPageImpl(page_id_t page_id, next_page_fn next_page,
+                                                     BufferAccessStrategy *strategy) {
+  // Read page_id into the responsible BufferPoolManager. The next page of the list may live in another shard, which
+  // is why the prefetcher of the parallel buffer pool walks the list instead of the prefetchers of the shards.
+  return GetBufferPoolManager(page_id)->PrefetchPageImpl(page_id, next_page, strategy);
+}
+
+void ParallelBufferPoolManager::GetResidentPages(std::vector<page_id_t> *page_ids) {
+  // Interleave the shards so that the hottest pages of every shard come first
+  std::vector<std::vector<page_id_t>> shard_page_ids(instances_.size());
+  size_t max_size = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    instances_[i]->GetResidentPages(&shard_page_ids[i]);
+    max_size = std::max(max_size, shard_page_ids[i].size());
+  }
+  for (size_t j = 0; j < max_size; j++) {
+    for (const auto &ids : shard_page_ids) {
+      if (j < ids.size()) {
+        page_ids->push_back(ids[j]);
+      }
+    }
+  }
+}
+
+Page *ParallelBufferPoolManager::ClaimWarmUpFrame(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->ClaimWarmUpFrame(page_id);
+}
+
+void ParallelBufferPoolManager::ReleaseWarmUpFrame(page_id_t page_id, Page *page) {
+  GetBufferPoolManager(page_id)->ReleaseWarmUpFrame(page_id, page);
+}
+
+}  // namespace bustub
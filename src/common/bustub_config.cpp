@@ -0,0 +1,175 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bustub_config.cpp
+//
+// Identification: src/common/bustub_config.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/bustub_config.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+const char *const CONFIG_KEYS[] = {"buffer_pool_size",
+                                   "buffer_pool_instances",
+                                   "log_buffer_size",
+                                   "log_timeout_ms",
+                                   "replacer",
+                                   "replacer_k",
+                                   "background_writer",
+                                   "background_writer_interval_ms",
+                                   "background_writer_low_watermark",
+                                   "background_writer_high_watermark",
+                                   "background_writer_max_writes",
+                                   "warm_up_file",
+                                   "direct_io",
+                                   "sync_policy"};
+
+std::string Trim(const std::string &str) {
+  auto begin = std::find_if_not(str.begin(), str.end(), [](unsigned char c) { return std::isspace(c); });
+  auto end = std::find_if_not(str.rbegin(), str.rend(), [](unsigned char c) { return std::isspace(c); }).base();
+  return begin < end ? std::string(begin, end) : std::string();
+}
+
+size_t ParseSize(const std::string &key, const std::string &value) {
+  size_t pos = 0;
+  uint64_t result = 0;
+  try {
+    result = std::stoull(value, &pos);
+  } catch (const std::exception &e) {
+    pos = 0;
+  }
+  if (pos == 0 || pos != value.size() || value[0] == '-') {
+    throw Exception(ExceptionType::CONVERSION, "invalid value '" + value + "' for setting " + key);
+  }
+  return result;
+}
+
+size_t ParsePositiveSize(const std::string &key, const std::string &value) {
+  size_t result = ParseSize(key, value);
+  if (result == 0) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "setting " + key + " must be at least 1");
+  }
+  return result;
+}
+
+}  // namespace
+
+size_t BustubConfig::GetLogBufferSize() const {
+  if (log_buffer_size_ != 0) {
+    return log_buffer_size_;
+  }
+  return (buffer_pool_size_ * buffer_pool_instances_ + 1) * PAGE_SIZE;
+}
+
+void BustubConfig::Set(const std::string &key, const std::string &value) {
+  if (key == "buffer_pool_size") {
+    buffer_pool_size_ = ParsePositiveSize(key, value);
+  } else if (key == "buffer_pool_instances") {
+    buffer_pool_instances_ = ParsePositiveSize(key, value);
+  } else if (key == "log_buffer_size") {
+    log_buffer_size_ = ParseSize(key, value);
+  } else if (key == "log_timeout_ms") {
+    log_timeout_ = std::chrono::milliseconds(ParseSize(key, value));
+  } else if (key == "replacer") {
+    if (value == "lru") {
+      replacer_type_ = ReplacerType::LRU;
+    } else if (value == "lru_k") {
+      replacer_type_ = ReplacerType::LRU_K;
+    } else if (value == "clock") {
+      replacer_type_ = ReplacerType::CLOCK;
+    } else {
+      throw Exception(ExceptionType::CONVERSION, "invalid value '" + value + "' for setting " + key);
+    }
+  } else if (key == "replacer_k") {
+    replacer_k_ = ParsePositiveSize(key, value);
+  } else if (key == "background_writer") {
+    if (value == "on") {
+      background_writer_ = true;
+    } else if (value == "off") {
+      background_writer_ = false;
+    } else {
+      throw Exception(ExceptionType::CONVERSION, "invalid value '" + value + "' for setting " + key);
+    }
+  } else if (key == "background_writer_interval_ms") {
+    background_writer_options_.interval_ = std::chrono::milliseconds(ParseSize(key, value));
+  } else if (key == "background_writer_low_watermark") {
+    background_writer_options_.low_watermark_ = ParseSize(key, value);
+  } else if (key == "background_writer_high_watermark") {
+    background_writer_options_.high_watermark_ = ParseSize(key, value);
+  } else if (key == "background_writer_max_writes") {
+    background_writer_options_.max_writes_per_round_ = ParseSize(key, value);
+  } else if (key == "warm_up_file") {
+    warm_up_file_ = value;
+  } else if (key == "direct_io") {
+    if (value == "on") {
+      direct_io_ = true;
+    } else if (value == "off") {
+      direct_io_ = false;
+    } else {
+      throw Exception(ExceptionType::CONVERSION, "invalid value '" + value + "' for setting " + key);
+    }
+  } else if (key == "sync_policy") {
+    if (value == "per_write") {
+      sync_policy_ = SyncPolicy::PER_WRITE;
+    } else if (value == "group") {
+      sync_policy_ = SyncPolicy::GROUP;
+    } else if (value == "on_checkpoint") {
+      sync_policy_ = SyncPolicy::ON_CHECKPOINT;
+    } else {
+      throw Exception(ExceptionType::CONVERSION, "invalid value '" + value + "' for setting " + key);
+    }
+  } else {
+    throw Exception(ExceptionType::INVALID, "unknown setting " + key);
+  }
+}
+
+BustubConfig BustubConfig::FromFile(const std::string &file_name) {
+  std::ifstream file(file_name);
+  if (!file.is_open()) {
+    throw Exception(ExceptionType::INVALID, "cannot open config file " + file_name);
+  }
+  BustubConfig config;
+  std::string line;
+  while (std::getline(file, line)) {
+    line = Trim(line.substr(0, line.find('#')));
+    if (line.empty()) {
+      continue;
+    }
+    auto pos = line.find('=');
+    if (pos == std::string::npos) {
+      throw Exception(ExceptionType::INVALID, "malformed config line '" + line + "' in " + file_name);
+    }
+    config.Set(Trim(line.substr(0, pos)), Trim(line.substr(pos + 1)));
+  }
+  return config;
+}
+
+BustubConfig BustubConfig::FromEnvironment() { return FromEnvironment(BustubConfig()); }
+
+BustubConfig BustubConfig::FromEnvironment(BustubConfig config) {
+  for (const char *key : CONFIG_KEYS) {
+    std::string name = "BUSTUB_" + std::string(key);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::toupper(c); });
+    const char *value = std::getenv(name.c_str());
+    if (value != nullptr) {
+      config.Set(key, Trim(value));
+    }
+  }
+  return config;
+}
+
+}  // namespace bustub
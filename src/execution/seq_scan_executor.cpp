@@ -1,22 +1,53 @@
-//===----------------------------------------------------------------------===//
-//
-//                         BusTub
-//
-// seq_scan_executor.cpp
-//
-// Identification: src/execution/seq_scan_executor.cpp
-//
-// Copyright (c) 2015-19, Carnegie Mellon University Database Group
-//
-//===----------------------------------------------------------------------===//
-#include "execution/executors/seq_scan_executor.h"
-
-namespace bustub {
-
-SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : AbstractExecutor(exec_ctx) {}
-
-void SeqScanExecutor::Init() {}
-
-bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) { return false; }
-
-}  // namespace bustub
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// seq_scan_executor.cpp
+//
+// Identification: src/execution/seq_scan_executor.cpp
+//
+// Copyright (c) 2015-19, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/seq_scan_executor.h"
+
+#include <memory>
+#include <vector>
+
+namespace bustub {
+
+SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan)
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void SeqScanExecutor::Init() {
+  table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
+  // A sequential scan reads every page of the table once, read it through a ring of frames so that it does not evict
+  // the pages other queries are working on
+  auto strategy = std::make_shared<BufferAccessStrategy>();
+  iter_ = std::make_unique<TableIterator>(table_info_->table_->Begin(exec_ctx_->GetTransaction(), strategy));
+}
+
+bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
+  const Schema *output_schema = plan_->OutputSchema();
+  while (*iter_ != table_info_->table_->End()) {
+    const Tuple &cur = **iter_;
+    bool matched = plan_->GetPredicate() == nullptr ||
+                   plan_->GetPredicate()->Evaluate(&cur, &table_info_->schema_).GetAs<bool>();
+    if (matched) {
+      std::vector<Value> values;
+      values.reserve(output_schema->GetColumnCount());
+      for (const Column &column : output_schema->GetColumns()) {
+        values.push_back(column.GetExpr()->Evaluate(&cur, &table_info_->schema_));
+      }
+      *tuple = Tuple(values, output_schema);
+      *rid = cur.GetRid();
+    }
+    ++(*iter_);
+    if (matched) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace bustub
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * BufferAccessStrategy lets one bulk operation, e.g. a sequential scan, read its pages through a small ring of frames
+ * instead of the whole buffer pool. A page missed through the strategy is read into the frame the ring used
+ * ring_size misses ago, as long as that frame is unpinned and still holds the page the ring put there. Otherwise the
+ * buffer pool picks a victim as usual, and that frame joins the ring. So a scan over a table larger than the pool only
+ * ever evicts ring_size pages of everybody else.
+ *
+ * A strategy is used by one scan at a time (plus the prefetcher working for it). Pages that are already in the buffer
+ * pool are not moved into the ring.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManager;
+
+ public:
+  /**
+   * Creates a new BufferAccessStrategy.
+   * @param ring_size the number of frames in the ring of each buffer pool (shard) the strategy is used with
+   */
+  explicit BufferAccessStrategy(size_t ring_size = BUFFER_RING_SIZE);
+
+  /** @return the number of frames in the ring */
+  size_t GetRingSize() const { return ring_size_; }
+
+ private:
+  /** The frames one buffer pool lent to the strategy, with the page the strategy read into each of them. */
+  struct Ring {
+    std::vector<std::pair<frame_id_t, page_id_t>> slots_;
+    size_t current_ = 0;
+  };
+
+  /**
+   * Move on to the next slot of the ring of the buffer pool.
+   * @param bpm the buffer pool
+   * @param[out] frame_id the frame in the slot
+   * @param[out] page_id the page the strategy read into that frame
+   * @return false if the slot is still empty
+   */
+  bool Advance(const BufferPoolManager *bpm, frame_id_t *frame_id, page_id_t *page_id);
+
+  /**
+   * Record that the strategy read a page into a frame of the buffer pool, in the current slot of its ring.
+   * @param bpm the buffer pool
+   * @param frame_id the frame
+   * @param page_id the page
+   */
+  void SetCurrent(const BufferPoolManager *bpm, frame_id_t frame_id, page_id_t page_id);
+
+  size_t ring_size_;
+  std::unordered_map<const BufferPoolManager *, Ring> rings_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
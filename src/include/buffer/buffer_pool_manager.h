@@ -12,14 +12,27 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 /* PROJECT #1 - BUFFER POOL | TASK #2 - BUFFER POOL MANAGER
 您需要在系统中实现BufferPoolManager。
@@ -41,15 +54,35 @@ BufferPoolManager也可以在明确指示这样做或当它需要驱逐页面为
 
 namespace bustub {
 
+/**
+ * Settings of the background writer, see BufferPoolManager::RunBackgroundWriter.
+ * The writer keeps the frames at the eviction end of the replacer clean, so that a cache miss can usually reuse a
+ * frame without writing someone else's dirty page first.
+ */
+struct BackgroundWriterOptions {
+  /** The writer wakes up at least this often, and also whenever a miss had to write back a dirty victim. */
+  std::chrono::milliseconds interval_{std::chrono::milliseconds(10)};
+  /** The writer does nothing while at least this many of the next victims (free frames included) are clean. */
+  size_t low_watermark_{8};
+  /** Once it starts, the writer cleans victims until this many of the next victims are clean. */
+  size_t high_watermark_{16};
+  /** Upper bound on the number of pages written per wake-up, which bounds the write rate. */
+  size_t max_writes_per_round_{16};
+};
+
 /**
  * 主要数据结构是一个page数组(pages_)，frame_id作为其下标。
  * 还有一个哈希表(page_table_)，表示从page_id到frame_id的映射。
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
 class BufferPoolManager {
+  friend class ParallelBufferPoolManager;
+
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Reads the id of the page that follows the given page in a linked list of pages, e.g. TablePage::GetNextPageId. */
+  using next_page_fn = page_id_t (*)(Page *page);
 
   /**
    * Creates a new BufferPoolManager.
@@ -59,10 +92,36 @@ class BufferPoolManager {
    */
   BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
 
+  /**
+   * Creates a new BufferPoolManager with the given replacement policy.
+   * @param pool_size the size of the buffer pool
+   * @param disk_manager the disk manager
+   * @param replacer_type the replacement policy used to pick victim frames
+   * @param replacer_k the lookback window, only used by ReplacerType::LRU_K
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   */
+  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, ReplacerType replacer_type,
+                    size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr);
+
+  /**
+   * Creates a new BufferPoolManager that is one shard of a ParallelBufferPoolManager.
+   * The shard only ever allocates page ids p with p % num_instances == instance_index.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of shards in the parallel buffer pool
+   * @param instance_index index of this shard in the parallel buffer pool
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   * @param replacer_k the lookback window, only used by ReplacerType::LRU_K
+   */
+  BufferPoolManager(size_t pool_size, uint32_t num_instances, uint32_t instance_index, DiskManager *disk_manager,
+                    LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                    size_t replacer_k = LRUK_REPLACER_K);
+
   /**
    * Destroys an existing BufferPoolManager.
    */
-  ~BufferPoolManager();
+  virtual ~BufferPoolManager();
 
   /** Grading function. Do not modify! */
   Page *FetchPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
@@ -111,13 +170,170 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch a page through a buffer access strategy. If the page is not in the buffer pool, it is read into a frame of
+   * the ring of the strategy, so that a bulk scan does not evict the pages everybody else is using.
+   * @param page_id id of page to be fetched
+   * @param strategy the buffer access strategy of the scan, nullptr to use the whole buffer pool
+   * @return the requested page, nullptr if it could not be fetched
+   */
+  Page *FetchPage(page_id_t page_id, const std::shared_ptr<BufferAccessStrategy> &strategy) {
+    return FetchPageWithStrategy(page_id, strategy.get());
+  }
+
+  /**
+   * Create a new page in a frame of the ring of a buffer access strategy, e.g. for a bulk load.
+   * @param[out] page_id id of created page
+   * @param strategy the buffer access strategy, nullptr to use the whole buffer pool
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPage(page_id_t *page_id, const std::shared_ptr<BufferAccessStrategy> &strategy) {
+    return NewPageWithStrategy(page_id, strategy.get(), INVALID_SEGMENT_ID);
+  }
+
+  /** @return the id of a new segment in a data file, see DiskManager::CreateSegment */
+  segment_id_t CreateSegment(file_id_t file_id = 0) { return disk_manager_->CreateSegment(file_id); }
+
+  /** @return the id of a new data file, see DiskManager::CreateDataFile */
+  file_id_t CreateDataFile(const std::string &file_name = "", bool compressed = false) {
+    return disk_manager_->CreateDataFile(file_name, compressed);
+  }
+
+  /**
+   * Drop a data file, e.g. of a dropped table: its pages are discarded from the buffer pool without being written,
+   * and the file is unlinked, see DiskManager::DropDataFile.
+   * @param file_id id of the data file, not 0
+   * @return false if a page of the file is pinned, the file is not dropped then
+   */
+  bool DropDataFile(file_id_t file_id) { return DiscardDataFile(file_id, true); }
+
+  /**
+   * Truncate a data file, e.g. of a truncated table: its pages are discarded from the buffer pool without being
+   * written, and deallocated, see DiskManager::TruncateDataFile.
+   * @param file_id id of the data file
+   * @return false if a page of the file is pinned, the file is not truncated then
+   */
+  bool TruncateDataFile(file_id_t file_id) { return DiscardDataFile(file_id, false); }
+
+  /**
+   * Fetch a page and guard its pin, see BasicPageGuard.
+   * @param page_id id of page to be fetched
+   * @return a guard of the requested page, empty if it could not be fetched
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id);
+
+  /**
+   * Fetch a page and latch it for reading, the guard releases the latch and the pin.
+   * @param page_id id of page to be fetched
+   * @param strategy the buffer access strategy of a bulk scan, nullptr to use the whole buffer pool
+   * @return a guard of the requested page, empty if it could not be fetched
+   */
+  ReadPageGuard FetchPageRead(page_id_t page_id, const std::shared_ptr<BufferAccessStrategy> &strategy = nullptr);
+
+  /**
+   * Fetch a page and latch it for writing, the guard releases the latch and the pin.
+   * @param page_id id of page to be fetched
+   * @return a guard of the requested page, empty if it could not be fetched
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+
+  /**
+   * Create a new page and guard its pin. The new page is dirty, whether or not it is written.
+   * @param[out] page_id id of created page
+   * @param segment the segment to allocate the page in, INVALID_SEGMENT_ID for none
+   * @return a guard of the new page, empty if no new pages could be created
+   */
+  BasicPageGuard NewPageGuarded(page_id_t *page_id, segment_id_t segment = INVALID_SEGMENT_ID);
+
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
   /** @return size of the buffer pool */
   size_t GetPoolSize() { return pool_size_; }
 
+  /** @return the number of FetchPage calls that found the page in the buffer pool */
+  virtual size_t GetNumHits() { return num_hits_; }
+
+  /** @return the number of FetchPage calls that had to read the page from disk */
+  virtual size_t GetNumMisses() { return num_misses_; }
+
+  /**
+   * Start the background writer thread. It periodically writes back dirty, unpinned pages that are close to being
+   * evicted, so that misses find clean victims. Does nothing if the writer is already running.
+   * @param options rate and watermarks of the writer
+   */
+  virtual void RunBackgroundWriter(const BackgroundWriterOptions &options = BackgroundWriterOptions());
+
+  /**
+   * Stop and join the background writer thread. Does nothing if the writer is not running.
+   */
+  virtual void StopBackgroundWriter();
+
+  /** @return the number of dirty victims written back synchronously by NewPage/FetchPage/DeletePage */
+  virtual size_t GetNumSyncWriteBacks() { return num_sync_write_backs_; }
+
+  /** @return the number of dirty pages written back by the background writer */
+  virtual size_t GetNumBackgroundWriteBacks() { return num_background_write_backs_; }
+
+  /** @return the number of pages written by FlushAllPages */
+  size_t GetNumFlushedPages() { return num_flushed_pages_; }
+
+  /**
+   * FlushAllPages writes runs of adjacent pages with one vectored write, the difference with GetNumFlushedPages is
+   * the number of write calls it saved.
+   * @return the number of writes issued by FlushAllPages
+   */
+  size_t GetNumFlushWrites() { return num_flush_writes_; }
+
+  /**
+   * Asynchronously read a page into the buffer pool without pinning it, so that a later FetchPage is a hit.
+   * The request is handed to a prefetcher thread, which is started on first use. Optionally the prefetcher also
+   * follows the linked list the page belongs to, so that a scan can ask for the next few pages it will visit.
+   * @param page_id id of the first page to be prefetched
+   * @param next_page if not nullptr, used to find the page that follows each prefetched page
+   * @param num_pages number of pages to prefetch along the list, starting with page_id
+   * @param strategy if not nullptr, the pages are read into the ring of this buffer access strategy
+   * @return false if the request was dropped because the prefetch queue is full
+   */
+  bool PrefetchPage(page_id_t page_id, next_page_fn next_page = nullptr, size_t num_pages = 1,
+                    const std::shared_ptr<BufferAccessStrategy> &strategy = nullptr);
+
+  /** @return the number of pages read from disk by the prefetcher */
+  virtual size_t GetNumPrefetches() { return num_prefetches_; }
+
+  /**
+   * Write the ids of the pages in the buffer pool to a file, hottest first: the pinned pages, then the other pages in
+   * reverse eviction order. Call it at shutdown, or periodically, so that WarmUp can reload the pages after a restart.
+   * @param file_name the file to write, overwritten if it exists
+   * @return false if the file could not be written
+   */
+  bool SaveResidentPages(const std::string &file_name);
+
+  /**
+   * Asynchronously reload the pages listed in a file written by SaveResidentPages, on a warm-up thread.
+   * Only the hottest pages that fit in the buffer pool are reloaded, in page id order, so that runs of consecutive
+   * pages are read with one sequential read. The warm-up only fills free frames: it never evicts a page, and skips the
+   * pages that were fetched in the meantime.
+   * @param file_name the file written by SaveResidentPages
+   * @return false if the file could not be read, or a warm-up was started and not waited for yet
+   */
+  bool WarmUp(const std::string &file_name);
+
+  /** Wait for the warm-up thread to finish. Does nothing if no warm-up was started. */
+  void WaitForWarmUp();
+
+  /** @return the number of pages read from disk by the warm-up */
+  virtual size_t GetNumWarmUpReads() { return num_warm_up_reads_; }
+
  protected:
+  /**
+   * Creates a BufferPoolManager that owns no frames of its own. Used by subclasses that delegate to other pools.
+   * @param pool_size the total number of frames reachable through this buffer pool
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   */
+  BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager, size_t pool_size);
+
   /**
    * Grading function. Do not modify!
    * Invokes the callback function if it is not null.
@@ -136,7 +352,15 @@ class BufferPoolManager {
    * @param page_id id of page to be fetched
    * @return the requested page
    */
-  Page *FetchPageImpl(page_id_t page_id);
+  virtual Page *FetchPageImpl(page_id_t page_id);
+
+  /**
+   * Fetch the requested page, reading it through the ring of the strategy if it is not in the buffer pool.
+   * @param page_id id of page to be fetched
+   * @param strategy the buffer access strategy, nullptr to use the whole buffer pool
+   * @return the requested page
+   */
+  virtual Page *FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy);
 
   /**
    * Unpin the target page from the buffer pool.
@@ -144,37 +368,133 @@ class BufferPoolManager {
    * @param is_dirty true if the page should be marked as dirty, false otherwise
    * @return false if the page pin count is <= 0 before this call, true otherwise
    */
-  bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
+  virtual bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
 
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
    */
-  bool FlushPageImpl(page_id_t page_id);
+  virtual bool FlushPageImpl(page_id_t page_id);
 
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  Page *NewPageImpl(page_id_t *page_id);
+  virtual Page *NewPageImpl(page_id_t *page_id);
+
+  /**
+   * Creates a new page in a frame of the ring of the strategy.
+   * @param[out] page_id id of created page
+   * @param strategy the buffer access strategy, nullptr to use the whole buffer pool
+   * @param segment the segment to allocate the page in, INVALID_SEGMENT_ID for none
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPageWithStrategy(page_id_t *page_id, BufferAccessStrategy *strategy, segment_id_t segment);
 
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
-  bool DeletePageImpl(page_id_t page_id);
+  virtual bool DeletePageImpl(page_id_t page_id);
 
   /**
    * Flushes all the pages in the buffer pool to disk.
    */
-  void FlushAllPagesImpl();
+  virtual void FlushAllPagesImpl();
+
+  /**
+   * Discard the pages of a data file from the buffer pool, then drop or truncate the file.
+   * @param file_id id of the data file
+   * @param drop true to drop the file, false to truncate it
+   * @return false if a page of the file is pinned or being prefetched, nothing is discarded then
+   */
+  virtual bool DiscardDataFile(file_id_t file_id, bool drop);
 
-  bool FindVictimPage(frame_id_t *frame_id);
+  /** @return true if a page of the data file is pinned or being prefetched, latch_ must be held */
+  bool IsDataFileInUse(file_id_t file_id);
+
+  /** Return the frames of the pages of the data file to the free list without writing them, latch_ must be held. */
+  void DiscardPages(file_id_t file_id);
+
+  /** Return the frame to the free list without writing its page, latch_ must be held and the page not pinned. */
+  void DiscardFrame(frame_id_t frame_id);
+
+  bool FindVictimPage(frame_id_t *frame_id, BufferAccessStrategy *strategy = nullptr);
   void UpdatePage(Page *page, page_id_t new_page_id, frame_id_t new_frame_id);
 
+  /**
+   * Append the dirty pages in the buffer pool, and the pages the background writer owes a write, to pages, latch_ must
+   * be held.
+   */
+  void CollectDirtyPages(std::vector<Page *> *pages);
+
+  /**
+   * Write pages in page id order, each run of adjacent pages of a data file with one vectored write, and mark them
+   * clean. Does not sync the data files. The latches of the buffer pools that hold the pages must be held.
+   * @param pages the pages to write, sorted by the call
+   */
+  void WritePagesSorted(std::vector<Page *> *pages);
+
+  /**
+   * Allocates a page id on disk. A shard of a parallel buffer pool hands out ids congruent to its instance index.
+   * @param segment the segment to allocate the page in, INVALID_SEGMENT_ID for none
+   * @return the id of the allocated page
+   */
+  page_id_t AllocatePage(segment_id_t segment);
+
+  /**
+   * Read a page into a frame without pinning it, on behalf of the prefetcher. Does not read the page if it is already
+   * in the buffer pool or if no frame can be evicted.
+   * @param page_id id of page to be prefetched
+   * @param next_page if not nullptr, used to find the page that follows page_id
+   * @param strategy if not nullptr, the page is read into the ring of this buffer access strategy
+   * @return the page that follows page_id, INVALID_PAGE_ID if there is none or it is unknown
+   */
+  virtual page_id_t PrefetchPageImpl(page_id_t page_id, next_page_fn next_page, BufferAccessStrategy *strategy);
+
+  /**
+   * Append the ids of the pages in the buffer pool to page_ids, hottest first.
+   * @param[out] page_ids the ids of the resident pages
+   */
+  virtual void GetResidentPages(std::vector<page_id_t> *page_ids);
+
+  /**
+   * Claim a free frame for a page that the warm-up has read, like the prefetcher does: the page is put in the page
+   * table, write latched and flagged in in_prefetch_, but not pinned.
+   * @param page_id id of the page that was read
+   * @return the page to copy into, nullptr if the page is already in the buffer pool or there is no free frame
+   */
+  virtual Page *ClaimWarmUpFrame(page_id_t page_id);
+
+  /**
+   * Hand a frame claimed by ClaimWarmUpFrame back once the page has been read into it, the page becomes evictable.
+   * @param page_id id of the page that was read
+   * @param page the page returned by ClaimWarmUpFrame
+   */
+  virtual void ReleaseWarmUpFrame(page_id_t page_id, Page *page);
+
+  /** Main loop of the warm-up thread, page_ids are sorted. */
+  void WarmUpLoop(const std::vector<page_id_t> &page_ids);
+
+  /** Stop and join the prefetcher thread, dropping the requests it has not started yet. */
+  void StopPrefetcher();
+
+  /** Main loop of the prefetcher thread. */
+  void PrefetcherLoop();
+
+  /** Main loop of the background writer thread. */
+  void BackgroundWriterLoop(BackgroundWriterOptions options);
+
+  /**
+   * Write back dirty pages among the next victims of the replacer, as configured by options.
+   * latch_ is not held during I/O. The pages are not pinned either: whoever replaces a page holds its write latch,
+   * and treats a page flagged in in_write_back_ as dirty, so the writer can simply skip pages that were replaced.
+   */
+  void WriteBackVictimCandidates(const BackgroundWriterOptions &options);
+
   // 这里需要理解：pages就是缓冲区当前存的pool_size个page，可以用frame_id作为下标取出缓冲区的单个page
   // page_id表示由diskmanager分配得到的page编号，目前是id自增策略，它的大小完全有可能超过pool_size
   // frame_id表示缓冲区中的每页占的位置，它的范围只能是[0,pool_size)
@@ -182,6 +502,12 @@ class BufferPoolManager {
 
   /** Number of pages in the buffer pool. */
   size_t pool_size_;
+  /** Number of shards in the parallel buffer pool this instance belongs to (1 if not sharded). */
+  const uint32_t num_instances_ = 1;
+  /** Index of this shard in the parallel buffer pool. */
+  const uint32_t instance_index_ = 0;
+  /** Memory of the frames, owns pages_ and their data. */
+  FrameArena *frame_arena_;
   /** Array of buffer pool pages. 大小为pool_size_，下标为[0,pool_size_) */
   Page *pages_;
   /** Pointer to the disk manager. */
@@ -196,5 +522,51 @@ class BufferPoolManager {
   std::list<frame_id_t> free_list_;
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   std::mutex latch_;
+  /** FetchPage hit/miss statistics, protected by latch_. */
+  size_t num_hits_ = 0;
+  size_t num_misses_ = 0;
+  /** Write-back statistics, protected by latch_. */
+  size_t num_sync_write_backs_ = 0;
+  size_t num_background_write_backs_ = 0;
+  /** FlushAllPages statistics, protected by latch_ (by the latches of all the shards for a parallel buffer pool). */
+  size_t num_flushed_pages_ = 0;
+  size_t num_flush_writes_ = 0;
+
+  /** in_write_back_[i] is true while the background writer owes frame i a write to disk, protected by latch_. */
+  std::vector<bool> in_write_back_;
+  /**
+   * in_prefetch_[i] is true while the prefetcher or the warm-up reads a page into frame i, protected by latch_. The
+   * reader holds the write latch of the page meanwhile, so FetchPage waits for the read by taking the read latch.
+   */
+  std::vector<bool> in_prefetch_;
+  /** Number of pages read by the prefetcher, protected by latch_. */
+  size_t num_prefetches_ = 0;
+
+  /** A PrefetchPage call waiting for the prefetcher. */
+  struct PrefetchRequest {
+    page_id_t page_id_;
+    next_page_fn next_page_;
+    size_t num_pages_;
+    std::shared_ptr<BufferAccessStrategy> strategy_;
+  };
+  /** Prefetcher thread, nullptr if it has not been started. */
+  std::thread *prefetcher_ = nullptr;
+  /** Protects prefetch_queue_ and prefetcher_running_, and is used with prefetch_cv_ to wake up the prefetcher. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  std::deque<PrefetchRequest> prefetch_queue_;
+  bool prefetcher_running_ = false;
+
+  /** Warm-up thread, nullptr if no warm-up was started. */
+  std::thread *warm_up_ = nullptr;
+  /** Number of pages read by the warm-up, protected by latch_. */
+  size_t num_warm_up_reads_ = 0;
+
+  /** Background writer thread, nullptr if it is not running. */
+  std::thread *background_writer_ = nullptr;
+  /** Protects writer_running_ and is used with writer_cv_ to wake up the writer. */
+  std::mutex writer_latch_;
+  std::condition_variable writer_cv_;
+  bool writer_running_ = false;
 };
 }  // namespace bustub
@@ -12,7 +12,8 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <vector>
 
@@ -23,6 +24,10 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Every frame owns two atomic flags: whether it is in the replacer (unpinned) and its reference bit.
+ * Pin and Unpin are a couple of atomic operations on those flags and never take a lock.
+ * Only Victim, which moves the clock hand, is serialized by a latch.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -43,10 +48,23 @@ class ClockReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  void VictimCandidates(size_t max_candidates, std::vector<frame_id_t> *candidates) override;
+
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
+  /** Number of frames the clock covers. */
+  size_t num_pages_;
+  /** in_replacer_[i] is true iff frame i is unpinned and may be victimized. */
+  std::unique_ptr<std::atomic<bool>[]> in_replacer_;
+  /** ref_[i] is the reference bit of frame i, set on Unpin and cleared when the clock hand passes. */
+  std::unique_ptr<std::atomic<bool>[]> ref_;
+  /** Number of frames in the replacer. */
+  std::atomic<size_t> size_{0};
+  /** Position of the clock hand, protected by victim_latch_. */
+  size_t clock_hand_{0};
+  /** Serializes Victim calls. */
+  std::mutex victim_latch_;
 };
 
 }  // namespace bustub
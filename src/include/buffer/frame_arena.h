@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * FrameArena is the memory of a buffer pool. The data of all frames is a single page-aligned allocation, separate
+ * from the array of Page objects that holds the book-keeping of every frame, so that scanning the metadata does not
+ * drag page data through the cache and the data can be read and written with O_DIRECT.
+ *
+ * The data is backed by huge pages when possible: explicit huge pages (MAP_HUGETLB) if the system has some reserved,
+ * otherwise regular pages with a transparent huge page hint.
+ */
+class FrameArena {
+ public:
+  /**
+   * Allocates the frames of a buffer pool, all zeroed.
+   * @param num_frames the number of frames
+   * @param use_huge_pages false to never ask for huge pages
+   * @throws Exception if the memory cannot be allocated
+   */
+  explicit FrameArena(size_t num_frames, bool use_huge_pages = true);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the array of num_frames pages, the page of frame i uses the data of frame i */
+  Page *GetPages() { return pages_; }
+
+  /** @return the data of the given frame, PAGE_SIZE bytes aligned to PAGE_SIZE */
+  char *GetFrameData(frame_id_t frame_id) { return data_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  /** @return the number of frames */
+  size_t GetNumFrames() const { return num_frames_; }
+
+  /** @return true if the data is backed by explicit huge pages */
+  bool UsesHugePages() const { return huge_pages_; }
+
+ private:
+  /** Size of an explicit huge page, the arena is rounded up to a multiple of it when it uses them. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  size_t num_frames_;
+  /** Size of the mapping of data_ in byte. */
+  size_t mapped_size_;
+  char *data_;
+  Page *pages_;
+  bool huge_pages_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-k replacement policy.
+ *
+ * The LRU-k algorithm evicts the frame whose backward k-distance is maximum over all evictable frames. Backward
+ * k-distance is the difference in time between the current timestamp and the timestamp of the kth previous access.
+ *
+ * A frame with fewer than k historical accesses has +inf backward k-distance. When multiple frames have +inf
+ * backward k-distance, the one with the earliest first access is evicted (classical LRU among them). This is what
+ * keeps a one-pass sequential scan from pushing frequently used pages out of the buffer pool.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of historical accesses tracked per frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void VictimCandidates(size_t max_candidates, std::vector<frame_id_t> *candidates) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  /** Access history of one frame. */
+  struct FrameHistory {
+    /** Timestamps of the last (at most k) accesses, oldest first. */
+    std::list<size_t> accesses_;
+    /** True if the frame is currently in the replacer, i.e. unpinned. */
+    bool evictable_{false};
+  };
+
+  /** Ordering key of an evictable frame: (timestamp of its oldest tracked access, frame id). */
+  using EvictionKey = std::pair<size_t, frame_id_t>;
+
+  /** Append the current timestamp to the history of a frame. Caller must hold latch_. */
+  void RecordAccessLocked(frame_id_t frame_id);
+
+  /** @return the set the evictable frame currently belongs to. Caller must hold latch_. */
+  std::set<EvictionKey> *EvictionSetOf(const FrameHistory &history);
+
+  std::mutex latch_;
+  /** Logical clock, incremented on every access. */
+  size_t current_timestamp_{0};
+  /** Lookback window. */
+  size_t k_;
+  /** Access history for every frame, indexed by frame id. */
+  std::vector<FrameHistory> frames_;
+  /** Evictable frames with fewer than k accesses, ordered by their first access. */
+  std::set<EvictionKey> history_set_;
+  /** Evictable frames with k accesses, ordered by their kth most recent access. */
+  std::set<EvictionKey> cache_set_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager splits the buffer pool into several independent BufferPoolManager shards.
+ * A page id is always served by shard (page_id % num_instances), so threads touching different pages
+ * only contend on the latch of their own shard instead of one global latch.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManager shards to create
+   * @param pool_size the pool size of each shard
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of every shard
+   * @param replacer_k the lookback window, only used by ReplacerType::LRU_K
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                            size_t replacer_k = LRUK_REPLACER_K);
+
+  /**
+   * Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /**
+   * @param page_id id of page
+   * @return pointer to the shard responsible for handling the given page id
+   */
+  BufferPoolManager *GetBufferPoolManager(page_id_t page_id);
+
+  /** @return the number of shards */
+  size_t GetNumInstances() { return instances_.size(); }
+
+  /** @return the number of FetchPage hits summed over all shards */
+  size_t GetNumHits() override;
+
+  /** @return the number of FetchPage misses summed over all shards */
+  size_t GetNumMisses() override;
+
+  /** Start one background writer per shard, each with the given options. */
+  void RunBackgroundWriter(const BackgroundWriterOptions &options = BackgroundWriterOptions()) override;
+
+  /** Stop the background writers of all shards. */
+  void StopBackgroundWriter() override;
+
+  /** @return the number of synchronous write-backs summed over all shards */
+  size_t GetNumSyncWriteBacks() override;
+
+  /** @return the number of background write-backs summed over all shards */
+  size_t GetNumBackgroundWriteBacks() override;
+
+  /** @return the number of prefetched pages summed over all shards */
+  size_t GetNumPrefetches() override;
+
+  /** @return the number of pages read by the warm-up summed over all shards */
+  size_t GetNumWarmUpReads() override;
+
+ protected:
+  Page *FetchPageImpl(page_id_t page_id) override;
+
+  Page *FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  bool UnpinPageImpl(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPageImpl(page_id_t page_id) override;
+
+  /**
+   * Creates a new page in one of the shards. Shards are tried round-robin, starting one past the shard that served
+   * the previous NewPage call, until one of them has a free or evictable frame.
+   * @param[out] page_id id of created page
+   * @return nullptr if no shard could create a new page, otherwise pointer to new page
+   */
+  Page *NewPageImpl(page_id_t *page_id) override;
+
+  /** Like NewPageImpl, each shard creates the page in its own ring of the strategy. */
+  Page *NewPageWithStrategy(page_id_t *page_id, BufferAccessStrategy *strategy, segment_id_t segment) override;
+
+  bool DeletePageImpl(page_id_t page_id) override;
+
+  void FlushAllPagesImpl() override;
+
+  /** Discards the pages of the data file from every shard, the latches are taken in shard order. */
+  bool DiscardDataFile(file_id_t file_id, bool drop) override;
+
+  /** The prefetcher of the parallel buffer pool reads every page into the shard responsible for it. */
+  page_id_t PrefetchPageImpl(page_id_t page_id, next_page_fn next_page, BufferAccessStrategy *strategy) override;
+
+  /** Interleaves the resident pages of the shards, so that the hottest pages of every shard come first. */
+  void GetResidentPages(std::vector<page_id_t> *page_ids) override;
+
+  /** The warm-up of the parallel buffer pool reads every page into the shard responsible for it. */
+  Page *ClaimWarmUpFrame(page_id_t page_id) override;
+
+  void ReleaseWarmUpFrame(page_id_t page_id, Page *page) override;
+
+ private:
+  /** The shards, indexed by page_id % instances_.size(). */
+  std::vector<BufferPoolManager *> instances_;
+  /** Shard at which the next NewPage call starts looking for a frame. */
+  std::atomic<size_t> next_instance_{0};
+};
+
+}  // namespace bustub
@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** Replacement policies that a BufferPoolManager can be constructed with. */
+enum class ReplacerType { LRU = 0, LRU_K, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -43,6 +48,21 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Records that a frame was accessed. The buffer pool manager calls this every time a page is fetched or created in
+   * the frame. Policies that only look at the order of Unpin calls can ignore it.
+   * @param frame_id the id of the frame that was accessed
+   */
+  virtual void RecordAccess(frame_id_t frame_id) {}
+
+  /**
+   * Lists the frames that would be victimized next, in eviction order, without removing them.
+   * Used by the background writer to clean frames before they get evicted.
+   * @param max_candidates the maximum number of frames to return
+   * @param[out] candidates the frames closest to the eviction end of the replacer
+   */
+  virtual void VictimCandidates(size_t max_candidates, std::vector<frame_id_t> *candidates) = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
@@ -55,7 +55,8 @@ struct IndexInfo {
 
 /**
  * Catalog is a non-persistent catalog that is designed for the executor to use.
- * It handles table creation and table lookup.
+ * It handles table creation and table lookup. Every table is created in its own data file, so that dropping or
+ * truncating a table unlinks or truncates its file instead of deleting its pages one by one.
  */
 class Catalog {
  public:
@@ -64,9 +65,10 @@ class Catalog {
    * @param bpm the buffer pool manager backing tables created by this catalog
    * @param lock_manager the lock manager in use by the system
    * @param log_manager the log manager in use by the system
+   * @param compress_tables true to compress the data files of the tables, see DiskManager
    */
-  Catalog(BufferPoolManager *bpm, LockManager *lock_manager, LogManager *log_manager)
-      : bpm_{bpm}, lock_manager_{lock_manager}, log_manager_{log_manager} {}
+  Catalog(BufferPoolManager *bpm, LockManager *lock_manager, LogManager *log_manager, bool compress_tables = false)
+      : bpm_{bpm}, lock_manager_{lock_manager}, log_manager_{log_manager}, compress_tables_{compress_tables} {}
 
   /**
    * Create a new table and return its metadata.
@@ -77,14 +79,58 @@ class Catalog {
    */
   TableMetadata *CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema) {
     BUSTUB_ASSERT(names_.count(table_name) == 0, "Table names should be unique!");
-    return nullptr;
+    file_id_t file_id = bpm_->CreateDataFile("", compress_tables_);
+    auto table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn, file_id);
+    table_oid_t table_oid = next_table_oid_++;
+    auto metadata = std::make_unique<TableMetadata>(schema, table_name, std::move(table), table_oid);
+    TableMetadata *result = metadata.get();
+    tables_.emplace(table_oid, std::move(metadata));
+    names_.emplace(table_name, table_oid);
+    return result;
   }
 
-  /** @return table metadata by name */
-  TableMetadata *GetTable(const std::string &table_name) { return nullptr; }
+  /**
+   * @return table metadata by name
+   * @throws std::out_of_range if there is no such table
+   */
+  TableMetadata *GetTable(const std::string &table_name) { return tables_.at(names_.at(table_name)).get(); }
+
+  /**
+   * @return table metadata by oid
+   * @throws std::out_of_range if there is no such table
+   */
+  TableMetadata *GetTable(table_oid_t table_oid) { return tables_.at(table_oid).get(); }
+
+  /**
+   * Drop a table by unlinking its data file.
+   * @param table_name the name of the table
+   * @return false if a page of the table is pinned, the table is not dropped then
+   */
+  bool DropTable(const std::string &table_name) {
+    table_oid_t table_oid = names_.at(table_name);
+    if (!bpm_->DropDataFile(GetFileId(tables_.at(table_oid).get()))) {
+      return false;
+    }
+    tables_.erase(table_oid);
+    names_.erase(table_name);
+    return true;
+  }
 
-  /** @return table metadata by oid */
-  TableMetadata *GetTable(table_oid_t table_oid) { return nullptr; }
+  /**
+   * Remove all the tuples of a table by truncating its data file, the table gets a new first page.
+   * @param txn the transaction in which the table is being truncated
+   * @param table_name the name of the table
+   * @return false if a page of the table is pinned, the table is not truncated then
+   */
+  bool TruncateTable(Transaction *txn, const std::string &table_name) {
+    TableMetadata *table = GetTable(table_name);
+    file_id_t file_id = GetFileId(table);
+    if (!bpm_->TruncateDataFile(file_id)) {
+      return false;
+    }
+    table->table_ = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn, file_id);
+    return true;
+  }
 
   /**
    * Create a new index, populate existing data of the table and return its metadata.
@@ -101,19 +147,104 @@ class Catalog {
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
                          size_t keysize) {
-    return nullptr;
+    BUSTUB_ASSERT(index_names_[table_name].count(index_name) == 0, "Index names should be unique!");
+    // The index is in a data file of its own, like a table
+    auto *metadata = new IndexMetadata(index_name, table_name, &schema, key_attrs);
+    auto index =
+        std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(metadata, bpm_, bpm_->CreateDataFile());
+
+    // The existing tuples are loaded bottom-up, not inserted one by one
+    TableHeap *table = GetTable(table_name)->table_.get();
+    std::vector<std::pair<KeyType, ValueType>> entries;
+    for (auto iter = table->Begin(txn); iter != table->End(); ++iter) {
+      KeyType key;
+      key.SetFromKey(iter->KeyFromTuple(schema, key_schema, key_attrs));
+      entries.emplace_back(key, iter->GetRid());
+    }
+    index->BulkLoad(&entries);
+
+    index_oid_t index_oid = next_index_oid_++;
+    auto index_info =
+        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+    IndexInfo *result = index_info.get();
+    indexes_.emplace(index_oid, std::move(index_info));
+    index_names_[table_name].emplace(index_name, index_oid);
+    return result;
   }
 
-  IndexInfo *GetIndex(const std::string &index_name, const std::string &table_name) { return nullptr; }
+  /**
+   * Create a new index on RIDs, populate existing data of the table and return its metadata. The key type is picked
+   * from the key schema: a single INTEGER or BIGINT column is compared as a plain integer (IntegerKey), other keys
+   * column by column through the schema (GenericKey of the smallest size that holds keysize bytes).
+   */
+  IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
+                         const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
+                         size_t keysize) {
+    if (key_schema.GetColumnCount() == 1 && key_schema.GetColumn(0).GetType() == TypeId::INTEGER) {
+      return CreateIndex<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>>(txn, index_name, table_name, schema,
+                                                                               key_schema, key_attrs, keysize);
+    }
+    if (key_schema.GetColumnCount() == 1 && key_schema.GetColumn(0).GetType() == TypeId::BIGINT) {
+      return CreateIndex<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>>(txn, index_name, table_name, schema,
+                                                                               key_schema, key_attrs, keysize);
+    }
+    if (keysize <= 4) {
+      return CreateIndex<GenericKey<4>, RID, GenericComparator<4>>(txn, index_name, table_name, schema, key_schema,
+                                                                   key_attrs, keysize);
+    }
+    if (keysize <= 8) {
+      return CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(txn, index_name, table_name, schema, key_schema,
+                                                                   key_attrs, keysize);
+    }
+    if (keysize <= 16) {
+      return CreateIndex<GenericKey<16>, RID, GenericComparator<16>>(txn, index_name, table_name, schema, key_schema,
+                                                                     key_attrs, keysize);
+    }
+    if (keysize <= 32) {
+      return CreateIndex<GenericKey<32>, RID, GenericComparator<32>>(txn, index_name, table_name, schema, key_schema,
+                                                                     key_attrs, keysize);
+    }
+    BUSTUB_ASSERT(keysize <= 64, "Index keys are at most 64 bytes!");
+    return CreateIndex<GenericKey<64>, RID, GenericComparator<64>>(txn, index_name, table_name, schema, key_schema,
+                                                                   key_attrs, keysize);
+  }
 
-  IndexInfo *GetIndex(index_oid_t index_oid) { return nullptr; }
+  /**
+   * @return index metadata by index name and table name
+   * @throws std::out_of_range if there is no such index
+   */
+  IndexInfo *GetIndex(const std::string &index_name, const std::string &table_name) {
+    return indexes_.at(index_names_.at(table_name).at(index_name)).get();
+  }
 
-  std::vector<IndexInfo *> GetTableIndexes(const std::string &table_name) { return std::vector<IndexInfo *>(); }
+  /**
+   * @return index metadata by oid
+   * @throws std::out_of_range if there is no such index
+   */
+  IndexInfo *GetIndex(index_oid_t index_oid) { return indexes_.at(index_oid).get(); }
+
+  /** @return the metadata of all the indexes of a table */
+  std::vector<IndexInfo *> GetTableIndexes(const std::string &table_name) {
+    std::vector<IndexInfo *> result;
+    auto iter = index_names_.find(table_name);
+    if (iter != index_names_.end()) {
+      for (const auto &[index_name, index_oid] : iter->second) {
+        result.push_back(indexes_.at(index_oid).get());
+      }
+    }
+    return result;
+  }
 
  private:
-  [[maybe_unused]] BufferPoolManager *bpm_;
-  [[maybe_unused]] LockManager *lock_manager_;
-  [[maybe_unused]] LogManager *log_manager_;
+  /** @return the data file of the table */
+  static file_id_t GetFileId(TableMetadata *table) {
+    return DiskManager::GetFileId(table->table_->GetFirstPageId());
+  }
+
+  BufferPoolManager *bpm_;
+  LockManager *lock_manager_;
+  LogManager *log_manager_;
+  bool compress_tables_;
 
   /** tables_ : table identifiers -> table metadata. Note that tables_ owns all table metadata. */
   std::unordered_map<table_oid_t, std::unique_ptr<TableMetadata>> tables_;
@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bustub_config.h
+//
+// Identification: src/include/common/bustub_config.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * BustubConfig holds the engine settings that are chosen at startup rather than at compile time, and is consumed by
+ * BustubInstance. The defaults match the compile-time constants in common/config.h.
+ *
+ * Settings are read from "key = value" lines (file) or from BUSTUB_<KEY> variables (environment), with the keys:
+ *    buffer_pool_size               frames of the buffer pool (of every instance if buffer_pool_instances > 1)
+ *    buffer_pool_instances          number of shards, more than 1 selects a ParallelBufferPoolManager
+ *    log_buffer_size                size of a log buffer in byte, 0 = derived from the buffer pool size
+ *    log_timeout_ms                 the log is flushed at least this often when logging is enabled
+ *    replacer                       lru | lru_k | clock
+ *    replacer_k                     lookback window of the lru_k replacer
+ *    background_writer              on | off
+ *    background_writer_interval_ms, background_writer_low_watermark, background_writer_high_watermark,
+ *    background_writer_max_writes   see BackgroundWriterOptions
+ *    warm_up_file                   the buffer pool contents are saved there at shutdown and reloaded at startup,
+ *                                   empty = no warm-up
+ *    direct_io                      on | off, read and write the database file with O_DIRECT, see DiskManager
+ *    sync_policy                    per_write | group | on_checkpoint, when the database file is synced, see SyncPolicy
+ */
+struct BustubConfig {
+  size_t buffer_pool_size_{BUFFER_POOL_SIZE};
+  size_t buffer_pool_instances_{1};
+  size_t log_buffer_size_{0};
+  std::chrono::milliseconds log_timeout_{std::chrono::seconds(1)};
+  ReplacerType replacer_type_{ReplacerType::LRU};
+  size_t replacer_k_{LRUK_REPLACER_K};
+  bool background_writer_{false};
+  BackgroundWriterOptions background_writer_options_;
+  std::string warm_up_file_;
+  bool direct_io_{false};
+  SyncPolicy sync_policy_{SyncPolicy::ON_CHECKPOINT};
+
+  /** @return the size of a log buffer, which by default holds one page more than the whole buffer pool */
+  size_t GetLogBufferSize() const;
+
+  /**
+   * Sets one setting from its textual value.
+   * @throws Exception if the key is unknown or the value is malformed
+   */
+  void Set(const std::string &key, const std::string &value);
+
+  /** @return the defaults, overridden by every "key = value" line of the file; '#' starts a comment */
+  static BustubConfig FromFile(const std::string &file_name);
+
+  /** @return the defaults, overridden by every BUSTUB_<KEY> environment variable that is set */
+  static BustubConfig FromEnvironment();
+
+  /** @return the given settings, overridden by every BUSTUB_<KEY> environment variable that is set */
+  static BustubConfig FromEnvironment(BustubConfig config);
+};
+
+}  // namespace bustub
@@ -13,6 +13,8 @@
 #include <string>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "common/bustub_config.h"
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
 #include "recovery/checkpoint_manager.h"
@@ -23,16 +25,32 @@ namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  explicit BustubInstance(const std::string &db_file_name, const BustubConfig &config = BustubConfig()) {
     enable_logging = false;
+    log_timeout = config.log_timeout_;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = new DiskManager(db_file_name, config.direct_io_);
+    disk_manager_->SetSyncPolicy(config.sync_policy_);
 
     // log related
-    log_manager_ = new LogManager(disk_manager_);
+    log_manager_ = new LogManager(disk_manager_, config.GetLogBufferSize());
 
-    buffer_pool_manager_ = new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    if (config.buffer_pool_instances_ > 1) {
+      buffer_pool_manager_ =
+          new ParallelBufferPoolManager(config.buffer_pool_instances_, config.buffer_pool_size_, disk_manager_,
+                                        log_manager_, config.replacer_type_, config.replacer_k_);
+    } else {
+      buffer_pool_manager_ = new BufferPoolManager(config.buffer_pool_size_, disk_manager_, config.replacer_type_,
+                                                   config.replacer_k_, log_manager_);
+    }
+    if (config.background_writer_) {
+      buffer_pool_manager_->RunBackgroundWriter(config.background_writer_options_);
+    }
+    warm_up_file_ = config.warm_up_file_;
+    if (!warm_up_file_.empty()) {
+      buffer_pool_manager_->WarmUp(warm_up_file_);
+    }
 
     // txn related
     lock_manager_ = new LockManager();
@@ -47,8 +65,12 @@ class BustubInstance {
       log_manager_->StopFlushThread();
     }
     delete checkpoint_manager_;
-    delete log_manager_;
+    if (!warm_up_file_.empty()) {
+      buffer_pool_manager_->WaitForWarmUp();
+      buffer_pool_manager_->SaveResidentPages(warm_up_file_);
+    }
     delete buffer_pool_manager_;
+    delete log_manager_;
     delete lock_manager_;
     delete transaction_manager_;
     delete disk_manager_;
@@ -60,6 +82,8 @@ class BustubInstance {
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
   CheckpointManager *checkpoint_manager_;
+  /** File in which the buffer pool contents are saved at shutdown, empty if there is no warm-up. */
+  std::string warm_up_file_;
 };
 
 }  // namespace bustub
@@ -25,21 +25,37 @@ extern std::chrono::milliseconds cycle_detection_interval;
 extern std::atomic<bool> enable_logging;
 
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
-extern std::chrono::duration<int64_t> log_timeout;
+extern std::chrono::milliseconds log_timeout;
 
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
+static constexpr int INVALID_SEGMENT_ID = -1;                                 // invalid segment id
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
 static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
-static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
-static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
+static constexpr int BUFFER_POOL_SIZE = 10;                                   // default size of buffer pool
+static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // default size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int LRUK_REPLACER_K = 2;                                     // lookback window for lru-k replacer
+static constexpr int READ_AHEAD_PAGES = 4;                                    // pages a scan reads ahead
+static constexpr int BUFFER_RING_SIZE = 16;                                   // frames in the ring of a bulk scan
+static constexpr int WARM_UP_BATCH_PAGES = 32;                                // pages per read of a warm-up
+static constexpr int ASYNC_IO_QUEUE_DEPTH = 32;                               // requests in flight per async context
+static constexpr int ASYNC_IO_THREADS = 8;                                    // async I/O threads without io_uring
+static constexpr int WARM_UP_QUEUE_DEPTH = 4;                                 // reads in flight during a warm-up
+static constexpr int EXTENT_PAGES = 64;                                       // pages per extent of a segment
+static constexpr int SYNC_GROUP_PAGES = 64;                                   // page writes per sync, group policy
+static constexpr int DATA_FILE_PAGE_BITS = 24;                                // low page id bits: page in its file
+static constexpr int MAX_DATA_FILES = 1 << (31 - DATA_FILE_PAGE_BITS);        // data files, high page id bits
+static constexpr int COMPRESSED_SLOT_SIZE = 256;                              // bytes per unit of a compressed slot
+static constexpr double BULK_LOAD_FILL_FACTOR = 0.9;                          // fraction of a page filled by bulk load
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
 using txn_id_t = int32_t;      // transaction id type
 using lsn_t = int32_t;         // log sequence number type
+using segment_id_t = int32_t;  // segment id type
+using file_id_t = int32_t;     // data file id type
 using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
 
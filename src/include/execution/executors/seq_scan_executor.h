@@ -12,11 +12,13 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -42,5 +44,9 @@ class SeqScanExecutor : public AbstractExecutor {
  private:
   /** The sequential scan plan node to be executed. */
   const SeqScanPlanNode *plan_;
+  /** The table being scanned. */
+  TableMetadata *table_info_{nullptr};
+  /** The position of the scan, created by Init. */
+  std::unique_ptr<TableIterator> iter_;
 };
 }  // namespace bustub
@@ -0,0 +1,202 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io.h
+//
+// Identification: src/include/storage/disk/async_io.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** Implementations of AsyncIOContext. */
+enum class AsyncIOBackend { IO_URING, THREAD_POOL };
+
+/** How AsyncIOContext reaches the pages of the data files. */
+struct PageLocator {
+  /**
+   * Locates a page.
+   * @param page_id id of the page
+   * @param[out] offset the offset of the page in its data file
+   * @param[out] owner keeps the file descriptor open, held until the request completes
+   * @return the file descriptor of the data file of the page, -1 if the pages of the file are not at a fixed offset
+   * (a compressed data file)
+   */
+  std::function<int(page_id_t page_id, int64_t *offset, std::shared_ptr<void> *owner)> locate_;
+
+  /**
+   * Reads or writes consecutive pages that are not at a fixed offset, synchronously.
+   * @return the number of bytes transferred, or -errno
+   */
+  std::function<int64_t(bool is_write, page_id_t first_page_id, size_t num_pages, char *data)> transfer_;
+};
+
+/** A finished asynchronous request. */
+struct AsyncIOCompletion {
+  /** the tag given when the request was submitted */
+  uint64_t tag_;
+  /** the number of bytes transferred, or -errno if the request failed */
+  int64_t result_;
+};
+
+/**
+ * IOThreadPool runs blocking I/O jobs on a fixed set of threads, for the thread pool backend of AsyncIOContext.
+ */
+class IOThreadPool {
+ public:
+  explicit IOThreadPool(size_t num_threads);
+
+  /** Runs the jobs already queued, then joins the threads. */
+  ~IOThreadPool();
+
+  IOThreadPool(const IOThreadPool &) = delete;
+  IOThreadPool &operator=(const IOThreadPool &) = delete;
+
+  /** Queue a job, one of the threads runs it. */
+  void Post(std::function<void()> job);
+
+ private:
+  void WorkerLoop();
+
+  std::vector<std::thread> threads_;
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> jobs_;
+  bool running_ = true;
+};
+
+/**
+ * AsyncIOContext submits page reads and writes on the data files without waiting for them, and reaps their
+ * completions later, so that one thread keeps up to queue_depth requests in flight: the device works on several pages
+ * at once, and the thread overlaps its own work with the I/O.
+ *
+ * A context belongs to one thread at a time. It is created by DiskManager::NewAsyncIOContext, and must be destroyed
+ * before its DiskManager; the destructor waits for the requests still in flight. The buffers of a request must stay
+ * valid until its completion is returned by Complete. If the DiskManager uses direct I/O, they must also be aligned to
+ * PAGE_SIZE: requests bypass the bounce buffer of the synchronous path.
+ *
+ * Two backends: io_uring, which hands batches of requests to the kernel with one system call, and a thread pool
+ * running pread/pwrite for kernels without io_uring. The pages of a compressed data file have no fixed offset: their
+ * requests are run synchronously by the submit, and complete like the others.
+ */
+class AsyncIOContext {
+ public:
+  virtual ~AsyncIOContext() = default;
+
+  AsyncIOContext(const AsyncIOContext &) = delete;
+  AsyncIOContext &operator=(const AsyncIOContext &) = delete;
+
+  virtual AsyncIOBackend GetBackend() const = 0;
+
+  /** @return the maximum number of requests in flight */
+  size_t GetQueueDepth() const { return queue_depth_; }
+
+  /** @return the number of submitted requests whose completion has not been returned by Complete yet */
+  size_t GetNumPending() const { return num_in_flight_ + completed_.size(); }
+
+  /**
+   * Submit a read of consecutive pages of one data file. Pages past the end of the file read as zeros.
+   * If queue_depth requests are in flight, waits for one of them first.
+   * @param first_page_id id of the first page
+   * @param num_pages number of pages to read
+   * @param[out] data buffer of num_pages * PAGE_SIZE bytes
+   * @param tag returned with the completion of the request
+   */
+  void SubmitRead(page_id_t first_page_id, size_t num_pages, char *data, uint64_t tag);
+
+  /**
+   * Submit a write of consecutive pages of one data file. If queue_depth requests are in flight, waits for one of
+   * them first.
+   * @param first_page_id id of the first page
+   * @param num_pages number of pages to write
+   * @param data buffer of num_pages * PAGE_SIZE bytes
+   * @param tag returned with the completion of the request
+   */
+  void SubmitWrite(page_id_t first_page_id, size_t num_pages, const char *data, uint64_t tag);
+
+  /**
+   * Start the submitted requests that are not started yet, and wait until at least min_completions requests are
+   * complete (fewer if fewer are pending).
+   * @param[out] completions the completions are appended to it
+   * @param min_completions the number of completions to wait for, 0 to only collect the ones that are ready
+   * @return the number of completions appended
+   */
+  size_t Complete(std::vector<AsyncIOCompletion> *completions, size_t min_completions = 1);
+
+ protected:
+  AsyncIOContext(PageLocator locator, size_t queue_depth, std::atomic<int> *num_writes)
+      : locator_(std::move(locator)), queue_depth_(queue_depth), num_writes_(num_writes) {}
+
+  /**
+   * Queue one request of the backend on the file fd, at most queue_depth requests are in flight. owner must be held
+   * until the request completes.
+   */
+  virtual void Enqueue(bool is_write, int fd, std::shared_ptr<void> owner, int64_t offset, char *data, size_t size,
+                       uint64_t tag) = 0;
+
+  /** Start the queued requests and wait until at least min_completions of them are complete. */
+  virtual void Reap(std::vector<AsyncIOCompletion> *completions, size_t min_completions) = 0;
+
+  /** Destructors of the backends call it to wait for the requests in flight. */
+  void Drain();
+
+  /** finds the data file of the pages of a request */
+  const PageLocator locator_;
+  const size_t queue_depth_;
+  /** requests handed to the backend and not reaped yet */
+  size_t num_in_flight_ = 0;
+
+ private:
+  /** Make room for one more request in flight. */
+  void WaitForSlot();
+
+  /** Queue the request on the backend, or run it with the transfer of the locator. */
+  void Submit(bool is_write, page_id_t first_page_id, size_t num_pages, char *data, uint64_t tag);
+
+  /** write counter of the DiskManager */
+  std::atomic<int> *num_writes_;
+  /** completions reaped to make room for a request, not yet returned by Complete */
+  std::vector<AsyncIOCompletion> completed_;
+};
+
+/**
+ * pread until size bytes are read or the end of the file is reached, retrying short reads.
+ * @return the number of bytes read, -1 on an I/O error
+ */
+ssize_t ReadFully(int fd, char *data, size_t size, int64_t offset);
+
+/**
+ * pwrite until size bytes are written, retrying short writes.
+ * @return the number of bytes written, -1 on an I/O error
+ */
+ssize_t WriteFully(int fd, const char *data, size_t size, int64_t offset);
+
+/** @return an io_uring context, nullptr if the kernel does not support io_uring */
+std::unique_ptr<AsyncIOContext> NewIOUringContext(PageLocator locator, size_t queue_depth,
+                                                  std::atomic<int> *num_writes);
+
+/** @return a context running its requests on the threads of pool */
+std::unique_ptr<AsyncIOContext> NewThreadPoolContext(PageLocator locator, size_t queue_depth,
+                                                     std::atomic<int> *num_writes, IOThreadPool *pool);
+
+}  // namespace bustub
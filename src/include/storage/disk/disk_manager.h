@@ -13,47 +13,175 @@
 #pragma once
 
 #include <atomic>
-#include <fstream>
 #include <future>  // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/async_io.h"
 
 namespace bustub {
 
+/** When the disk manager syncs the database file. */
+enum class SyncPolicy {
+  /** after every WritePage and WritePages */
+  PER_WRITE,
+  /** once every SYNC_GROUP_PAGES page writes, shared by all the writers */
+  GROUP,
+  /** only on SyncDataFile, i.e. at a checkpoint (FlushAllPages) */
+  ON_CHECKPOINT,
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Page I/O uses positional reads and writes (pread/pwrite) on a file descriptor, which carry their own offset, so the
+ * buffer pool shards, the background writers and the prefetcher issue page I/O concurrently without any lock.
+ *
+ * Which pages are allocated is tracked by a bitmap in the free space map file (the data file name with the
+ * extension .fsm), so that deallocated pages are handed out again instead of growing the file, also after a restart.
+ * A bitmap block is written as soon as one of its bits changes.
+ *
+ * Pages can be allocated in a segment, e.g. the pages of one table heap or one index. A segment gets its pages from
+ * extents of extent_pages contiguous pages that it owns, so that its pages stay physically close and a scan of it reads
+ * the file sequentially. The file grows one extent at a time, and the blocks of a new extent are reserved with
+ * fallocate. Which segment owns an extent is not saved: after a restart the free pages of the old extents are
+ * allocated like any other free page, and the segments take new extents.
+ *
+ * A database can have several data files, e.g. one per table or index, so that dropping a table unlinks its file
+ * and a hot index can be placed on a faster disk. Data file 0 is the database file itself, the others are listed in
+ * the data file directory (the database file name with the extension .files). The high bits of a page id are the id
+ * of its data file and the low DATA_FILE_PAGE_BITS bits the number of the page in that file, so the pages of the
+ * database file keep their ids, and the buffer pool sees plain page ids. Every data file has its own free space map
+ * and extents; the segments of a table or index in its own file take their extents from that file.
+ *
+ * A data file can be compressed: WritePage compresses the page with the LZ codec (see lz_codec.h) into a slot of as
+ * many COMPRESSED_SLOT_SIZE units as it needs, and ReadPage decompresses it. Where the slot of every page is, is kept
+ * in the page map file (the data file name with the extension .map), whose presence marks the file as compressed. A
+ * page whose size in units changes gets a new slot, and its old slot is only freed once the page map points to the
+ * new one. The free slots are coalesced, and are rebuilt from the page map at startup. The reads of a compressed file
+ * share its page map latch and its writes hold it exclusively; it never uses O_DIRECT, since its slots are not aligned.
+ *
+ * In direct I/O mode the data files are opened with O_DIRECT, so that its pages are cached once, in the buffer pool,
+ * instead of a second time in the kernel page cache. The frames of the buffer pool are aligned to PAGE_SIZE and are
+ * transferred as they are, other buffers go through an aligned bounce buffer. On a file system that rejects O_DIRECT
+ * the disk manager falls back to buffered I/O.
+ *
+ * Durability follows the sync policy. Every WriteLog is made durable with fdatasync before it returns, since the log
+ * manager writes the log at commit boundaries. The policy decides when the data file is synced: the data pages of
+ * committed transactions can be redone from the log, so syncing them lazily is safe. The writes of an AsyncIOContext
+ * do not count for the policy, a caller that needs them durable calls SyncDataFile.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io true to bypass the kernel page cache with O_DIRECT, if the file system supports it
+   * @param extent_pages the number of pages of an extent
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false, uint32_t extent_pages = EXTENT_PAGES);
+
+  /** Closes the database file if ShutDown was not called. */
+  ~DiskManager();
 
-  ~DiskManager() = default;
+  DiskManager(const DiskManager &) = delete;
+  DiskManager &operator=(const DiskManager &) = delete;
 
   /**
    * Shut down the disk manager and close all the file resources.
    */
   void ShutDown();
 
+  /** @return the data file of the page */
+  static file_id_t GetFileId(page_id_t page_id) { return page_id >> DATA_FILE_PAGE_BITS; }
+
+  /** @return the number of the page in its data file */
+  static page_id_t GetPageNumber(page_id_t page_id) { return page_id & ((1 << DATA_FILE_PAGE_BITS) - 1); }
+
+  /** @return the id of the page page_number of a data file */
+  static page_id_t MakePageId(file_id_t file_id, page_id_t page_number) {
+    return (file_id << DATA_FILE_PAGE_BITS) | page_number;
+  }
+
+  /**
+   * Create a new, empty data file, and add it to the data file directory.
+   * @param file_name the name of the file, empty to name it after the database file and the file id
+   * @param compressed true to compress the pages of the file
+   * @return the id of the new data file
+   * @throws Exception if the file cannot be created, or if there are MAX_DATA_FILES data files already
+   */
+  file_id_t CreateDataFile(const std::string &file_name = "", bool compressed = false);
+
+  /**
+   * Remove a data file and its free space map, all its pages are gone. The segments in it cannot allocate anymore.
+   * No page of the file may be read or written anymore, e.g. the buffer pool must discard its frames first.
+   * @param file_id id of the data file, not 0
+   */
+  void DropDataFile(file_id_t file_id);
+
+  /**
+   * Deallocate all the pages of a data file, and truncate it to nothing. Its segments keep allocating in it.
+   * @param file_id id of the data file
+   */
+  void TruncateDataFile(file_id_t file_id);
+
+  /** @return true if the data file exists */
+  bool HasDataFile(file_id_t file_id);
+
+  /** @return true if the pages of the data file are compressed */
+  bool IsCompressed(file_id_t file_id);
+
+  /** @return the size of a data file on disk in bytes, without its free space map and page map */
+  int64_t GetDataFileSize(file_id_t file_id);
+
   /**
-   * Write a page to the database file.
+   * Write a page to its data file.
    * @param page_id id of the page
    * @param page_data raw page data
    */
   void WritePage(page_id_t page_id, const char *page_data);
 
   /**
-   * Read a page from the database file.
+   * Write consecutive pages of one data file with vectored writes (pwritev), one per IOV_MAX pages.
+   * @param first_page_id id of the first page
+   * @param pages the data of each page, num_pages pointers to PAGE_SIZE bytes
+   * @param num_pages number of pages to write
+   */
+  void WritePages(page_id_t first_page_id, const char *const *pages, size_t num_pages);
+
+  /** Make the writes to the data files durable (fdatasync). */
+  void SyncDataFile();
+
+  /** Set when the database file is synced, ON_CHECKPOINT by default. */
+  void SetSyncPolicy(SyncPolicy sync_policy) { sync_policy_ = sync_policy; }
+
+  /** @return when the database file is synced */
+  SyncPolicy GetSyncPolicy() const { return sync_policy_; }
+
+  /**
+   * Read a page from its data file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Read consecutive pages of one data file with a single sequential read.
+   * Pages past the end of the file are zeroed.
+   * @param first_page_id id of the first page
+   * @param num_pages number of pages to read
+   * @param[out] data output buffer of num_pages * PAGE_SIZE bytes
+   */
+  void ReadPages(page_id_t first_page_id, size_t num_pages, char *data);
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -68,20 +196,55 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  bool ReadLog(char *log_data, int size, int offset);
+  bool ReadLog(char *log_data, int size, int64_t offset);
+
+  /**
+   * @param file_id the data file of the pages of the segment
+   * @return the id of a new segment, to allocate pages in
+   */
+  segment_id_t CreateSegment(file_id_t file_id = 0);
 
   /**
-   * Allocate a page on disk.
+   * Allocate a page on disk: the lowest deallocated page id congruent to residue modulo stride, or a new page at the
+   * end of the file if there is none. A shard of a parallel buffer pool passes the number of shards and its index.
+   * In a segment, the page comes from the extents of the segment in its data file, and a new extent is taken if they
+   * have no free page with the residue (a stride larger than an extent ignores the extents, not the data file).
+   * Without a segment, the page is in the database file.
+   * @param stride the allocated page id is congruent to residue modulo stride
+   * @param residue the residue of the allocated page id, less than stride
+   * @param segment the segment of the page, INVALID_SEGMENT_ID for none
    * @return the id of the allocated page
+   * @throws Exception if the segment is in a dropped data file, or if the data file is full
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(uint32_t stride = 1, uint32_t residue = 0, segment_id_t segment = INVALID_SEGMENT_ID);
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, a later AllocatePage may hand it out again. Does nothing if the page is not allocated.
    * @param page_id id of the page to deallocate
    */
   void DeallocatePage(page_id_t page_id);
 
+  /** @return true if the page is allocated */
+  bool IsAllocated(page_id_t page_id);
+
+  /**
+   * Create a context for asynchronous page I/O on the data files, see AsyncIOContext.
+   * @param queue_depth the maximum number of requests in flight
+   * @param backend the preferred backend, io_uring falls back to the thread pool if the kernel does not support it
+   * @return a context that must be destroyed before this disk manager
+   */
+  std::unique_ptr<AsyncIOContext> NewAsyncIOContext(size_t queue_depth = ASYNC_IO_QUEUE_DEPTH,
+                                                    AsyncIOBackend backend = AsyncIOBackend::IO_URING);
+
+  /**
+   * @return the number of pages spanned by a data file, including the holes of a sparse file, or the pages of a
+   * compressed data file up to the last one written
+   */
+  int64_t GetNumPages(file_id_t file_id = 0);
+
+  /** @return true if the database file is read and written with O_DIRECT */
+  bool UsesDirectIO() const { return files_[0]->direct_io_; }
+
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
 
@@ -91,6 +254,12 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of syncs of the database file */
+  size_t GetNumDataSyncs() const { return num_data_syncs_; }
+
+  /** @return the number of syncs of the log file */
+  size_t GetNumLogSyncs() const { return num_log_syncs_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -101,16 +270,169 @@ class DiskManager {
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
  private:
-  int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
+  /**
+   * Where a page of a compressed data file is: num_units_ units of COMPRESSED_SLOT_SIZE bytes from unit slot_ on. The
+   * entry of page i is at offset i * sizeof(PageSlot) in the page map file.
+   */
+  struct PageSlot {
+    uint32_t slot_;
+    uint16_t num_units_;
+    // the size of the compressed page, PAGE_SIZE if it is stored as it is, 0 if it was never written
+    uint16_t size_;
+  };
+
+  /**
+   * A data file with its allocation state, which is protected by alloc_latch_. Its files are closed when the last
+   * reference goes away: page I/O holds one while it runs, so that a dropped file is not closed under it.
+   */
+  struct DataFile {
+    ~DataFile() { CloseDataFile(this); }
+
+    std::string name_;
+    std::string fsm_name_;
+    // -1 once shut down
+    int fd_{-1};
+    int fsm_fd_{-1};
+    // true if fd_ was opened with O_DIRECT and the file system accepted it
+    bool direct_io_{false};
+    // bit i is set iff page i is allocated, whole bitmap blocks of PAGE_SIZE bytes
+    std::vector<uint64_t> allocated_;
+    // the deallocated pages below next_page_id_ that are in no extent of a segment
+    std::set<page_id_t> free_pages_;
+    // the pages from next_page_id_ on have never been allocated
+    page_id_t next_page_id_{0};
+    // the segment that owns an extent, by the first page of the extent
+    std::unordered_map<page_id_t, segment_id_t> extent_owners_;
+
+    // a compressed data file has a page map, the state below is protected by map_latch_
+    bool compressed_{false};
+    std::string map_name_;
+    int map_fd_{-1};
+    std::shared_mutex map_latch_;
+    // the slot of every page, by page number
+    std::vector<PageSlot> page_slots_;
+    // the free slots: their number of units by first unit, and their first units by number of units
+    std::map<uint32_t, uint32_t> free_slots_;
+    std::multimap<uint32_t, uint32_t> free_slots_by_size_;
+    // the units from next_slot_ on are in no slot
+    uint32_t next_slot_{0};
+  };
+
+  /**
+   * File offsets and sizes are 64-bit: a page id times PAGE_SIZE overflows an int past 2 GB.
+   * @return the size of the file in bytes, -1 if it does not exist
+   */
+  int64_t GetFileSize(const std::string &file_name);
+
+  /** @return the name of the file with the extension of the database file replaced by extension */
+  static std::string ReplaceExtension(const std::string &file_name, const std::string &extension);
+
+  /**
+   * Open (or create) a data file and its free space map, and load its allocation state. A data file with a page map is
+   * compressed.
+   * @param compressed true to create the page map of a new compressed data file
+   */
+  std::unique_ptr<DataFile> OpenDataFile(const std::string &file_name, bool direct_io, bool compressed = false);
+
+  /** Close the files of a data file. */
+  static void CloseDataFile(DataFile *file);
+
+  /** Rewrite the data file directory from files_, alloc_latch_ must be held. */
+  void WriteDataFileDirectory();
+
+  /** @return the data file of the page, nullptr if it does not exist */
+  std::shared_ptr<DataFile> GetDataFile(page_id_t page_id) {
+    file_id_t file_id = GetFileId(page_id);
+    std::shared_lock lock{files_latch_};
+    return file_id >= 0 && file_id < MAX_DATA_FILES ? files_[file_id] : nullptr;
+  }
+
+  /**
+   * Positional read and write on a data file. In direct I/O mode a buffer that is not aligned to PAGE_SIZE is copied
+   * through an aligned one.
+   * @return the number of bytes transferred, -1 on an I/O error
+   */
+  ssize_t ReadAt(DataFile *file, char *data, size_t size, int64_t offset);
+  ssize_t WriteAt(DataFile *file, const char *data, size_t size, int64_t offset);
+
+  /** @return the number of pages of a data file, see GetNumPages */
+  static int64_t CountPages(DataFile *file);
+
+  /** Rebuild the free slots of a compressed data file from its page map at startup. */
+  static void LoadPageMap(DataFile *file);
+
+  /**
+   * Read or write a page of a compressed data file, map_latch_ must not be held. A write does not count as a disk
+   * write nor syncs, a read of a page that was never written fills it with zeros.
+   * @return false on an I/O error or a corrupt page
+   */
+  static bool ReadCompressedPage(DataFile *file, page_id_t page_number, char *page_data);
+  static bool WriteCompressedPage(DataFile *file, page_id_t page_number, const char *page_data);
+
+  /** @return the first unit of a free slot of num_units units, taken from the free slots, map_latch_ must be held */
+  static uint32_t AllocateSlot(DataFile *file, uint32_t num_units);
+
+  /** Free a slot, coalesced with the free slots next to it, map_latch_ must be held. */
+  static void FreeSlot(DataFile *file, uint32_t slot, uint32_t num_units);
+
+  /** @return the offset of the page in its data file */
+  static int64_t PageOffset(page_id_t page_id) { return static_cast<int64_t>(GetPageNumber(page_id)) * PAGE_SIZE; }
+
+  /**
+   * Rebuild the allocation state of a data file at startup. A data file without free space map (or with a stale one,
+   * if the data file is empty) is assumed to have every page up to its end allocated.
+   */
+  void LoadFreeSpaceMap(DataFile *file);
+
+  /** Set the bit of the page in the bitmap and write its bitmap block, alloc_latch_ must be held. */
+  void SetAllocated(DataFile *file, page_id_t page_number, bool allocated);
+
+  /** Write one block of the bitmap to the free space map file. */
+  void WriteFreeSpaceMapBlock(DataFile *file, size_t block);
+
+  /** @return true if the bit of the page is set in the bitmap, alloc_latch_ must be held */
+  static bool TestAllocated(const DataFile &file, page_id_t page_number);
+
+  /** Give the segment a new extent, a deallocated one or one at the end of its file, alloc_latch_ must be held. */
+  void NewExtent(DataFile *file, segment_id_t segment);
+
+  /** Reserve the blocks of consecutive pages in a data file, without changing its size. */
+  void Preallocate(DataFile *file, page_id_t first_page_number, page_id_t num_pages);
+
+  /** Sync after num_pages page writes to a data file if the sync policy asks for it. */
+  void SyncAfterPageWrites(DataFile *file, size_t num_pages);
+
+  /** fdatasync a data file, its page map and its free space map. @return false on an I/O error */
+  static bool SyncFiles(DataFile *file);
+
+  // file descriptor of the log file, opened for appending, -1 once shut down
+  int log_fd_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
   std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
+  std::string directory_name_;
+  // protects the allocation state below, the data file directory and the creation and removal of data files
+  std::mutex alloc_latch_;
+  // the data files by id, nullptr for an id that is not used. A slot is set or cleared under both latches, so either
+  // one is enough to read it: page I/O looks its file up under files_latch_ alone, not to wait for allocations
+  std::shared_mutex files_latch_;
+  std::vector<std::shared_ptr<DataFile>> files_;
+  // pages per extent
+  const page_id_t extent_pages_;
+  segment_id_t next_segment_id_;
+  // the data file of every segment
+  std::unordered_map<segment_id_t, file_id_t> segment_files_;
+  // the free pages of the extents of every segment, page numbers in the file of the segment
+  std::unordered_map<segment_id_t, std::set<page_id_t>> segment_free_pages_;
+  // runs the requests of the asynchronous I/O contexts that do not use io_uring, started on first use
+  std::mutex io_pool_latch_;
+  std::unique_ptr<IOThreadPool> io_pool_;
+  std::atomic<SyncPolicy> sync_policy_;
+  // page writes since the last sync of the data files
+  std::atomic<size_t> num_unsynced_pages_;
+  std::atomic<size_t> num_data_syncs_;
+  std::atomic<size_t> num_log_syncs_;
   int num_flushes_;
-  int num_writes_;
+  std::atomic<int> num_writes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
 };
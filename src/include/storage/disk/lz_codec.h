@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_codec.h
+//
+// Identification: src/include/storage/disk/lz_codec.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * A fast LZ77 codec for pages, in the spirit of LZ4: the input is a sequence of literal runs, each followed by a copy
+ * of an earlier match of at least 4 bytes at most 65535 bytes back. Matches are found with a hash table of the last
+ * position of every 4-byte sequence, without any search, so compression makes a single pass over the page.
+ *
+ * A sequence is a token byte (the literal length in the high 4 bits, the match length minus 4 in the low 4 bits, 15
+ * meaning that more length bytes follow, each adding up to 255), the literal length bytes, the literals, the 2-byte
+ * little-endian match offset and the match length bytes. The last sequence has literals only, and ends the input.
+ */
+
+/**
+ * Compress size bytes of src into dst.
+ * @param src the data to compress
+ * @param size the size of the data, at most 65535 bytes back are searched for matches
+ * @param[out] dst the compressed data
+ * @param capacity the size of dst
+ * @return the size of the compressed data, 0 if it does not fit in capacity bytes
+ */
+size_t LZCompress(const char *src, size_t size, char *dst, size_t capacity);
+
+/**
+ * Decompress the output of LZCompress.
+ * @param src the compressed data
+ * @param size the size of the compressed data
+ * @param[out] dst the decompressed data
+ * @param capacity the size of the decompressed data
+ * @return false if src is corrupt or does not decompress to exactly capacity bytes
+ */
+bool LZDecompress(const char *src, size_t size, char *dst, size_t capacity);
+
+}  // namespace bustub
@@ -10,6 +10,10 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <utility>  // for std::pair
@@ -19,6 +23,7 @@
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -42,8 +47,10 @@ class BPlusTree {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
+  // file_id: 树的page所在的数据文件
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     file_id_t file_id = 0);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -54,6 +61,11 @@ class BPlusTree {
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
+  // Build an empty B+ tree bottom-up from (key, value) pairs sorted by key with unique keys, every page filled to
+  // fill_factor of its max size. Returns false if the tree is not empty.
+  bool BulkLoad(const std::vector<std::pair<KeyType, ValueType>> &entries,
+                double fill_factor = BULK_LOAD_FILL_FACTOR);
+
   // return the value associated with a given key
   bool GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr);
 
@@ -74,71 +86,58 @@ class BPlusTree {
     out.close();
   }
 
+  // number of leaves the iterators of this tree prefetch ahead, 0 disables read-ahead
+  void SetReadAheadPages(size_t read_ahead_pages) { read_ahead_pages_ = read_ahead_pages; }
+
+  // false: Insert/Remove always W Latch from the root (pessimistic latch crabbing), true by default
+  void SetOptimisticLatching(bool optimistic) { optimistic_ = optimistic; }
+
+  // false: GetValue and the iterators R Latch every page from the root (latch crabbing), true by default: they only
+  // latch the leaf page they return and validate the versions of the other pages (optimistic lock coupling)
+  void SetOptimisticReads(bool optimistic_reads) { optimistic_reads_ = optimistic_reads; }
+
   // read data from file and insert one by one
   void InsertFromFile(const std::string &file_name, Transaction *transaction = nullptr);
 
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
-  // expose for test purpose
-  // Page *FindLeafPage(const KeyType &key, bool leftMost = false, Transaction *transaction = nullptr,
-  //                    Operation op = Operation::FIND, bool *root_is_latched_ = nullptr, bool rightMost = false);
-
+  // expose for test purpose: the leaf page is returned pinned but not latched, the caller must unpin it
   Page *FindLeafPage(const KeyType &key, bool leftMost = false);
 
-  std::pair<Page *, bool> FindLeafPageByOperation(const KeyType &key, Operation operation = Operation::FIND,
-                                                  Transaction *transaction = nullptr, bool leftMost = false,
-                                                  bool rightMost = false);
-
-  // BufferPoolManager *getBPM() { return buffer_pool_manager_; }  // only for DEBUG
-
-  // uint64_t getThreadId() {  // only for DEBUG
-  //   // std::scoped_lock latch{latch_};
-
-  //   std::stringstream ss;
-  //   ss << std::this_thread::get_id();
-  //   // ss << transaction->GetThreadId();
-  //   uint64_t thread_id = std::stoull(ss.str());
-  //   return thread_id % 13;
-  //   // LOG_INFO("Thread=%lu", thread_id % 131);
-  // }
-
-  // int OpToString(Operation op) {  // only for debug
-  //   std::string res;
-  //   int d;
-  //   if (op == Operation::FIND) {
-  //     res = "FIND";
-  //     d = 0;
-  //   } else if (op == Operation::INSERT) {
-  //     res = "INSERT";
-  //     d = 1;
-  //   } else if (op == Operation::DELETE) {
-  //     res = "DELETE";
-  //     d = 2;
-  //   }
-  //   // char *c_res = res.data();
-  //   return d;
-  // }
-
  private:
+  /**
+   * 一次写操作（Insert/Remove）的latch crabbing状态，析构时释放所有仍然持有的锁
+   */
+  struct Context {
+    // 持有时root_page_id_不会被其他写操作修改，直到确认根结点是安全的
+    std::unique_lock<std::mutex> root_lock_;
+    // 从上到下被写锁住的结点，back()为最下层的结点（leaf），前面是它所有不安全的祖先
+    std::deque<WritePageGuard> write_set_;
+    // 被合并掉的page和换下来的旧根结点，在所有guard释放后再从缓冲池中删除
+    std::vector<page_id_t> deleted_pages_;
+  };
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
-  bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+  // 申请新的根结点，返回持有写锁的guard
+  WritePageGuard NewRootGuarded(page_id_t *page_id);
 
-  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr, bool *root_is_latched = nullptr);
+  bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Context *ctx);
+
+  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node, Context *ctx,
+                        size_t level);
 
   template <typename N>
-  N *Split(N *node);
+  WritePageGuard Split(N *node);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr, bool *root_is_latched = nullptr);
+  void CoalesceOrRedistribute(N *node, Context *ctx, size_t level);
 
   template <typename N>
-  bool Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent,
-                int index, Transaction *transaction = nullptr, bool *root_is_latched = nullptr);
+  void Coalesce(N *neighbor_node, N *node, InternalPage *parent, int index, Context *ctx, size_t level);
 
   template <typename N>
-  void Redistribute(N *neighbor_node, N *node, int index);
+  void Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index);
 
   bool AdjustRoot(BPlusTreePage *node);
 
@@ -149,23 +148,63 @@ class BPlusTree {
 
   void ToString(BPlusTreePage *page, BufferPoolManager *bpm) const;
 
-  void UnlockPages(Transaction *transaction);
+  // 读操作：从根结点向下找到leaf page，返回持有leaf读锁的guard（空树则返回空guard）
+  ReadPageGuard FindLeafRead(const KeyType &key, bool leftMost = false, bool rightMost = false);
+
+  // 写操作：从根结点向下找到leaf page，路径上锁住的结点都放入ctx->write_set_
+  void FindLeafWrite(const KeyType &key, Operation op, Context *ctx);
 
-  // unlock 和 unpin 事务中经过的所有parent page
-  void UnlockUnpinPages(Transaction *transaction);
+  // 乐观的写操作：读锁向下，只写锁leaf放入ctx->write_set_；空树或leaf不安全时返回false
+  bool FindLeafOptimistic(const KeyType &key, Operation op, Context *ctx);
 
   // 判断node是否安全
   template <typename N>
-  bool IsSafe(N *node, Operation op);
+  bool IsSafe(const N *node, Operation op);
+
+  // 乐观锁耦合的读操作：不加读锁向下找到leaf page，返回pin住但没有加锁的leaf（空树则返回空guard）
+  BasicPageGuard FindLeafOptimisticRead(const KeyType &key, bool leftMost, bool rightMost, uint64_t *version);
+
+  /**
+   * 登记一个不加锁读取page id的操作，析构时结束登记。读操作可能拿着刚被合并掉的page id或旧的root page id去fetch，
+   * 所以这些page要等WaitForOptimisticReads之前开始的读操作都结束后才能删除
+   */
+  struct OptimisticReadScope {
+    explicit OptimisticReadScope(BPlusTree *tree);
+    ~OptimisticReadScope() { count_->fetch_sub(1); }
+    std::atomic<int64_t> *count_;
+  };
+
+  // epoch_加1，然后等待登记在旧epoch中的读操作都结束
+  void WaitForOptimisticReads();
+
+  // 删除page_ids和之前没能删除的page，仍被pin住的page留在pending_deletes_中
+  void DeletePages(const std::vector<page_id_t> &page_ids);
+
+  // 读操作按线程分散登记到不同的cache line，避免所有读操作都写同一个计数器
+  static constexpr size_t READER_SLOTS = 16;
+  struct alignas(64) ReaderSlot {
+    std::atomic<int64_t> count_[2]{};  // 登记在偶数和奇数epoch中的读操作个数
+  };
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // 读操作不加锁，读取后锁住这个page再验证它仍是根结点；只在root_latch_和旧根结点的写锁下修改
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
+  segment_id_t segment_;  // 新page都分配在这个segment中，使得树的page在文件中连续
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
-  std::mutex root_latch_;  // 保护root page id不被改变
+  size_t read_ahead_pages_{READ_AHEAD_PAGES};
+  bool optimistic_{true};
+  bool optimistic_reads_{true};
+  std::atomic<uint64_t> epoch_{0};
+  ReaderSlot reader_slots_[READER_SLOTS];
+  std::mutex epoch_latch_;  // 一次只有一个写操作增加epoch_并等待，这样等待的读操作个数只会减少
+  std::mutex root_latch_;  // 写操作之间保护root page id不被改变，读操作和乐观的写操作不加这个锁
+  // 已经不在树中、但因为被pin住而没能从缓冲池中删除的page
+  std::mutex pending_deletes_latch_;
+  std::vector<page_id_t> pending_deletes_;
   // bool root_is_latched_;   // static thread_local
   // std::mutex latch_;  // DEBUG
 };
@@ -13,6 +13,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "storage/index/b_plus_tree.h"
@@ -25,7 +26,12 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager);
+  /**
+   * @param metadata the metadata of the index
+   * @param buffer_pool_manager the buffer pool manager
+   * @param file_id the data file of the pages of the index
+   */
+  BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager, file_id_t file_id = 0);
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
@@ -33,6 +39,13 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /**
+   * Load the entries of the table into this empty index bottom-up, instead of inserting them one by one.
+   * @param entries the keys and values, in any order; they are sorted, and only the first entry of a key is kept like
+   * InsertEntry does
+   */
+  void BulkLoad(std::vector<std::pair<KeyType, ValueType>> *entries);
+
   INDEXITERATOR_TYPE GetBeginIterator();
 
   INDEXITERATOR_TYPE GetBeginIterator(const KeyType &key);
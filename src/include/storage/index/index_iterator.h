@@ -14,6 +14,7 @@
  */
 #pragma once
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -25,8 +26,8 @@ class IndexIterator {
 
  public:
   // you may define your own constructor based on your member variables
-  IndexIterator(BufferPoolManager *bpm, Page *page, int index);
-  ~IndexIterator();
+  // guard持有当前leaf的pin和读锁，迭代器析构时自动释放
+  IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index, size_t read_ahead_pages = READ_AHEAD_PAGES);
 
   bool isEnd();
 
@@ -39,12 +40,19 @@ class IndexIterator {
   bool operator!=(const IndexIterator &itr) const;
 
  private:
+  /** Follows the linked list of leaf pages, for BufferPoolManager::PrefetchPage. */
+  static page_id_t NextLeafPageId(Page *page) { return reinterpret_cast<LeafPage *>(page->GetData())->GetNextPageId(); }
+
+  /** Prefetch the leaves that follow the current one. */
+  void ReadAhead();
+
   // add your own private member variables here
   // 注意：确保成员出现在构造函数的初始化列表中的顺序与它们在类中出现的顺序相同
   BufferPoolManager *buffer_pool_manager_;
-  Page *page_;
+  ReadPageGuard guard_;
   int index_;
-  LeafPage *leaf_;
+  const LeafPage *leaf_;
+  size_t read_ahead_pages_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// integer_key.h
+//
+// Identification: src/include/storage/index/integer_key.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * Integer key is used for indexing a single INTEGER (IntType = int32_t) or BIGINT (IntType = int64_t) column.
+ *
+ * Unlike GenericKey, it holds the value itself, so that comparing two keys needs neither the key schema nor
+ * deserializing them into Values.
+ */
+template <typename IntType>
+class IntegerKey {
+ public:
+  // the key tuple has the column inlined at offset 0
+  inline void SetFromKey(const Tuple &tuple) { memcpy(&value_, tuple.GetData(), sizeof(IntType)); }
+
+  // NOTE: for test purpose only
+  inline void SetFromInteger(int64_t key) { value_ = static_cast<IntType>(key); }
+
+  // NOTE: for test purpose only
+  inline int64_t ToString() const { return value_; }
+
+  // NOTE: for test purpose only
+  friend std::ostream &operator<<(std::ostream &os, const IntegerKey &key) {
+    os << key.ToString();
+    return os;
+  }
+
+  IntType value_;
+};
+
+/**
+ * Function object returns < 0 if lhs < rhs, 0 if lhs = rhs, > 0 if lhs > rhs, used for trees
+ */
+template <typename IntType>
+class IntegerComparator {
+ public:
+  // branch-free: the two comparisons compile to setcc instead of jumps, which a binary search over random keys
+  // mispredicts half of the time
+  inline int operator()(const IntegerKey<IntType> &lhs, const IntegerKey<IntType> &rhs) const {
+    return static_cast<int>(lhs.value_ > rhs.value_) - static_cast<int>(lhs.value_ < rhs.value_);
+  }
+
+  // constructor, the key schema is not needed but taken like GenericComparator so that BPlusTreeIndex builds either
+  explicit IntegerComparator(Schema * /*key_schema*/) {}
+};
+
+}  // namespace bustub
@@ -58,8 +58,11 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                          BufferPoolManager *buffer_pool_manager);
 
+  // append size children and adopt them, used by bulk load too: their keys must be sorted and greater than the keys
+  // of this page
+  void CopyNFrom(const MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
+
  private:
-  void CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
   void CopyLastFrom(const MappingType &item, BufferPoolManager *buffer_pool_manager);
   void CopyFirstFrom(const MappingType &item, BufferPoolManager *buffer_pool_manager);
   MappingType array[0];  // std::pair<KeyType, ValueType>
@@ -12,10 +12,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
 #include "common/config.h"
+#include "common/macros.h"
 #include "common/rwlatch.h"
 
 namespace bustub {
@@ -26,23 +28,36 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The page data is not stored inline: the pages of a buffer pool point into one page-aligned FrameArena, so that the
+ * book-keeping of all frames is a compact array of cache-line-aligned Page objects.
  */
-class Page {
+class alignas(64) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class FrameArena;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor of a page outside of a buffer pool, which allocates its own data. Zeros out the page data. */
+  Page() : data_(new char[PAGE_SIZE]), owns_data_(true) { ResetMemory(); }
 
-  /** Default destructor. */
-  ~Page() = default;
+  /** Destructor. */
+  ~Page() {
+    if (owns_data_) {
+      delete[] data_;
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(Page);
 
   /** @return the actual data contained within this page */
   inline char *GetData() { return data_; }
 
+  /** @return the actual data contained within this page, read-only */
+  inline const char *GetData() const { return data_; }
+
   /** @return the page id of this page */
-  inline page_id_t GetPageId() { return page_id_; }
+  inline page_id_t GetPageId() const { return page_id_; }
 
   /** @return the pin count of this page */
   inline int GetPinCount() { return pin_count_; }
@@ -51,10 +66,17 @@ class Page {
   inline bool IsDirty() { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -62,6 +84,20 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Optimistic reads: read the version, read the page without any latch, then validate the version. The version is
+   * odd while the page is write latched and changes on every write latch, so the data read is consistent only if the
+   * version was even and is still the same. The caller must keep the page pinned.
+   * @return the version of the page
+   */
+  inline uint64_t GetVersion() const { return version_.load(std::memory_order_acquire); }
+
+  /** @return true if the page has not been write latched since GetVersion returned version */
+  inline bool ValidateVersion(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN(log sequence number type). */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -77,19 +113,26 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /** Constructor of a buffer pool frame, whose data lives in a FrameArena and is already zeroed. */
+  explicit Page(char *data) : data_(data) {}
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }  // 将data_的PAGE_SIZE个字节填充为0
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** The actual data that is stored within a page, PAGE_SIZE bytes. */
+  char *data_;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
   int pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   bool is_dirty_ = false;
+  /** True if data_ was allocated by this page rather than by a FrameArena. */
+  bool owns_data_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Incremented when the write latch is acquired and when it is released. */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
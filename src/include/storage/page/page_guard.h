@@ -0,0 +1,202 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard owns one pin of a page: the page is unpinned when the guard is destroyed or dropped.
+ * The page is unpinned dirty only if its data was accessed through one of the mutable accessors (GetDataMut, AsMut),
+ * so a caller can no longer forget to unpin, nor mark a page dirty that it only read.
+ *
+ * As<T> and AsMut<T> view the page as T: Page subclasses (e.g. TablePage) are the page itself, any other type (e.g.
+ * BPlusTreeLeafPage) overlays the page data.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /** @param page a page pinned by the caller, or nullptr for an empty guard */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+
+  /** Takes over the pin of that guard, which becomes empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Unpins the page of this guard, then takes over the pin of that guard, which becomes empty. */
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpins the page now, the guard becomes empty. Does nothing on an empty guard. */
+  void Drop();
+
+  /** Latches the page for reading and transfers the pin to the returned guard, this guard becomes empty. */
+  ReadPageGuard UpgradeRead();
+
+  /** Latches the page for writing and transfers the pin to the returned guard, this guard becomes empty. */
+  WritePageGuard UpgradeWrite();
+
+  /** @return false if the guard is empty, e.g. because the buffer pool had no frame for the page */
+  bool IsValid() const { return page_ != nullptr; }
+
+  page_id_t PageId() const { return page_->GetPageId(); }
+
+  /** @return the version of the page, for reading the page without a latch (see Page::GetVersion) */
+  uint64_t Version() const { return page_->GetVersion(); }
+
+  /** @return true if the page has not been write latched since Version returned version */
+  bool ValidateVersion(uint64_t version) const { return page_->ValidateVersion(version); }
+
+  const char *GetData() const { return page_->GetData(); }
+
+  /** @return the page data, the page will be unpinned dirty */
+  char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  template <class T>
+  const T *As() const {
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<const T *>(page_);
+    } else {
+      return reinterpret_cast<const T *>(page_->GetData());
+    }
+  }
+
+  /** @return the page viewed as T, the page will be unpinned dirty */
+  template <class T>
+  T *AsMut() {
+    is_dirty_ = true;
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+ private:
+  friend class BufferPoolManager;
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard owns one pin and the read latch of a page, both are released when the guard is destroyed or dropped.
+ * It only gives read access to the page, so the page is never unpinned dirty.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /** @param page a page pinned and read latched by the caller, or nullptr for an empty guard */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** Releases the page of this guard, then takes over the page of that guard, which becomes empty. */
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Unlatches and unpins the page now, the guard becomes empty. Does nothing on an empty guard. */
+  void Drop();
+
+  bool IsValid() const { return guard_.IsValid(); }
+
+  page_id_t PageId() const { return guard_.PageId(); }
+
+  /** @return true if the page has not been write latched since BasicPageGuard::Version returned version */
+  bool ValidateVersion(uint64_t version) const { return guard_.ValidateVersion(version); }
+
+  const char *GetData() const { return guard_.GetData(); }
+
+  template <class T>
+  const T *As() const {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard owns one pin and the write latch of a page, both are released when the guard is destroyed or
+ * dropped. The page is unpinned dirty only if one of the mutable accessors was used.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /** @param page a page pinned and write latched by the caller, or nullptr for an empty guard */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** Releases the page of this guard, then takes over the page of that guard, which becomes empty. */
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Unlatches and unpins the page now, the guard becomes empty. Does nothing on an empty guard. */
+  void Drop();
+
+  bool IsValid() const { return guard_.IsValid(); }
+
+  page_id_t PageId() const { return guard_.PageId(); }
+
+  const char *GetData() const { return guard_.GetData(); }
+
+  /** @return the page data, the page will be unpinned dirty */
+  char *GetDataMut() { return guard_.GetDataMut(); }
+
+  template <class T>
+  const T *As() const {
+    return guard_.As<T>();
+  }
+
+  /** @return the page viewed as T, the page will be unpinned dirty */
+  template <class T>
+  T *AsMut() {
+    return guard_.AsMut<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
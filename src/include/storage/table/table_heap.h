@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -35,7 +37,7 @@ class TableHeap {
    * @param buffer_pool_manager the buffer pool manager
    * @param lock_manager the lock manager
    * @param log_manager the log manager
-   * @param first_page_id the id of the first page
+   * @param first_page_id the id of the first page, the new pages of the table go to the data file of this page
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
             page_id_t first_page_id);
@@ -46,9 +48,10 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param txn the creating transaction
+   * @param file_id the data file of the pages of the table
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            Transaction *txn);
+            Transaction *txn, file_id_t file_id = 0);
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
@@ -99,8 +102,13 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
-  /** @return the begin iterator of this table */
-  TableIterator Begin(Transaction *txn);
+  /**
+   * @param txn the transaction performing the scan
+   * @param strategy if not nullptr, the iterator reads the pages of the table through this buffer access strategy, so
+   * that a scan of a large table does not flush the buffer pool
+   * @return the begin iterator of this table
+   */
+  TableIterator Begin(Transaction *txn, const std::shared_ptr<BufferAccessStrategy> &strategy = nullptr);
 
   /** @return the end iterator of this table */
   TableIterator End();
@@ -108,11 +116,17 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /** @param read_ahead_pages the number of pages the iterators of this table prefetch ahead, 0 disables read-ahead */
+  inline void SetReadAheadPages(size_t read_ahead_pages) { read_ahead_pages_ = read_ahead_pages; }
+
  private:
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  /** The segment the new pages of this table are allocated in, so that the pages of the table stay contiguous. */
+  segment_id_t segment_;
+  size_t read_ahead_pages_{READ_AHEAD_PAGES};
 };
 
 }  // namespace bustub
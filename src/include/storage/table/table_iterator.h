@@ -13,7 +13,9 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -21,6 +23,7 @@
 namespace bustub {
 
 class TableHeap;
+class TablePage;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
@@ -29,10 +32,15 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        read_ahead_page_id_(other.read_ahead_page_id_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,13 +60,22 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    read_ahead_page_id_ = other.read_ahead_page_id_;
     return *this;
   }
 
  private:
+  /** Prefetch the pages that follow the given page, unless that was already done for this page. */
+  void ReadAhead(const TablePage *page);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The buffer access strategy pages are read with, nullptr to use the whole buffer pool. */
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  /** The last page whose successors were prefetched. */
+  page_id_t read_ahead_page_id_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
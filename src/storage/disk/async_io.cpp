@@ -0,0 +1,400 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io.cpp
+//
+// Identification: src/storage/disk/async_io.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_io.h"
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "common/exception.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define BUSTUB_HAVE_IO_URING
+#endif
+
+namespace bustub {
+
+ssize_t ReadFully(int fd, char *data, size_t size, int64_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = pread(fd, data + done, size - done, offset + done);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n == -1) {
+      return -1;
+    }
+    if (n == 0) {
+      break;
+    }
+    done += n;
+  }
+  return done;
+}
+
+ssize_t WriteFully(int fd, const char *data, size_t size, int64_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = pwrite(fd, data + done, size - done, offset + done);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n == -1) {
+      return -1;
+    }
+    done += n;
+  }
+  return done;
+}
+
+/*
+ * IOThreadPool
+ */
+
+IOThreadPool::IOThreadPool(size_t num_threads) {
+  for (size_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back(&IOThreadPool::WorkerLoop, this);
+  }
+}
+
+IOThreadPool::~IOThreadPool() {
+  {
+    std::scoped_lock lock{latch_};
+    running_ = false;
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void IOThreadPool::Post(std::function<void()> job) {
+  {
+    std::scoped_lock lock{latch_};
+    jobs_.push_back(std::move(job));
+  }
+  cv_.notify_one();
+}
+
+void IOThreadPool::WorkerLoop() {
+  std::unique_lock lock{latch_};
+  while (true) {
+    cv_.wait(lock, [&] { return !running_ || !jobs_.empty(); });
+    if (jobs_.empty()) {
+      return;
+    }
+    std::function<void()> job = std::move(jobs_.front());
+    jobs_.pop_front();
+    lock.unlock();
+    job();
+    lock.lock();
+  }
+}
+
+/*
+ * AsyncIOContext
+ */
+
+void AsyncIOContext::SubmitRead(page_id_t first_page_id, size_t num_pages, char *data, uint64_t tag) {
+  WaitForSlot();
+  Submit(false, first_page_id, num_pages, data, tag);
+}
+
+void AsyncIOContext::SubmitWrite(page_id_t first_page_id, size_t num_pages, const char *data, uint64_t tag) {
+  WaitForSlot();
+  *num_writes_ += static_cast<int>(num_pages);
+  // the backends take a mutable buffer for both directions, a write never modifies it
+  Submit(true, first_page_id, num_pages, const_cast<char *>(data), tag);
+}
+
+void AsyncIOContext::Submit(bool is_write, page_id_t first_page_id, size_t num_pages, char *data, uint64_t tag) {
+  int64_t offset;
+  std::shared_ptr<void> owner;
+  int fd = locator_.locate_(first_page_id, &offset, &owner);
+  if (fd == -1) {
+    completed_.push_back({tag, locator_.transfer_(is_write, first_page_id, num_pages, data)});
+    return;
+  }
+  Enqueue(is_write, fd, std::move(owner), offset, data, num_pages * PAGE_SIZE, tag);
+  num_in_flight_++;
+}
+
+size_t AsyncIOContext::Complete(std::vector<AsyncIOCompletion> *completions, size_t min_completions) {
+  size_t count = completed_.size();
+  completions->insert(completions->end(), completed_.begin(), completed_.end());
+  completed_.clear();
+  size_t wait = min_completions > count ? std::min(min_completions - count, num_in_flight_) : 0;
+  size_t size = completions->size();
+  Reap(completions, wait);
+  return count + completions->size() - size;
+}
+
+void AsyncIOContext::WaitForSlot() {
+  if (num_in_flight_ >= queue_depth_) {
+    Reap(&completed_, 1);
+  }
+}
+
+void AsyncIOContext::Drain() {
+  while (num_in_flight_ > 0) {
+    Reap(&completed_, num_in_flight_);
+  }
+}
+
+/*
+ * Thread pool backend: every request is a pread/pwrite job, the jobs post their completion to the context.
+ */
+class ThreadPoolContext : public AsyncIOContext {
+ public:
+  ThreadPoolContext(PageLocator locator, size_t queue_depth, std::atomic<int> *num_writes, IOThreadPool *pool)
+      : AsyncIOContext(std::move(locator), queue_depth, num_writes), pool_(pool) {}
+
+  ~ThreadPoolContext() override { Drain(); }
+
+  AsyncIOBackend GetBackend() const override { return AsyncIOBackend::THREAD_POOL; }
+
+ protected:
+  void Enqueue(bool is_write, int fd, std::shared_ptr<void> owner, int64_t offset, char *data, size_t size,
+               uint64_t tag) override {
+    pool_->Post([this, fd, owner = std::move(owner), is_write, offset, data, size, tag] {
+      ssize_t result;
+      if (is_write) {
+        result = WriteFully(fd, data, size, offset);
+      } else {
+        result = ReadFully(fd, data, size, offset);
+        // the pages past the end of the file read as zeros
+        if (result >= 0 && static_cast<size_t>(result) < size) {
+          memset(data + result, 0, size - result);
+        }
+      }
+      int64_t completion = result >= 0 ? result : -static_cast<int64_t>(errno);
+      // notify under the latch: once the completion is reaped, the context may be destroyed
+      std::scoped_lock lock{latch_};
+      done_.push_back({tag, completion});
+      cv_.notify_one();
+    });
+  }
+
+  void Reap(std::vector<AsyncIOCompletion> *completions, size_t min_completions) override {
+    std::unique_lock lock{latch_};
+    cv_.wait(lock, [&] { return done_.size() >= min_completions; });
+    completions->insert(completions->end(), done_.begin(), done_.end());
+    num_in_flight_ -= done_.size();
+    done_.clear();
+  }
+
+ private:
+  IOThreadPool *pool_;
+  std::mutex latch_;
+  std::condition_variable cv_;
+  /** completed by the pool, not reaped yet, protected by latch_ */
+  std::vector<AsyncIOCompletion> done_;
+};
+
+std::unique_ptr<AsyncIOContext> NewThreadPoolContext(PageLocator locator, size_t queue_depth,
+                                                     std::atomic<int> *num_writes, IOThreadPool *pool) {
+  return std::make_unique<ThreadPoolContext>(std::move(locator), queue_depth, num_writes, pool);
+}
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+/*
+ * io_uring backend, directly on the system calls so that there is no dependency on liburing.
+ * Requests are readv/writev of a single iovec, which every kernel with io_uring supports. Submissions are batched:
+ * the queued requests are handed to the kernel by the next Reap, with the same system call that waits for completions.
+ */
+class IOUringContext : public AsyncIOContext {
+ public:
+  IOUringContext(PageLocator locator, size_t queue_depth, std::atomic<int> *num_writes)
+      : AsyncIOContext(std::move(locator), queue_depth, num_writes), slots_(queue_depth) {
+    for (size_t i = 0; i < queue_depth; i++) {
+      free_slots_.push_back(static_cast<uint32_t>(queue_depth - 1 - i));
+    }
+  }
+
+  ~IOUringContext() override {
+    if (ring_fd_ != -1) {
+      Drain();
+      munmap(sqes_, sqes_size_);
+      if (cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+      }
+      munmap(sq_ring_, sq_ring_size_);
+      close(ring_fd_);
+    }
+  }
+
+  /** @return false if the kernel does not support io_uring */
+  bool Setup() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queue_depth_), &params));
+    if (ring_fd_ == -1) {
+      return false;
+    }
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                  ring_fd_, IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_SQES);
+    if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+      close(ring_fd_);
+      ring_fd_ = -1;
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+    auto *sq = static_cast<char *>(sq_ring_);
+    auto *cq = static_cast<char *>(cq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  AsyncIOBackend GetBackend() const override { return AsyncIOBackend::IO_URING; }
+
+ protected:
+  void Enqueue(bool is_write, int fd, std::shared_ptr<void> owner, int64_t offset, char *data, size_t size,
+               uint64_t tag) override {
+    uint32_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    slots_[slot] = {{data, size}, tag, is_write, std::move(owner)};
+
+    // at most queue_depth requests are in flight, the submission queue (at least queue_depth entries) cannot overflow
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&slots_[slot].iov_);
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = slot;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    num_to_submit_++;
+  }
+
+  void Reap(std::vector<AsyncIOCompletion> *completions, size_t min_completions) override {
+    size_t count = 0;
+    while (true) {
+      count += ReapReady(completions);
+      if (count >= min_completions && num_to_submit_ == 0) {
+        return;
+      }
+      unsigned wait = count < min_completions ? static_cast<unsigned>(min_completions - count) : 0;
+      int submitted = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, num_to_submit_, wait,
+                                               wait > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+      if (submitted == -1) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+          continue;
+        }
+        throw Exception("io_uring_enter failed");
+      }
+      num_to_submit_ -= submitted;
+    }
+  }
+
+ private:
+  struct Slot {
+    iovec iov_;
+    uint64_t tag_;
+    bool is_write_;
+    // keeps fd open until the request completes
+    std::shared_ptr<void> owner_;
+  };
+
+  /** Collect the completions the kernel has posted, without waiting. */
+  size_t ReapReady(std::vector<AsyncIOCompletion> *completions) {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    size_t count = 0;
+    for (; head != tail; head++, count++) {
+      io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+      auto slot = static_cast<uint32_t>(cqe->user_data);
+      Slot &request = slots_[slot];
+      // the pages past the end of the file read as zeros
+      if (!request.is_write_ && cqe->res >= 0 && static_cast<size_t>(cqe->res) < request.iov_.iov_len) {
+        memset(static_cast<char *>(request.iov_.iov_base) + cqe->res, 0, request.iov_.iov_len - cqe->res);
+      }
+      completions->push_back({request.tag_, cqe->res});
+      request.owner_.reset();
+      free_slots_.push_back(slot);
+      num_in_flight_--;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return count;
+  }
+
+  int ring_fd_ = -1;
+  void *sq_ring_ = nullptr;
+  void *cq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+  unsigned *sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned *sq_array_ = nullptr;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+  /** requests queued in the submission queue but not handed to the kernel yet */
+  unsigned num_to_submit_ = 0;
+  /** one slot per request in flight, the iovec must stay valid until the request completes */
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_slots_;
+};
+
+std::unique_ptr<AsyncIOContext> NewIOUringContext(PageLocator locator, size_t queue_depth,
+                                                  std::atomic<int> *num_writes) {
+  auto context = std::make_unique<IOUringContext>(std::move(locator), queue_depth, num_writes);
+  if (!context->Setup()) {
+    return nullptr;
+  }
+  return context;
+}
+
+#else
+
+std::unique_ptr<AsyncIOContext> NewIOUringContext(__attribute__((unused)) PageLocator locator,
+                                                  __attribute__((unused)) size_t queue_depth,
+                                                  __attribute__((unused)) std::atomic<int> *num_writes) {
+  return nullptr;
+}
+
+#endif
+
+}  // namespace bustub
@@ -10,115 +10,647 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cerrno>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <shared_mutex>
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/lz_codec.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+// pages tracked by one block of the free space map, and the 64-bit words of the block
+static constexpr page_id_t FSM_BLOCK_PAGES = PAGE_SIZE * 8;
+static constexpr size_t FSM_BLOCK_WORDS = PAGE_SIZE / sizeof(uint64_t);
+
 /**
- * Constructor: open/create a single database file & log file
+ * Constructor: open/create the database file, its data files & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io, uint32_t extent_pages)
+    : log_fd_(-1),
+      file_name_(db_file),
+      files_(MAX_DATA_FILES),
+      extent_pages_(static_cast<page_id_t>(extent_pages)),
+      next_segment_id_(0),
+      sync_policy_(SyncPolicy::ON_CHECKPOINT),
+      num_unsynced_pages_(0),
+      num_data_syncs_(0),
+      num_log_syncs_(0),
+      num_flushes_(0),
+      num_writes_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
+  log_name_ = ReplaceExtension(file_name_, ".log");
+  directory_name_ = ReplaceExtension(file_name_, ".files");
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
+  // create the file if it does not exist, every write appends to it
+  log_fd_ = open(log_name_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (log_fd_ == -1) {
+    throw Exception("can't open dblog file");
   }
 
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  files_[0] = OpenDataFile(db_file, direct_io);
+  // the other data files, one "<file id> <file name>" line each
+  std::ifstream directory(directory_name_);
+  std::string line;
+  while (std::getline(directory, line)) {
+    std::string::size_type space = line.find(' ');
+    if (space == std::string::npos) {
+      continue;
     }
+    file_id_t file_id = std::stoi(line.substr(0, space));
+    if (file_id <= 0 || file_id >= MAX_DATA_FILES) {
+      throw Exception("invalid data file directory");
+    }
+    files_[file_id] = OpenDataFile(line.substr(space + 1), direct_io);
   }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  if (log_fd_ != -1) {
+    close(log_fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  db_io_.close();
-  log_io_.close();
+  for (auto &file : files_) {
+    if (file != nullptr) {
+      CloseDataFile(file.get());
+    }
+  }
+  if (log_fd_ != -1) {
+    close(log_fd_);
+    log_fd_ = -1;
+  }
+}
+
+std::string DiskManager::ReplaceExtension(const std::string &file_name, const std::string &extension) {
+  std::string::size_type n = file_name.rfind('.');
+  return (n == std::string::npos ? file_name : file_name.substr(0, n)) + extension;
+}
+
+std::unique_ptr<DiskManager::DataFile> DiskManager::OpenDataFile(const std::string &file_name, bool direct_io,
+                                                                 bool compressed) {
+  auto file = std::make_unique<DataFile>();
+  file->name_ = file_name;
+  file->fsm_name_ = ReplaceExtension(file_name, ".fsm");
+  file->map_name_ = ReplaceExtension(file_name, ".map");
+  // a data file with a page map is compressed, its slots are not aligned for O_DIRECT
+  file->compressed_ = compressed || GetFileSize(file->map_name_) != -1;
+  direct_io = direct_io && !file->compressed_;
+  // create the file if it does not exist
+  file->fd_ = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (file->fd_ == -1) {
+    throw Exception("can't open db file");
+  }
+#ifdef O_DIRECT
+  if (direct_io) {
+    // Some file systems refuse O_DIRECT when the flag is set, others only on the first transfer: probe with an
+    // aligned read, and stay on buffered I/O if either fails
+    int flags = fcntl(file->fd_, F_GETFL);
+    if (flags != -1 && fcntl(file->fd_, F_SETFL, flags | O_DIRECT) != -1) {
+      char *probe = static_cast<char *>(::operator new[](PAGE_SIZE, std::align_val_t{PAGE_SIZE}));
+      file->direct_io_ = pread(file->fd_, probe, PAGE_SIZE, 0) != -1;
+      ::operator delete[](probe, std::align_val_t{PAGE_SIZE});
+      if (!file->direct_io_) {
+        fcntl(file->fd_, F_SETFL, flags);
+      }
+    }
+    if (!file->direct_io_) {
+      LOG_INFO("O_DIRECT is not supported for %s, using buffered I/O", file_name.c_str());
+    }
+  }
+#endif
+  if (file->compressed_) {
+    file->map_fd_ = open(file->map_name_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file->map_fd_ == -1) {
+      CloseDataFile(file.get());
+      throw Exception("can't open page map file");
+    }
+    LoadPageMap(file.get());
+  }
+  file->fsm_fd_ = open(file->fsm_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (file->fsm_fd_ == -1) {
+    CloseDataFile(file.get());
+    throw Exception("can't open free space map file");
+  }
+  LoadFreeSpaceMap(file.get());
+  return file;
+}
+
+void DiskManager::CloseDataFile(DataFile *file) {
+  if (file->fd_ != -1) {
+    close(file->fd_);
+    file->fd_ = -1;
+  }
+  if (file->fsm_fd_ != -1) {
+    close(file->fsm_fd_);
+    file->fsm_fd_ = -1;
+  }
+  if (file->map_fd_ != -1) {
+    close(file->map_fd_);
+    file->map_fd_ = -1;
+  }
+}
+
+file_id_t DiskManager::CreateDataFile(const std::string &file_name, bool compressed) {
+  std::scoped_lock lock{alloc_latch_};
+  file_id_t file_id = 1;
+  while (file_id < MAX_DATA_FILES && files_[file_id] != nullptr) {
+    file_id++;
+  }
+  if (file_id == MAX_DATA_FILES) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "too many data files");
+  }
+  std::string name = file_name;
+  if (name.empty()) {
+    name = ReplaceExtension(file_name_, "." + std::to_string(file_id) + ".db");
+  }
+  // a new data file is empty, whatever a file of the same name held
+  unlink(name.c_str());
+  unlink(ReplaceExtension(name, ".fsm").c_str());
+  unlink(ReplaceExtension(name, ".map").c_str());
+  std::shared_ptr<DataFile> file = OpenDataFile(name, files_[0]->direct_io_, compressed);
+  {
+    std::scoped_lock files_lock{files_latch_};
+    files_[file_id] = std::move(file);
+  }
+  WriteDataFileDirectory();
+  return file_id;
+}
+
+void DiskManager::DropDataFile(file_id_t file_id) {
+  std::scoped_lock lock{alloc_latch_};
+  if (file_id <= 0 || file_id >= MAX_DATA_FILES || files_[file_id] == nullptr) {
+    return;
+  }
+  std::shared_ptr<DataFile> file;
+  {
+    std::scoped_lock files_lock{files_latch_};
+    file = std::move(files_[file_id]);
+  }
+  WriteDataFileDirectory();
+  // the files are closed by the last page I/O still running on them, unlinking them does not disturb it
+  unlink(file->name_.c_str());
+  unlink(file->fsm_name_.c_str());
+  if (file->compressed_) {
+    unlink(file->map_name_.c_str());
+  }
+  // forget the segments of the file, so that they do not allocate in a later file with the same id
+  for (auto iter = segment_files_.begin(); iter != segment_files_.end();) {
+    if (iter->second == file_id) {
+      segment_free_pages_.erase(iter->first);
+      iter = segment_files_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+void DiskManager::TruncateDataFile(file_id_t file_id) {
+  std::scoped_lock lock{alloc_latch_};
+  DataFile *file = file_id >= 0 && file_id < MAX_DATA_FILES ? files_[file_id].get() : nullptr;
+  if (file == nullptr) {
+    return;
+  }
+  if (ftruncate(file->fd_, 0) != 0 || ftruncate(file->fsm_fd_, 0) != 0) {
+    LOG_DEBUG("I/O error while truncating a data file");
+  }
+  file->allocated_.clear();
+  file->free_pages_.clear();
+  file->next_page_id_ = 0;
+  file->extent_owners_.clear();
+  if (file->compressed_) {
+    std::unique_lock map_lock{file->map_latch_};
+    if (ftruncate(file->map_fd_, 0) != 0) {
+      LOG_DEBUG("I/O error while truncating a page map");
+    }
+    file->page_slots_.clear();
+    file->free_slots_.clear();
+    file->free_slots_by_size_.clear();
+    file->next_slot_ = 0;
+  }
+  for (auto &[segment, segment_file_id] : segment_files_) {
+    if (segment_file_id == file_id) {
+      segment_free_pages_.erase(segment);
+    }
+  }
+}
+
+bool DiskManager::HasDataFile(file_id_t file_id) {
+  std::scoped_lock lock{alloc_latch_};
+  return file_id >= 0 && file_id < MAX_DATA_FILES && files_[file_id] != nullptr;
+}
+
+bool DiskManager::IsCompressed(file_id_t file_id) {
+  std::scoped_lock lock{alloc_latch_};
+  return file_id >= 0 && file_id < MAX_DATA_FILES && files_[file_id] != nullptr && files_[file_id]->compressed_;
+}
+
+int64_t DiskManager::GetDataFileSize(file_id_t file_id) {
+  std::scoped_lock lock{alloc_latch_};
+  struct stat stat_buf;
+  if (file_id < 0 || file_id >= MAX_DATA_FILES || files_[file_id] == nullptr ||
+      fstat(files_[file_id]->fd_, &stat_buf) != 0) {
+    return 0;
+  }
+  return static_cast<int64_t>(stat_buf.st_size);
+}
+
+void DiskManager::WriteDataFileDirectory() {
+  std::string contents;
+  for (file_id_t file_id = 1; file_id < MAX_DATA_FILES; file_id++) {
+    if (files_[file_id] != nullptr) {
+      contents += std::to_string(file_id) + " " + files_[file_id]->name_ + "\n";
+    }
+  }
+  // write a new directory and rename it over the old one, so that a crash leaves one or the other
+  std::string temp_name = directory_name_ + ".tmp";
+  int fd = open(temp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    throw Exception("can't write data file directory");
+  }
+  bool written = WriteFully(fd, contents.data(), contents.size(), 0) != -1 && fdatasync(fd) == 0;
+  close(fd);
+  if (!written || rename(temp_name.c_str(), directory_name_.c_str()) != 0) {
+    throw Exception("can't write data file directory");
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
+  std::shared_ptr<DataFile> file = GetDataFile(page_id);
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
+  bool written =
+      file != nullptr && (file->compressed_ ? WriteCompressedPage(file.get(), GetPageNumber(page_id), page_data)
+                                            : WriteAt(file.get(), page_data, PAGE_SIZE, PageOffset(page_id)) != -1);
   // check for I/O error
-  if (db_io_.bad()) {
+  if (!written) {
+    LOG_DEBUG("I/O error while writing");
+  }
+  SyncAfterPageWrites(file.get(), 1);
+}
+
+/**
+ * pwritev until all the buffers are written, retrying short writes
+ * @return: false on an I/O error
+ */
+static bool WriteVectorFully(int fd, struct iovec *iov, int iov_count, int64_t offset) {
+  while (iov_count > 0) {
+    ssize_t write_count = pwritev(fd, iov, iov_count, offset);
+    if (write_count == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    offset += write_count;
+    // skip the buffers written completely, and the written part of the next one
+    while (iov_count > 0 && static_cast<size_t>(write_count) >= iov->iov_len) {
+      write_count -= iov->iov_len;
+      iov++;
+      iov_count--;
+    }
+    if (iov_count > 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + write_count;
+      iov->iov_len -= write_count;
+    }
+  }
+  return true;
+}
+
+/**
+ * Write the contents of consecutive pages into disk file, with one vectored write per IOV_MAX pages
+ */
+void DiskManager::WritePages(page_id_t first_page_id, const char *const *pages, size_t num_pages) {
+  std::shared_ptr<DataFile> file = GetDataFile(first_page_id);
+  if (file == nullptr) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  // the pages of a compressed file have slots of their own
+  if (file->compressed_) {
+    num_writes_ += static_cast<int>(num_pages);
+    for (size_t i = 0; i < num_pages; i++) {
+      if (!WriteCompressedPage(file.get(), GetPageNumber(first_page_id) + static_cast<page_id_t>(i), pages[i])) {
+        LOG_DEBUG("I/O error while writing");
+      }
+    }
+    SyncAfterPageWrites(file.get(), num_pages);
+    return;
+  }
+  // in direct I/O mode a page that is not aligned goes through the bounce buffer of WritePage
+  for (size_t i = 0; file->direct_io_ && i < num_pages; i++) {
+    if (reinterpret_cast<uintptr_t>(pages[i]) % PAGE_SIZE != 0) {
+      for (size_t j = 0; j < num_pages; j++) {
+        WritePage(first_page_id + static_cast<page_id_t>(j), pages[j]);
+      }
+      return;
+    }
+  }
+  num_writes_ += static_cast<int>(num_pages);
+  std::vector<struct iovec> iov(std::min<size_t>(num_pages, IOV_MAX));
+  for (size_t begin = 0; begin < num_pages; begin += iov.size()) {
+    size_t count = std::min(iov.size(), num_pages - begin);
+    for (size_t i = 0; i < count; i++) {
+      iov[i].iov_base = const_cast<char *>(pages[begin + i]);
+      iov[i].iov_len = PAGE_SIZE;
+    }
+    if (!WriteVectorFully(file->fd_, iov.data(), static_cast<int>(count),
+                          PageOffset(first_page_id + static_cast<page_id_t>(begin)))) {
+      LOG_DEBUG("I/O error while writing");
+    }
+  }
+  SyncAfterPageWrites(file.get(), num_pages);
+}
+
+/**
+ * fdatasync is enough: the only metadata a page write changes is the size of the file, which fdatasync syncs too
+ */
+void DiskManager::SyncDataFile() {
+  num_unsynced_pages_ = 0;
+  num_data_syncs_ += 1;
+  std::vector<std::shared_ptr<DataFile>> files;
+  {
+    std::shared_lock lock{files_latch_};
+    files = files_;
+  }
+  for (auto &file : files) {
+    if (file != nullptr && file->fd_ != -1 && !SyncFiles(file.get())) {
+      LOG_DEBUG("I/O error while syncing the db file");
+    }
+  }
+}
+
+bool DiskManager::SyncFiles(DataFile *file) {
+  // the allocation bitmap must not lag behind the pages, or a page in use could be allocated again after a crash
+  return fdatasync(file->fd_) == 0 && (file->map_fd_ == -1 || fdatasync(file->map_fd_) == 0) &&
+         (file->fsm_fd_ == -1 || fdatasync(file->fsm_fd_) == 0);
+}
+
+void DiskManager::SyncAfterPageWrites(DataFile *file, size_t num_pages) {
+  switch (sync_policy_) {
+    case SyncPolicy::PER_WRITE:
+      // only the file that was written
+      num_data_syncs_ += 1;
+      if (file != nullptr && !SyncFiles(file)) {
+        LOG_DEBUG("I/O error while syncing the db file");
+      }
+      break;
+    case SyncPolicy::GROUP:
+      // the writer that fills the group syncs it, for the writes of every thread
+      if (num_unsynced_pages_.fetch_add(num_pages) + num_pages >= static_cast<size_t>(SYNC_GROUP_PAGES)) {
+        SyncDataFile();
+      }
+      break;
+    case SyncPolicy::ON_CHECKPOINT:
+      break;
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
+  std::shared_ptr<DataFile> file = GetDataFile(page_id);
+  if (file != nullptr && file->compressed_) {
+    if (!ReadCompressedPage(file.get(), GetPageNumber(page_id), page_data)) {
       LOG_DEBUG("I/O error while reading");
-      return;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    return;
+  }
+  ssize_t read_count = file == nullptr ? -1 : ReadAt(file.get(), page_data, PAGE_SIZE, PageOffset(page_id));
+  if (read_count == -1) {
+    LOG_DEBUG("I/O error while reading");
+    return;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+}
+
+/**
+ * Read the contents of consecutive pages into the given memory area, with one positional read
+ */
+void DiskManager::ReadPages(page_id_t first_page_id, size_t num_pages, char *data) {
+  std::shared_ptr<DataFile> file = GetDataFile(first_page_id);
+  if (file != nullptr && file->compressed_) {
+    for (size_t i = 0; i < num_pages; i++) {
+      page_id_t page_number = GetPageNumber(first_page_id) + static_cast<page_id_t>(i);
+      if (!ReadCompressedPage(file.get(), page_number, data + i * PAGE_SIZE)) {
+        LOG_DEBUG("I/O error while reading");
+      }
     }
+    return;
+  }
+  size_t size = num_pages * PAGE_SIZE;
+  ssize_t read_count = file == nullptr ? -1 : ReadAt(file.get(), data, size, PageOffset(first_page_id));
+  if (read_count == -1) {
+    LOG_DEBUG("I/O error while reading");
+    return;
+  }
+  // the pages past the end of the file read as zeros
+  if (static_cast<size_t>(read_count) < size) {
+    memset(data + read_count, 0, size - read_count);
+  }
+}
+
+ssize_t DiskManager::ReadAt(DataFile *file, char *data, size_t size, int64_t offset) {
+  if (!file->direct_io_ || reinterpret_cast<uintptr_t>(data) % PAGE_SIZE == 0) {
+    return ReadFully(file->fd_, data, size, offset);
+  }
+  char *aligned = static_cast<char *>(::operator new[](size, std::align_val_t{PAGE_SIZE}));
+  ssize_t read_count = ReadFully(file->fd_, aligned, size, offset);
+  if (read_count > 0) {
+    memcpy(data, aligned, read_count);
+  }
+  ::operator delete[](aligned, std::align_val_t{PAGE_SIZE});
+  return read_count;
+}
+
+ssize_t DiskManager::WriteAt(DataFile *file, const char *data, size_t size, int64_t offset) {
+  if (!file->direct_io_ || reinterpret_cast<uintptr_t>(data) % PAGE_SIZE == 0) {
+    return WriteFully(file->fd_, data, size, offset);
+  }
+  char *aligned = static_cast<char *>(::operator new[](size, std::align_val_t{PAGE_SIZE}));
+  memcpy(aligned, data, size);
+  ssize_t write_count = WriteFully(file->fd_, aligned, size, offset);
+  ::operator delete[](aligned, std::align_val_t{PAGE_SIZE});
+  return write_count;
+}
+
+bool DiskManager::ReadCompressedPage(DataFile *file, page_id_t page_number, char *page_data) {
+  std::shared_lock lock{file->map_latch_};
+  if (static_cast<size_t>(page_number) >= file->page_slots_.size() || file->page_slots_[page_number].size_ == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    return true;
+  }
+  PageSlot slot = file->page_slots_[page_number];
+  int64_t offset = static_cast<int64_t>(slot.slot_) * COMPRESSED_SLOT_SIZE;
+  if (slot.size_ == PAGE_SIZE) {
+    return ReadFully(file->fd_, page_data, PAGE_SIZE, offset) == PAGE_SIZE;
+  }
+  char compressed[PAGE_SIZE];
+  if (ReadFully(file->fd_, compressed, slot.size_, offset) != slot.size_) {
+    return false;
+  }
+  // the slot may be reused once the latch is released, but its bytes are read already
+  lock.unlock();
+  return LZDecompress(compressed, slot.size_, page_data, PAGE_SIZE);
+}
+
+bool DiskManager::WriteCompressedPage(DataFile *file, page_id_t page_number, const char *page_data) {
+  // compress before taking the latch, a page that would not save a unit is stored as it is
+  char compressed[PAGE_SIZE];
+  size_t size = LZCompress(page_data, PAGE_SIZE, compressed, PAGE_SIZE - COMPRESSED_SLOT_SIZE);
+  const char *data = compressed;
+  if (size == 0) {
+    size = PAGE_SIZE;
+    data = page_data;
+  }
+  auto num_units = static_cast<uint32_t>((size + COMPRESSED_SLOT_SIZE - 1) / COMPRESSED_SLOT_SIZE);
+
+  std::unique_lock lock{file->map_latch_};
+  if (static_cast<size_t>(page_number) >= file->page_slots_.size()) {
+    file->page_slots_.resize(page_number + 1, PageSlot{0, 0, 0});
+  }
+  PageSlot old_slot = file->page_slots_[page_number];
+  // a page of the same size is written in place, like an uncompressed page: its page map entry does not change. The
+  // others move to the best fitting slot, and the old slot stays intact until the page map on disk points away from
+  // it, a failed write leaves the old page readable. Shrinking in place would also leave the page between the units it
+  // freed and the free slots around it
+  bool in_place = size == old_slot.size_ && num_units == old_slot.num_units_;
+  PageSlot slot{in_place ? old_slot.slot_ : AllocateSlot(file, num_units), static_cast<uint16_t>(num_units),
+                static_cast<uint16_t>(size)};
+  if (WriteFully(file->fd_, data, size, static_cast<int64_t>(slot.slot_) * COMPRESSED_SLOT_SIZE) == -1) {
+    if (!in_place) {
+      FreeSlot(file, slot.slot_, num_units);
+    }
+    return false;
+  }
+  if (in_place) {
+    return true;
+  }
+  // the old slot is freed only once the page map points to the new one
+  if (pwrite(file->map_fd_, &slot, sizeof(PageSlot), static_cast<int64_t>(page_number) * sizeof(PageSlot)) !=
+      sizeof(PageSlot)) {
+    // the page map on disk still points to the old slot, which must not be handed to another page
+    LOG_DEBUG("I/O error while writing the page map");
+    FreeSlot(file, slot.slot_, num_units);
+    return false;
+  }
+  file->page_slots_[page_number] = slot;
+  if (old_slot.num_units_ > 0) {
+    FreeSlot(file, old_slot.slot_, old_slot.num_units_);
+  }
+  return true;
+}
+
+uint32_t DiskManager::AllocateSlot(DataFile *file, uint32_t num_units) {
+  // the smallest free slot that is large enough, its remaining units stay free
+  auto by_size = file->free_slots_by_size_.lower_bound(num_units);
+  if (by_size == file->free_slots_by_size_.end()) {
+    uint32_t slot = file->next_slot_;
+    file->next_slot_ += num_units;
+    return slot;
+  }
+  uint32_t free_units = by_size->first;
+  uint32_t slot = by_size->second;
+  file->free_slots_by_size_.erase(by_size);
+  file->free_slots_.erase(slot);
+  if (free_units > num_units) {
+    file->free_slots_.emplace(slot + num_units, free_units - num_units);
+    file->free_slots_by_size_.emplace(free_units - num_units, slot + num_units);
+  }
+  return slot;
+}
+
+void DiskManager::FreeSlot(DataFile *file, uint32_t slot, uint32_t num_units) {
+  auto remove = [file](std::map<uint32_t, uint32_t>::iterator free_slot) {
+    auto range = file->free_slots_by_size_.equal_range(free_slot->second);
+    for (auto by_size = range.first; by_size != range.second; ++by_size) {
+      if (by_size->second == free_slot->first) {
+        file->free_slots_by_size_.erase(by_size);
+        break;
+      }
+    }
+    return file->free_slots_.erase(free_slot);
+  };
+  // coalesce with the free slots right after and right before it
+  auto next = file->free_slots_.lower_bound(slot);
+  if (next != file->free_slots_.end() && next->first == slot + num_units) {
+    num_units += next->second;
+    next = remove(next);
+  }
+  if (next != file->free_slots_.begin() && std::prev(next)->first + std::prev(next)->second == slot) {
+    slot = std::prev(next)->first;
+    num_units += std::prev(next)->second;
+    remove(std::prev(next));
+  }
+  // a free slot at the end is no slot at all
+  if (slot + num_units == file->next_slot_) {
+    file->next_slot_ = slot;
+    return;
+  }
+  file->free_slots_.emplace(slot, num_units);
+  file->free_slots_by_size_.emplace(num_units, slot);
+}
+
+void DiskManager::LoadPageMap(DataFile *file) {
+  struct stat stat_buf;
+  int64_t map_size = fstat(file->map_fd_, &stat_buf) == 0 ? static_cast<int64_t>(stat_buf.st_size) : 0;
+  file->page_slots_.resize(map_size / sizeof(PageSlot));
+  int64_t size = file->page_slots_.size() * sizeof(PageSlot);
+  if (ReadFully(file->map_fd_, reinterpret_cast<char *>(file->page_slots_.data()), size, 0) != size) {
+    throw Exception("can't read page map file");
+  }
+  // the units in no slot of a page are free
+  std::vector<std::pair<uint32_t, uint32_t>> slots;
+  for (const PageSlot &slot : file->page_slots_) {
+    if (slot.num_units_ > 0) {
+      slots.emplace_back(slot.slot_, slot.num_units_);
+    }
+  }
+  std::sort(slots.begin(), slots.end());
+  file->next_slot_ = slots.empty() ? 0 : slots.back().first + slots.back().second;
+  uint32_t end = 0;
+  for (auto [slot, num_units] : slots) {
+    if (slot > end) {
+      FreeSlot(file, end, slot - end);
+    }
+    end = std::max(end, slot + num_units);
   }
 }
 
@@ -144,15 +676,15 @@ void DiskManager::WriteLog(char *log_data, int size) {
 
   num_flushes_ += 1;
   // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
+  if (WriteFully(log_fd_, log_data, size, GetFileSize(log_name_)) == -1) {
     LOG_DEBUG("I/O error while writing log");
     return;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
+  // the log manager writes the log at commit boundaries (and when its buffer is full): make the commits durable
+  num_log_syncs_ += 1;
+  if (fdatasync(log_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing log");
+  }
   flush_log_ = false;
 }
 
@@ -161,41 +693,301 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-bool DiskManager::ReadLog(char *log_data, int size, int offset) {
+bool DiskManager::ReadLog(char *log_data, int size, int64_t offset) {
   if (offset >= GetFileSize(log_name_)) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
-
-  if (log_io_.bad()) {
+  ssize_t read_count = ReadFully(log_fd_, log_data, size, offset);
+  if (read_count == -1) {
     LOG_DEBUG("I/O error while reading log");
     return false;
   }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
 
   return true;
 }
 
+segment_id_t DiskManager::CreateSegment(file_id_t file_id) {
+  std::scoped_lock lock{alloc_latch_};
+  segment_files_[next_segment_id_] = file_id;
+  return next_segment_id_++;
+}
+
+/** @return the lowest page of the set congruent to residue modulo stride, removed from the set, or INVALID_PAGE_ID */
+static page_id_t TakeFreePage(std::set<page_id_t> *pages, uint32_t stride, uint32_t residue) {
+  for (auto iter = pages->begin(); iter != pages->end(); ++iter) {
+    if (static_cast<uint32_t>(*iter) % stride == residue) {
+      page_id_t page_id = *iter;
+      pages->erase(iter);
+      return page_id;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Deallocated pages are reused first, the file only grows when there is none
+ * The pages of a segment come from its extents, a new extent is taken when they are all allocated
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(uint32_t stride, uint32_t residue, segment_id_t segment) {
+  std::scoped_lock lock{alloc_latch_};
+  file_id_t file_id = 0;
+  if (segment != INVALID_SEGMENT_ID) {
+    auto segment_file = segment_files_.find(segment);
+    if (segment_file == segment_files_.end() || files_[segment_file->second] == nullptr) {
+      throw Exception(ExceptionType::INVALID, "the data file of the segment was dropped");
+    }
+    file_id = segment_file->second;
+  }
+  DataFile *file = files_[file_id].get();
+  // the residue of the page id, not of the page number: the file id is part of the page id
+  residue = (residue + stride - static_cast<uint32_t>(MakePageId(file_id, 0)) % stride) % stride;
+
+  page_id_t page_number = INVALID_PAGE_ID;
+  // an extent holds every residue only if the stride is not larger than the extent
+  if (segment != INVALID_SEGMENT_ID && stride <= static_cast<uint32_t>(extent_pages_)) {
+    std::set<page_id_t> &segment_pages = segment_free_pages_[segment];
+    page_number = TakeFreePage(&segment_pages, stride, residue);
+    if (page_number == INVALID_PAGE_ID) {
+      NewExtent(file, segment);
+      page_number = TakeFreePage(&segment_pages, stride, residue);
+    }
+  } else {
+    page_number = TakeFreePage(&file->free_pages_, stride, residue);
+  }
+  if (page_number == INVALID_PAGE_ID) {
+    // the pages skipped to reach the residue are free for the other residues
+    page_number = file->next_page_id_;
+    while (static_cast<uint32_t>(page_number) % stride != residue) {
+      file->free_pages_.insert(page_number++);
+    }
+    // the file grows into a new extent: reserve all of it
+    if (file->next_page_id_ == 0 || page_number / extent_pages_ != (file->next_page_id_ - 1) / extent_pages_) {
+      Preallocate(file, page_number / extent_pages_ * extent_pages_, extent_pages_);
+    }
+    file->next_page_id_ = page_number + 1;
+  }
+  if (page_number > GetPageNumber(-1)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "data file " + file->name_ + " is full");
+  }
+  SetAllocated(file, page_number, true);
+  return MakePageId(file_id, page_number);
+}
+
+void DiskManager::NewExtent(DataFile *file, segment_id_t segment) {
+  // 1 an extent of the file whose pages have all been deallocated
+  page_id_t first_page_id = INVALID_PAGE_ID;
+  page_id_t run_start = INVALID_PAGE_ID;
+  page_id_t run_end = INVALID_PAGE_ID;
+  for (page_id_t page_id : file->free_pages_) {
+    if (page_id != run_end) {
+      run_start = (page_id + extent_pages_ - 1) / extent_pages_ * extent_pages_;
+    }
+    run_end = page_id + 1;
+    if (run_end - run_start == extent_pages_) {
+      first_page_id = run_start;
+      break;
+    }
+  }
+  if (first_page_id != INVALID_PAGE_ID) {
+    file->free_pages_.erase(file->free_pages_.find(first_page_id),
+                            file->free_pages_.lower_bound(first_page_id + extent_pages_));
+  } else {
+    // 2 otherwise a new extent at the end of the file, the pages skipped to reach an extent boundary are free
+    first_page_id = (file->next_page_id_ + extent_pages_ - 1) / extent_pages_ * extent_pages_;
+    for (page_id_t page_id = file->next_page_id_; page_id < first_page_id; page_id++) {
+      file->free_pages_.insert(page_id);
+    }
+    file->next_page_id_ = first_page_id + extent_pages_;
+    Preallocate(file, first_page_id, extent_pages_);
+  }
+  std::set<page_id_t> &segment_pages = segment_free_pages_[segment];
+  for (page_id_t page_id = first_page_id; page_id < first_page_id + extent_pages_; page_id++) {
+    segment_pages.insert(page_id);
+  }
+  file->extent_owners_[first_page_id] = segment;
+}
+
+void DiskManager::Preallocate(DataFile *file, page_id_t first_page_number, page_id_t num_pages) {
+#ifdef FALLOC_FL_KEEP_SIZE
+  // Only reserves the blocks, in one piece if the file system can: the size of the file is unchanged, so that
+  // GetNumPages still tells how far the file has been written. A compressed file has no place per page to reserve
+  if (!file->compressed_ && num_pages > 1 &&
+      fallocate(file->fd_, FALLOC_FL_KEEP_SIZE, static_cast<int64_t>(first_page_number) * PAGE_SIZE,
+                static_cast<int64_t>(num_pages) * PAGE_SIZE) != 0) {
+    LOG_DEBUG("cannot preallocate the database file");
+  }
+#endif
+}
+
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::scoped_lock lock{alloc_latch_};
+  std::shared_ptr<DataFile> file = GetDataFile(page_id);
+  page_id_t page_number = GetPageNumber(page_id);
+  if (file == nullptr || !TestAllocated(*file, page_number)) {
+    return;
+  }
+  SetAllocated(file.get(), page_number, false);
+  page_id_t first_page_number = page_number / extent_pages_ * extent_pages_;
+  auto owner = file->extent_owners_.find(first_page_number);
+  if (owner == file->extent_owners_.end()) {
+    file->free_pages_.insert(page_number);
+    return;
+  }
+  // the page goes back to its segment, and the extent goes back to the file once all its pages are free
+  std::set<page_id_t> &segment_pages = segment_free_pages_[owner->second];
+  segment_pages.insert(page_number);
+  auto begin = segment_pages.lower_bound(first_page_number);
+  auto end = segment_pages.lower_bound(first_page_number + extent_pages_);
+  if (std::distance(begin, end) == extent_pages_) {
+    file->free_pages_.insert(begin, end);
+    segment_pages.erase(begin, end);
+    file->extent_owners_.erase(owner);
+  }
+}
+
+bool DiskManager::IsAllocated(page_id_t page_id) {
+  std::scoped_lock lock{alloc_latch_};
+  std::shared_ptr<DataFile> file = GetDataFile(page_id);
+  return file != nullptr && TestAllocated(*file, GetPageNumber(page_id));
+}
+
+bool DiskManager::TestAllocated(const DataFile &file, page_id_t page_number) {
+  return page_number >= 0 && static_cast<size_t>(page_number / 64) < file.allocated_.size() &&
+         (file.allocated_[page_number / 64] & (static_cast<uint64_t>(1) << (page_number % 64))) != 0;
+}
+
+void DiskManager::SetAllocated(DataFile *file, page_id_t page_number, bool allocated) {
+  size_t block = page_number / FSM_BLOCK_PAGES;
+  if (file->allocated_.size() < (block + 1) * FSM_BLOCK_WORDS) {
+    file->allocated_.resize((block + 1) * FSM_BLOCK_WORDS, 0);
+  }
+  uint64_t mask = static_cast<uint64_t>(1) << (page_number % 64);
+  if (allocated) {
+    file->allocated_[page_number / 64] |= mask;
+  } else {
+    file->allocated_[page_number / 64] &= ~mask;
+  }
+  WriteFreeSpaceMapBlock(file, block);
+}
+
+void DiskManager::WriteFreeSpaceMapBlock(DataFile *file, size_t block) {
+  ssize_t n = pwrite(file->fsm_fd_, &file->allocated_[block * FSM_BLOCK_WORDS], PAGE_SIZE,
+                     static_cast<int64_t>(block) * PAGE_SIZE);
+  if (n != PAGE_SIZE) {
+    LOG_DEBUG("I/O error while writing the free space map");
+  }
+}
+
+void DiskManager::LoadFreeSpaceMap(DataFile *file) {
+  int64_t num_pages = CountPages(file);
+  int64_t fsm_size = GetFileSize(file->fsm_name_);
+  std::vector<uint64_t> &allocated = file->allocated_;
+  // 1 a new data file, or one whose free space map was lost: every page of the file is allocated
+  if (num_pages == 0 || fsm_size <= 0) {
+    if (ftruncate(file->fsm_fd_, 0) != 0) {
+      LOG_DEBUG("I/O error while truncating the free space map");
+    }
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      allocated.resize((page_id / FSM_BLOCK_PAGES + 1) * FSM_BLOCK_WORDS, 0);
+      allocated[page_id / 64] |= static_cast<uint64_t>(1) << (page_id % 64);
+    }
+    for (size_t block = 0; block * FSM_BLOCK_WORDS < allocated.size(); block++) {
+      WriteFreeSpaceMapBlock(file, block);
+    }
+    file->next_page_id_ = static_cast<page_id_t>(num_pages);
+    return;
+  }
+  // 2 otherwise the free space map is authoritative: the pages up to the last allocated one are either allocated or
+  // free, the pages after it have never been allocated (or were all freed)
+  size_t num_blocks = (fsm_size + PAGE_SIZE - 1) / PAGE_SIZE;
+  allocated.resize(num_blocks * FSM_BLOCK_WORDS, 0);
+  if (ReadFully(file->fsm_fd_, reinterpret_cast<char *>(allocated.data()), fsm_size, 0) != fsm_size) {
+    throw Exception("can't read free space map file");
+  }
+  file->next_page_id_ = 0;
+  for (size_t word = allocated.size(); word > 0; word--) {
+    if (allocated[word - 1] != 0) {
+      file->next_page_id_ = static_cast<page_id_t>((word - 1) * 64 + 64 - __builtin_clzll(allocated[word - 1]));
+      break;
+    }
+  }
+  for (page_id_t page_id = 0; page_id < file->next_page_id_; page_id++) {
+    if ((allocated[page_id / 64] & (static_cast<uint64_t>(1) << (page_id % 64))) == 0) {
+      file->free_pages_.insert(page_id);
+    }
+  }
+}
+
+std::unique_ptr<AsyncIOContext> DiskManager::NewAsyncIOContext(size_t queue_depth, AsyncIOBackend backend) {
+  PageLocator locator;
+  locator.locate_ = [this](page_id_t page_id, int64_t *offset, std::shared_ptr<void> *owner) {
+    std::shared_ptr<DataFile> file = GetDataFile(page_id);
+    *offset = PageOffset(page_id);
+    if (file == nullptr || file->compressed_) {
+      return -1;
+    }
+    int fd = file->fd_;
+    *owner = std::move(file);
+    return fd;
+  };
+  locator.transfer_ = [this](bool is_write, page_id_t first_page_id, size_t num_pages, char *data) -> int64_t {
+    std::shared_ptr<DataFile> file = GetDataFile(first_page_id);
+    if (file == nullptr) {
+      return -EBADF;
+    }
+    for (size_t i = 0; i < num_pages; i++) {
+      page_id_t page_number = GetPageNumber(first_page_id) + static_cast<page_id_t>(i);
+      if (!(is_write ? WriteCompressedPage(file.get(), page_number, data + i * PAGE_SIZE)
+                     : ReadCompressedPage(file.get(), page_number, data + i * PAGE_SIZE))) {
+        return -EIO;
+      }
+    }
+    return static_cast<int64_t>(num_pages * PAGE_SIZE);
+  };
+  if (backend == AsyncIOBackend::IO_URING) {
+    std::unique_ptr<AsyncIOContext> context = NewIOUringContext(locator, queue_depth, &num_writes_);
+    if (context != nullptr) {
+      return context;
+    }
+  }
+  // no io_uring: the requests run on the thread pool, started on first use
+  std::scoped_lock lock{io_pool_latch_};
+  if (io_pool_ == nullptr) {
+    io_pool_ = std::make_unique<IOThreadPool>(ASYNC_IO_THREADS);
+  }
+  return NewThreadPoolContext(locator, queue_depth, &num_writes_, io_pool_.get());
+}
+
+int64_t DiskManager::GetNumPages(file_id_t file_id) {
+  std::shared_ptr<DataFile> file;
+  if (file_id >= 0 && file_id < MAX_DATA_FILES) {
+    std::shared_lock lock{files_latch_};
+    file = files_[file_id];
+  }
+  return file == nullptr ? 0 : CountPages(file.get());
+}
 
 /**
- * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * Returns the number of pages of a data file, a partial last page counts as a page
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+int64_t DiskManager::CountPages(DataFile *file) {
+  if (file->compressed_) {
+    std::shared_lock lock{file->map_latch_};
+    return static_cast<int64_t>(file->page_slots_.size());
+  }
+  struct stat stat_buf;
+  if (fstat(file->fd_, &stat_buf) != 0) {
+    return 0;
+  }
+  return (static_cast<int64_t>(stat_buf.st_size) + PAGE_SIZE - 1) / PAGE_SIZE;
+}
 
 /**
  * Returns number of flushes made so far
@@ -215,10 +1007,10 @@ bool DiskManager::GetFlushState() const { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
 }
 
 }  // namespace bustub
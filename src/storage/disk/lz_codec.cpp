@@ -0,0 +1,179 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_codec.cpp
+//
+// Identification: src/storage/disk/lz_codec.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/lz_codec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace bustub {
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+// a length that does not fit in its 4 bits of the token
+static constexpr size_t LENGTH_MASK = 15;
+static constexpr int HASH_BITS = 12;
+
+static uint32_t Load32(const uint8_t *data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+static uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Append the length bytes of a length of 15 or more. @return false if dst is full */
+static bool PutLength(size_t length, uint8_t **out, const uint8_t *out_end) {
+  for (length -= LENGTH_MASK;; length -= 255) {
+    if (*out == out_end) {
+      return false;
+    }
+    if (length < 255) {
+      *(*out)++ = static_cast<uint8_t>(length);
+      return true;
+    }
+    *(*out)++ = 255;
+  }
+}
+
+/** Add the length bytes that follow a length of 15. @return false if src ends before them */
+static bool GetLength(const uint8_t **in, const uint8_t *in_end, size_t *length) {
+  uint8_t byte;
+  do {
+    if (*in == in_end) {
+      return false;
+    }
+    byte = *(*in)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** Append a sequence, match_length 0 for the last one. @return false if dst is full */
+static bool PutSequence(const uint8_t *literals, size_t num_literals, size_t offset, size_t match_length,
+                        uint8_t **out, const uint8_t *out_end) {
+  uint8_t *op = *out;
+  if (op == out_end) {
+    return false;
+  }
+  uint8_t *token = op++;
+  size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+  *token = static_cast<uint8_t>(std::min(num_literals, LENGTH_MASK) << 4 | std::min(match_code, LENGTH_MASK));
+  if (num_literals >= LENGTH_MASK && !PutLength(num_literals, &op, out_end)) {
+    return false;
+  }
+  if (static_cast<size_t>(out_end - op) < num_literals) {
+    return false;
+  }
+  memcpy(op, literals, num_literals);
+  op += num_literals;
+  if (match_length > 0) {
+    if (out_end - op < 2) {
+      return false;
+    }
+    *op++ = static_cast<uint8_t>(offset & 0xff);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    if (match_code >= LENGTH_MASK && !PutLength(match_code, &op, out_end)) {
+      return false;
+    }
+  }
+  *out = op;
+  return true;
+}
+
+size_t LZCompress(const char *src, size_t size, char *dst, size_t capacity) {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  const uint8_t *out_end = out + capacity;
+  // the last position of every hashed 4-byte sequence, -1 for none
+  int32_t table[1 << HASH_BITS];
+  std::fill(std::begin(table), std::end(table), -1);
+
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= size) {
+    uint32_t sequence = Load32(in + pos);
+    int32_t &entry = table[Hash(sequence)];
+    int32_t candidate = entry;
+    entry = static_cast<int32_t>(pos);
+    if (candidate < 0 || pos - candidate > MAX_OFFSET || Load32(in + candidate) != sequence) {
+      pos++;
+      continue;
+    }
+    size_t match_length = MIN_MATCH;
+    while (pos + match_length < size && in[candidate + match_length] == in[pos + match_length]) {
+      match_length++;
+    }
+    if (!PutSequence(in + anchor, pos - anchor, pos - candidate, match_length, &out, out_end)) {
+      return 0;
+    }
+    pos += match_length;
+    anchor = pos;
+  }
+  if (anchor < size && !PutSequence(in + anchor, size - anchor, 0, 0, &out, out_end)) {
+    return 0;
+  }
+  return out - reinterpret_cast<uint8_t *>(dst);
+}
+
+bool LZDecompress(const char *src, size_t size, char *dst, size_t capacity) {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *in_end = in + size;
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *out_end = out + capacity;
+  while (in < in_end) {
+    uint8_t token = *in++;
+    size_t num_literals = token >> 4;
+    if (num_literals == LENGTH_MASK && !GetLength(&in, in_end, &num_literals)) {
+      return false;
+    }
+    if (static_cast<size_t>(in_end - in) < num_literals || static_cast<size_t>(out_end - out) < num_literals) {
+      return false;
+    }
+    memcpy(out, in, num_literals);
+    in += num_literals;
+    out += num_literals;
+    // the last sequence has no match
+    if (in == in_end) {
+      break;
+    }
+    if (in_end - in < 2) {
+      return false;
+    }
+    size_t offset = in[0] | static_cast<size_t>(in[1]) << 8;
+    in += 2;
+    size_t match_length = token & LENGTH_MASK;
+    if (match_length == LENGTH_MASK && !GetLength(&in, in_end, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(out - reinterpret_cast<uint8_t *>(dst)) ||
+        static_cast<size_t>(out_end - out) < match_length) {
+      return false;
+    }
+    const uint8_t *match = out - offset;
+    if (offset >= match_length) {
+      memcpy(out, match, match_length);
+    } else {
+      // byte by byte: the match overlaps the bytes it produces, e.g. a run of one byte has offset 1
+      for (size_t i = 0; i < match_length; i++) {
+        out[i] = match[i];
+      }
+    }
+    out += match_length;
+  }
+  return out == out_end;
+}
+
+}  // namespace bustub
@@ -9,7 +9,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <functional>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
 
 #include "common/exception.h"
 #include "common/rid.h"
@@ -19,10 +23,11 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, file_id_t file_id)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
+      segment_(buffer_pool_manager->CreateSegment(file_id)),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
       internal_max_size_(internal_max_size) {}
@@ -45,39 +50,39 @@ bool BPLUSTREE_TYPE::IsEmpty() const { return root_page_id_ == INVALID_PAGE_ID;
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
-  // std::scoped_lock lock{latch_};  // DEBUG
-
-  // LOG_INFO("ENTER GetValue key=%ld Thread=%lu", key.ToString(), getThreadId());  // DEBUG
-
-  // bool tmp;
-
-  // 1 先找到leaf page，这里面会调用fetch page
-  // Page *leaf_page = FindLeafPage(key, false, transaction, Operation::FIND, &tmp);  // pin leaf page
-
-  Page *leaf_page = FindLeafPageByOperation(key, Operation::FIND, transaction).first;
+  if (optimistic_reads_) {
+    // 乐观锁耦合：leaf也不加读锁，查找后验证leaf的版本，失败则重新查找
+    OptimisticReadScope scope(this);
+    while (true) {
+      uint64_t version;
+      BasicPageGuard leaf_guard = FindLeafOptimisticRead(key, false, false, &version);
+      if (!leaf_guard.IsValid()) {
+        return false;  // 空树
+      }
+      ValueType value{};
+      bool found = leaf_guard.As<LeafPage>()->Lookup(key, &value, comparator_);
+      if (leaf_guard.ValidateVersion(version)) {
+        if (found) {
+          result->push_back(value);
+        }
+        return found;
+      }
+    }
+  }
 
-  // 2 在leaf page里找这个key
-  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());  // 记得加上GetData()
+  // 1 先找到leaf page，guard持有leaf的pin和读锁
+  ReadPageGuard leaf_guard = FindLeafRead(key);
+  if (!leaf_guard.IsValid()) {
+    return false;  // 空树
+  }
 
+  // 2 在leaf page里找这个key（只读，leaf在guard析构时unlatch并以非dirty状态unpin）
   ValueType value{};
-  bool is_exist = leaf_node->Lookup(key, &value, comparator_);
-
-  // 3 page用完后记得unpin page（疑问：unpin这句话一定要放在这里吗？也就是用完之后马上unpin？）
-  leaf_page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);  // unpin leaf page
-
-  if (!is_exist) {
+  if (!leaf_guard.As<LeafPage>()->Lookup(key, &value, comparator_)) {
     return false;
   }
   result->push_back(value);
   return true;
-
-  // if (is_exist) {
-  // result->push_back(value);  // 将得到的value添加到result中
-  // }
-  // assert(is_exist == true);  // DEBUG
-  // LOG_INFO("END GetValue key=%ld Thread=%lu", key.ToString(), getThreadId());  // DEBUG
-  // return is_exist;                                                             // 返回leaf page中key是否存在
 }
 
 /*****************************************************************************
@@ -93,18 +98,21 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  // std::scoped_lock lock{latch_};  // DEBUG
-  // LOG_INFO("ENTER Insert key=%ld Thread=%lu", key.ToString(), getThreadId());  // DEBUG
-  {
-    const std::lock_guard<std::mutex> guard(root_latch_);  // 注意新建根节点时要锁住
-    // std::scoped_lock lock{root_latch_};
+  Context ctx;
+  // 1 乐观：绝大多数插入不会拆分，只写锁leaf
+  if (!optimistic_ || !FindLeafOptimistic(key, Operation::INSERT, &ctx)) {
+    // 2 悲观：空树或者leaf不安全，从根结点重新开始latch crabbing
+    // 注意新建根节点时要锁住；锁一直持有到FindLeafWrite确认根结点安全为止，避免判空后树又被删空
+    ctx.root_lock_ = std::unique_lock<std::mutex>(root_latch_);
     if (IsEmpty()) {
       StartNewTree(key, value);
       return true;
     }
+    // W Latch leaf page and its unsafe ancestors
+    FindLeafWrite(key, Operation::INSERT, &ctx);
   }
   // insert key into correct leaf node and return the key exist or not
-  return InsertIntoLeaf(key, value, transaction);
+  return InsertIntoLeaf(key, value, &ctx);
 }
 /*
  * 创建新树，即创建root page
@@ -115,112 +123,65 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
-  // LOG_INFO("ENTER StartNewTree key=%ld thread=%lu", key.ToString(), getThreadId());  // DEBUG
-
-  // 1 缓冲池申请一个new page，作为root page
+  // 1 申请一个page作为root page（guard析构时unlatch并unpin）
   page_id_t new_page_id = INVALID_PAGE_ID;
-  Page *root_page = buffer_pool_manager_->NewPage(&new_page_id);  // 注意new page的pin_count=1，之后记得unpin page
-  if (nullptr == root_page) {
-    throw std::runtime_error("out of memory");
-  }
-  // 2 page id赋值给root page id，并插入header page的root page id
-  root_page_id_ = new_page_id;
-  UpdateRootPageId(1);  // insert root page id in header page
+  WritePageGuard root_guard = NewRootGuarded(&new_page_id);
 
-  // 3 使用leaf page的Insert函数插入(key,value)
-  LeafPage *root_node = reinterpret_cast<LeafPage *>(root_page->GetData());  // 记得加上GetData()
-  root_node->Init(new_page_id, INVALID_PAGE_ID, leaf_max_size_);             // 记得初始化为leaf_max_size
+  // 2 使用leaf page的Insert函数插入(key,value)
+  LeafPage *root_node = root_guard.AsMut<LeafPage>();
+  root_node->Init(new_page_id, INVALID_PAGE_ID, leaf_max_size_);  // 记得初始化为leaf_max_size
   root_node->Insert(key, value, comparator_);
-  // 4 unpin root page
-  buffer_pool_manager_->UnpinPage(root_page->GetPageId(), true);  // 注意：这里dirty要置为true！
 
-  // LOG_INFO("END StartNewTree key=%ld thread=%lu", key.ToString(), getThreadId());  // DEBUG
+  // 3 初始化后才把page id赋值给root page id，读操作不会读到未初始化的根结点；并插入header page的root page id
+  root_page_id_ = new_page_id;
+  UpdateRootPageId(1);  // insert root page id in header page
+}
+
+/*
+ * 申请一个page作为新的根结点，调用前root_latch_必须已经锁住
+ * User needs to first ask for new page from buffer pool manager(NOTICE: throw
+ * an "out of memory" exception if returned value is nullptr)
+ * @return : guard of the new root page, pinned and W Latched, the caller must initialize it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+WritePageGuard BPLUSTREE_TYPE::NewRootGuarded(page_id_t *page_id) {
+  WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id, segment_).UpgradeWrite();
+  if (!guard.IsValid()) {
+    throw std::runtime_error("out of memory");
+  }
+  return guard;
 }
 
 /*
  * Insert constant key & value pair into leaf page
- * User needs to first find the right leaf page as insertion target, then look
+ * The leaf page as insertion target is ctx->write_set_.back(), W Latched with its unsafe ancestors. Look
  * through leaf page to see whether insert key exist or not. If exist, return
  * immdiately, otherwise insert entry. Remember to deal with split if necessary.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  // LOG_INFO("ENTER InsertIntoLeaf key=%ld thread=%lu", key.ToString(), getThreadId());
-
-  // bool is_root_latched_;  // DEBUG
-
-  // 1 find the leaf page as insertion target
-  // Page *leaf_page = FindLeafPage(key, false, transaction, Operation::INSERT,
-  //  &is_root_latched_);  // pin and W Latch leaf page and ancesters
-  auto [leaf_page, root_is_latched] = FindLeafPageByOperation(key, Operation::INSERT, transaction);
-
-  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());  // 注意，记得加上GetData()
-
-  // ValueType lookup_value{};  // not used
-  // bool is_exist = leaf_node->Lookup(key, &lookup_value, comparator_);
-
-  int size = leaf_node->GetSize();
-
-  // 2 the key not exist, so we can insert (key,value) to leaf node
-  int new_size = leaf_node->Insert(key, value, comparator_);
-
-  // if (is_exist) {
-  if (new_size == size) {
-    // assert(root_is_latched_ == true);
-    if (root_is_latched) {
-      // LOG_INFO("Before END InsertIntoLeaf duplicate keys: root_latch_.unlock()");
-      root_latch_.unlock();
-    }
-    UnlockUnpinPages(transaction);  // 此函数中会释放叶子的所有现在被锁住的祖先（不包括叶子）
-    // assert(root_is_latched_ == false);
-    leaf_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);  // unpin leaf page
-    // LOG_INFO("END InsertIntoLeaf duplicate keys! key=%ld thread=%lu", key.ToString(), getThreadId());
-    return false;
+bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Context *ctx) {
+  // 1 the leaf page as insertion target
+  WritePageGuard &leaf_guard = ctx->write_set_.back();
+
+  // 2 key已经存在，插入失败。先用只读的As检查，这样leaf不会被标记为dirty
+  ValueType lookup_value{};
+  if (leaf_guard.As<LeafPage>()->Lookup(key, &lookup_value, comparator_)) {
+    return false;  // ctx析构时释放所有锁住的page
   }
 
+  // 3 the key not exist, so we can insert (key,value) to leaf node
+  LeafPage *leaf_node = leaf_guard.AsMut<LeafPage>();
+  int new_size = leaf_node->Insert(key, value, comparator_);
   if (new_size < leaf_node->GetMaxSize()) {
-    // UnlockUnpinPages(transaction, Operation::INSERT);  // DEBUG 疑问：此处是否需要释放所有祖先节点的锁？
-    // 似乎不需要，因为如果叶子节点插入后小于maxsize，说明其父节点在之前在findLeafPage就已经释放过锁了
-
-    if (root_is_latched) {
-      // LOG_INFO("Before END InsertIntoLeaf no split: root_latch_.unlock()");
-      root_latch_.unlock();
-    }
-
-    leaf_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);  // unpin leaf page
-    // LOG_INFO("END InsertIntoLeaf no split! key=%ld thread=%lu", key.ToString(), getThreadId());  // DEBUG
     return true;
   }
 
   // new_size >= leaf_node->GetMaxSize()
-  LeafPage *new_leaf_node = Split(leaf_node);  // pin new leaf node
-
-  bool *pointer_root_is_latched = new bool(root_is_latched);
-
-  InsertIntoParent(leaf_node, new_leaf_node->KeyAt(0), new_leaf_node, transaction,
-                   pointer_root_is_latched);  // 此函数内将会 W Unlatch
-
-  assert((*pointer_root_is_latched) == false);
-
-  delete pointer_root_is_latched;
-
-  // 疑问：这里别人似乎没有unpin？？？(我觉得必须unpin，InsertIntoParent函数里面并不会unpin old node和new node)
-
-  // DEBUG
-  // if (is_root_latched_) {
-  //   // LOG_INFO("Before END InsertIntoLeaf with split: root_latch_.unlock()");
-  //   root_latch_.unlock();
-  // }
-
-  leaf_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);      // unpin leaf page
-  buffer_pool_manager_->UnpinPage(new_leaf_node->GetPageId(), true);  // DEBUG: unpin new leaf node
-
-  // LOG_INFO("END InsertIntoLeaf with split! key=%ld thread=%lu", key.ToString(), getThreadId());  // DEBUG
+  WritePageGuard new_leaf_guard = Split(leaf_node);
+  LeafPage *new_leaf_node = new_leaf_guard.AsMut<LeafPage>();
+  InsertIntoParent(leaf_node, new_leaf_node->KeyAt(0), new_leaf_node, ctx, ctx->write_set_.size() - 1);
   return true;
 }
 
@@ -230,8 +191,7 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  * 接下来注意分情况讨论node是叶结点还是内部结点
  * 如果node为internal page，则产生的新结点的孩子结点的父指针要更新为新结点
  * 如果node为leaf page，则产生的新结点要连接原结点，即更新这两个结点的next page id
- * 注意：本函数执行完毕后，原node和new node都需要在函数外面进行unpin
- * （此处看具体实现方式，也可将new node在函数内部进行unpin）
+ * 注意：返回的guard持有new node的pin和写锁，在函数外析构时释放
  * Split input page and return newly created page.
  * Using template N to represent either internal page or leaf page.
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
@@ -240,16 +200,16 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-N *BPLUSTREE_TYPE::Split(N *node) {
+WritePageGuard BPLUSTREE_TYPE::Split(N *node) {
   // 1 缓冲池申请一个new page
   page_id_t new_page_id = INVALID_PAGE_ID;
-  Page *new_page = buffer_pool_manager_->NewPage(&new_page_id);  // 注意new page的pin_count=1，之后记得unpin page
-  if (nullptr == new_page) {
+  WritePageGuard new_guard = buffer_pool_manager_->NewPageGuarded(&new_page_id, segment_).UpgradeWrite();
+  if (!new_guard.IsValid()) {
     throw std::runtime_error("out of memory");
   }
   // 2 分情况进行拆分
-  N *new_node = reinterpret_cast<N *>(new_page->GetData());  // 记得加上GetData()
-  new_node->SetPageType(node->GetPageType());                // DEBUG
+  N *new_node = new_guard.AsMut<N>();
+  new_node->SetPageType(node->GetPageType());  // DEBUG
 
   if (node->IsLeafPage()) {  // leaf page
     LeafPage *old_leaf_node = reinterpret_cast<LeafPage *>(node);
@@ -262,7 +222,6 @@ N *BPLUSTREE_TYPE::Split(N *node) {
     // 最新：old node ---> new node ---> next node
     new_leaf_node->SetNextPageId(old_leaf_node->GetNextPageId());  // 完成连接new node ---> next node
     old_leaf_node->SetNextPageId(new_leaf_node->GetPageId());      // 完成连接old node ---> new node
-    new_node = reinterpret_cast<N *>(new_leaf_node);
   } else {  // internal page
     InternalPage *old_internal_node = reinterpret_cast<InternalPage *>(node);
     InternalPage *new_internal_node = reinterpret_cast<InternalPage *>(new_node);
@@ -270,10 +229,8 @@ N *BPLUSTREE_TYPE::Split(N *node) {
     // old_internal_node右半部分 移动至 new_internal_node
     // new_node（原old_node的右半部分）的所有孩子结点的父指针更新为指向new_node
     old_internal_node->MoveHalfTo(new_internal_node, buffer_pool_manager_);
-    new_node = reinterpret_cast<N *>(new_internal_node);
   }
-  // fetch page and new page need to unpin page (do it outside)
-  return new_node;  // 注意，此时new_node还没有unpin
+  return new_guard;
 }
 
 /*
@@ -281,26 +238,27 @@ N *BPLUSTREE_TYPE::Split(N *node) {
  * 将new_node的第一个key插入到父结点，其位置在 父结点指向old_node的孩子指针 之后
  * 如果插入后>=maxsize，则必须继续拆分父结点，然后在其父结点的父结点再插入，即需要递归
  * 直到找到的old_node为根结点时，结束递归（此时将会新建一个根R，关键字为key，old_node和new_node为其孩子）
- * 注意：本函数执行完毕后，new node和old node都需要在函数外面进行unpin
+ * old_node拆分说明它在向下查找时是不安全的，所以它的父结点一定还在ctx->write_set_中，即level - 1处
  * Insert key & value pair into internal page after split
  * @param   old_node      input page from split() method
  * @param   key
  * @param   new_node      returned page from split() method
+ * @param   level         index of the guard of old_node in ctx->write_set_
  * User needs to first find the parent page of old_node, parent node must be
  * adjusted to take info of new_node into account. Remember to deal with split
  * recursively if necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction, bool *root_is_latched) {
+                                      Context *ctx, size_t level) {
   // 1 old_node是根结点，那么整棵树直接升高一层
   // 具体操作是创建一个新结点R当作根结点，其关键字为key，左右孩子结点分别为old_node和new_node
   if (old_node->IsRootPage()) {  // old node为根结点
+    assert(ctx->root_lock_.owns_lock());  // 根结点不安全，所以root_latch_还没有释放
     page_id_t new_page_id = INVALID_PAGE_ID;
-    Page *new_page = buffer_pool_manager_->NewPage(&new_page_id);  // 这里应该是NewPage，不是FetchPage！
-    root_page_id_ = new_page_id;
+    WritePageGuard new_root_guard = NewRootGuarded(&new_page_id);
 
-    InternalPage *new_root_node = reinterpret_cast<InternalPage *>(new_page->GetData());
+    InternalPage *new_root_node = new_root_guard.AsMut<InternalPage>();
     new_root_node->Init(new_page_id, INVALID_PAGE_ID, internal_max_size_);  // 注意初始化parent page id和max_size
     // 修改新的根结点的孩子指针，即array[0].second指向old_node，array[1].second指向new_node；对于array[1].first则赋值为key
     new_root_node->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
@@ -308,56 +266,117 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
     old_node->SetParentPageId(new_page_id);
     new_node->SetParentPageId(new_page_id);
 
-    // buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);  // DEBUG
-    buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);  // 修改了new_page->data，所以dirty置为true
-
+    // 新的根结点初始化后才发布，此时仍持有old_node的写锁
+    root_page_id_ = new_page_id;
     UpdateRootPageId(0);  // update root page id in header page
-
-    // 新的root必定不在transaction的page_set_队列中
-    if (*root_is_latched) {
-      *root_is_latched = false;
-      root_latch_.unlock();
-    }
-
-    UnlockPages(transaction);
-    // LOG_INFO("InsertIntoParent old node is root: completed key=%ld thread=%lu", key.ToString(), getThreadId());
-    return;  // 结束递归
+    return;               // 结束递归
   }
 
-  // LOG_INFO("InsertIntoParent old node is NOT root: completed key=%ld thread=%lu", key.ToString(), getThreadId());
-
   // 2 old_node不是根结点
   // 找到old_node的父结点进行操作
   // a. 先直接插入(key,new_node->page_id)到父结点
   // b. 如果插入后父结点满了，则需要对父结点再进行拆分(Split)，并继续递归
-  // buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);                      // DEBUG
-  Page *parent_page = buffer_pool_manager_->FetchPage(old_node->GetParentPageId());  // pin parent page
-
-  InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  assert(level > 0 && ctx->write_set_[level - 1].PageId() == old_node->GetParentPageId());
+  WritePageGuard &parent_guard = ctx->write_set_[level - 1];
+  InternalPage *parent_node = parent_guard.AsMut<InternalPage>();
   // 将(key,new_node->page_id)插入到父结点中 value==old_node->page_id 的下标之后
   parent_node->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());  // size+1
 
   // 父节点未满
   if (parent_node->GetSize() < parent_node->GetMaxSize()) {
-    // DEBUG
-    if (*root_is_latched) {
-      *root_is_latched = false;
-      root_latch_.unlock();
-    }
-
-    UnlockPages(transaction);  // unlock除了叶子结点以外的所有上锁的祖先节点
-    buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);  // unpin parent page
     return;
   }
 
   // 父结点已满(注意，之前的insert使得size+1)，需要拆分，再递归InsertIntoParent
   // parent_node拆分成两个，分别是parent_node和new_parent_node
-  InternalPage *new_parent_node = Split(parent_node);  // pin new parent node
+  WritePageGuard new_parent_guard = Split(parent_node);
+  InternalPage *new_parent_node = new_parent_guard.AsMut<InternalPage>();
   // 继续递归，下一层递归是将拆分后新结点new_parent_node的第一个key插入到parent_node的父结点
-  InsertIntoParent(parent_node, new_parent_node->KeyAt(0), new_parent_node, transaction, root_is_latched);
+  InsertIntoParent(parent_node, new_parent_node->KeyAt(0), new_parent_node, ctx, level - 1);
+}
 
-  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);      // unpin parent page
-  buffer_pool_manager_->UnpinPage(new_parent_node->GetPageId(), true);  // unpin new parent node
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * 自底向上批量构建B+树，代替逐个Insert：不需要每个key都从根结点查找、加锁，也不会拆分出半满的page
+ * 1 entries平均分到若干个leaf page中，每个page填到fill_factor，leaf按顺序从segment_中申请并串成链表
+ * 2 用这一层每个page的第一个key和page id，同样地构建上一层内部结点，直到这一层只有一个page，它就是根结点
+ * 每一层的page在文件中是连续的；根结点构建完才发布root_page_id_，之前读操作看到的是空树
+ * @param entries (key, value) pairs sorted by key, the keys unique
+ * @param fill_factor fraction of max size - 1 (a page splits at max size) that every page is filled to, the pages of a
+ * level share the entries evenly and none of them is below min size
+ * @return false if the tree is not empty, nothing is loaded then
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(const std::vector<std::pair<KeyType, ValueType>> &entries, double fill_factor) {
+  std::scoped_lock root_lock(root_latch_);
+  if (!IsEmpty()) {
+    return false;
+  }
+  if (entries.empty()) {
+    return true;
+  }
+  assert(std::adjacent_find(entries.begin(), entries.end(), [this](const auto &left, const auto &right) {
+           return comparator_(left.first, right.first) >= 0;
+         }) == entries.end());
+  assert(internal_max_size_ >= 4);  // 否则每个内部结点至少2个孩子时可能装不下
+  // 一层n个entry分到几个page：每个page填到fill_factor，但不能少于min size，否则删除时会出现过小的结点
+  auto num_pages = [fill_factor](size_t n, int max_size, int min_size) {
+    auto capacity = static_cast<size_t>(std::clamp(static_cast<int>((max_size - 1) * fill_factor), min_size,
+                                                   std::max(max_size - 1, 1)));
+    return std::min((n + capacity - 1) / capacity, std::max<size_t>(n / min_size, 1));
+  };
+  auto new_page = [this](page_id_t *page_id) {
+    WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id, segment_).UpgradeWrite();
+    if (!guard.IsValid()) {
+      throw std::runtime_error("out of memory");
+    }
+    return guard;
+  };
+
+  // 1 叶子层，level是这一层每个page的第一个key和page id
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  size_t num_leaves = num_pages(entries.size(), leaf_max_size_, std::max(leaf_max_size_ / 2, 1));
+  WritePageGuard prev_leaf_guard;
+  for (size_t i = 0, begin = 0; i < num_leaves; i++) {
+    size_t end = entries.size() * (i + 1) / num_leaves;
+    page_id_t page_id;
+    WritePageGuard leaf_guard = new_page(&page_id);
+    LeafPage *leaf_node = leaf_guard.AsMut<LeafPage>();
+    leaf_node->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+    leaf_node->CopyNFrom(entries.data() + begin, end - begin);
+    if (prev_leaf_guard.IsValid()) {
+      prev_leaf_guard.AsMut<LeafPage>()->SetNextPageId(page_id);
+    }
+    level.emplace_back(entries[begin].first, page_id);
+    prev_leaf_guard = std::move(leaf_guard);
+    begin = end;
+  }
+  prev_leaf_guard.Drop();
+
+  // 2 逐层向上构建内部结点，内部结点的第一个key不使用
+  while (level.size() > 1) {
+    std::vector<std::pair<KeyType, page_id_t>> parent_level;
+    size_t num_nodes = num_pages(level.size(), internal_max_size_, std::max(internal_max_size_ / 2, 2));
+    for (size_t i = 0, begin = 0; i < num_nodes; i++) {
+      size_t end = level.size() * (i + 1) / num_nodes;
+      page_id_t page_id;
+      WritePageGuard internal_guard = new_page(&page_id);
+      InternalPage *internal_node = internal_guard.AsMut<InternalPage>();
+      internal_node->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
+      // 孩子结点的父指针更新为这个结点
+      internal_node->CopyNFrom(level.data() + begin, end - begin, buffer_pool_manager_);
+      parent_level.emplace_back(level[begin].first, page_id);
+      begin = end;
+    }
+    level = std::move(parent_level);
+  }
+
+  // 3 发布根结点
+  root_page_id_ = level[0].second;
+  UpdateRootPageId(1);  // insert root page id in header page
+  return true;
 }
 
 /*****************************************************************************
@@ -372,165 +391,91 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
-  // LOG_INFO("ENTER Remove key=%ld thread=%lu", key.ToString(), getThreadId());
-
-  // std::scoped_lock lock{latch_};  // DEBUG
-  if (IsEmpty()) {
-    return;
-  }
-  // find the leaf page as deletion target
-  // Page *leaf_page = FindLeafPage(key, false, transaction, Operation::DELETE);  // pin leaf page
-  // Page *leaf_page = FindLeafPageByOperation(key, Operation::DELETE, transaction).first;
-  auto [leaf_page, root_is_latched] = FindLeafPageByOperation(key, Operation::DELETE, transaction);
-  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
-  int old_size = leaf_node->GetSize();
-  int new_size = leaf_node->RemoveAndDeleteRecord(key, comparator_);  // 在leaf中删除key（如果不存在该key，则size不变）
-
-  // 1 删除失败
-  if (new_size == old_size) {
-    if (root_is_latched) {
-      root_latch_.unlock();
+  Context ctx;
+  // 乐观：绝大多数删除不会合并或重分配，只写锁leaf；否则从根结点重新开始悲观的latch crabbing
+  if (!optimistic_ || !FindLeafOptimistic(key, Operation::DELETE, &ctx)) {
+    ctx.root_lock_ = std::unique_lock<std::mutex>(root_latch_);
+    if (IsEmpty()) {
+      return;
     }
-    UnlockUnpinPages(transaction);
-
-    leaf_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);  // unpin leaf page
+    // find the leaf page as deletion target, W Latch leaf page and its unsafe ancestors
+    FindLeafWrite(key, Operation::DELETE, &ctx);
+  }
+  WritePageGuard &leaf_guard = ctx.write_set_.back();
 
+  // 1 key不存在，删除失败。先用只读的As检查，这样leaf不会被标记为dirty
+  ValueType lookup_value{};
+  if (!leaf_guard.As<LeafPage>()->Lookup(key, &lookup_value, comparator_)) {
     return;
   }
 
   // 2 删除成功，然后调用CoalesceOrRedistribute
-  bool *pointer_root_is_latched = new bool(root_is_latched);
-
-  bool leaf_should_delete = CoalesceOrRedistribute(leaf_node, transaction, pointer_root_is_latched);
-  // NOTE: unlock and unpin are finished in CoalesceOrRedistribute
-  // NOTE: root node must be unlocked in CoalesceOrRedistribute
-  assert((*pointer_root_is_latched) == false);
-
-  delete pointer_root_is_latched;
-
-  if (leaf_should_delete) {
-    transaction->AddIntoDeletedPageSet(leaf_page->GetPageId());
-  }
-
-  // if (root_is_latched) {
-  //   LOG_INFO("END Remove key=%ld thread=%lu root_latch_.unlock()", key.ToString(), getThreadId());
-  //   root_latch_.unlock();
-  // }
-
-  leaf_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);  // unpin leaf page
+  LeafPage *leaf_node = leaf_guard.AsMut<LeafPage>();
+  leaf_node->RemoveAndDeleteRecord(key, comparator_);
+  CoalesceOrRedistribute(leaf_node, &ctx, ctx.write_set_.size() - 1);
 
   // NOTE: ensure deleted pages have been unpined
-  // 删除并清空deleted page set
-  for (page_id_t page_id : *transaction->GetDeletedPageSet()) {
-    buffer_pool_manager_->DeletePage(page_id);
+  // 先释放所有锁住的page，再在缓冲池中删除被合并掉的page
+  ctx.write_set_.clear();
+  if (ctx.root_lock_.owns_lock()) {
+    ctx.root_lock_.unlock();
+  }
+  if (!ctx.deleted_pages_.empty()) {
+    WaitForOptimisticReads();
+    DeletePages(ctx.deleted_pages_);
   }
-  transaction->GetDeletedPageSet()->clear();
 }
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size >= page's max size, then redistribute. Otherwise, merge(Coalesce).
  * Using template N to represent either internal page or leaf page.
- * @return: true means target leaf page should be deleted, false means no
- * deletion happens
+ * 需要删除的page会被加入ctx->deleted_pages_，在所有page都释放后再删除
+ * @param   level         index of the guard of node in ctx->write_set_
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction, bool *root_is_latched) {
+void BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Context *ctx, size_t level) {
   if (node->IsRootPage()) {
-    bool root_should_delete = AdjustRoot(node);
-
-    // DEBUG
-    if (*root_is_latched) {
-      // LOG_INFO("CoalesceOrRedistribute node is root page root_latch_.unlock()");
-      *root_is_latched = false;
-      root_latch_.unlock();
+    if (AdjustRoot(node)) {
+      // 不加锁的读操作可能还拿着旧根结点的page id，和被合并掉的page一样等它们结束后再删除
+      ctx->deleted_pages_.push_back(node->GetPageId());
     }
-
-    UnlockPages(transaction);
-    return root_should_delete;  // NOTE: size of root page can be less than min size
+    return;  // NOTE: size of root page can be less than min size
   }
 
-  // 不需要合并或者重分配，直接返回false
+  // 不需要合并或者重分配，直接返回
   if (node->GetSize() >= node->GetMinSize()) {
-    // 疑问：此处为什么不用root_latch_.unlock()
-
-    if (*root_is_latched) {
-      // LOG_INFO("CoalesceOrRedistribute node > minsize root_latch_.unlock()");
-      *root_is_latched = false;
-      root_latch_.unlock();
-    }
-
-    UnlockPages(transaction);
-    return false;
+    return;
   }
 
   // 需要合并或者重分配
-  // 先获取node的parent page
-  Page *parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  InternalPage *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  // node不安全，所以它的parent page一定还在ctx->write_set_中
+  assert(level > 0 && ctx->write_set_[level - 1].PageId() == node->GetParentPageId());
+  WritePageGuard &parent_guard = ctx->write_set_[level - 1];
+  InternalPage *parent = parent_guard.AsMut<InternalPage>();
 
   // 获得node在parent的孩子指针(value)的index
   int index = parent->ValueIndex(node->GetPageId());
-  // 寻找兄弟结点，尽量找到前一个结点(前驱结点)
+  // 寻找兄弟结点，尽量找到前一个结点(前驱结点)，记得要锁住兄弟结点
   page_id_t sibling_page_id = parent->ValueAt(index == 0 ? 1 : index - 1);
-  Page *sibling_page = buffer_pool_manager_->FetchPage(sibling_page_id);
-
-  sibling_page->WLatch();  // 记得要锁住兄弟结点
-
-  N *sibling_node = reinterpret_cast<N *>(sibling_page->GetData());
+  WritePageGuard sibling_guard = buffer_pool_manager_->FetchPageWrite(sibling_page_id);
+  N *sibling_node = sibling_guard.AsMut<N>();
 
   // 1 Redistribute 当kv总和能支撑两个Node，那么重新分配即可，不必删除node
   if (node->GetSize() + sibling_node->GetSize() >= node->GetMaxSize()) {
-    if (*root_is_latched) {
-      // LOG_INFO("CoalesceOrRedistribute before Redistribute root_latch_.unlock()");
-      *root_is_latched = false;
-      root_latch_.unlock();
-    }
-
-    Redistribute(sibling_node, node, index);  // 无返回值
-
-    UnlockPages(transaction);
-    buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-
-    sibling_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
-
-    return false;  // node不必被删除
+    Redistribute(sibling_node, node, parent, index);
+    return;
   }
 
-  // 2 Coalesce 当sibling和node只能凑成一个Node，那么合并两个结点到sibling，删除node
+  // 2 Coalesce 当sibling和node只能凑成一个Node，那么合并两个结点，删除右边的结点
   // Coalesce函数继续递归调用CoalesceOrRedistribute
-  bool parent_should_delete =
-      Coalesce(&sibling_node, &node, &parent, index, transaction, root_is_latched);  // 返回值是parent是否需要被删除
-
-  assert((*root_is_latched) == false);
-
-  // 特别注意此处的解锁root
-  // if (*root_is_latched) {
-  //   LOG_INFO("CoalesceOrRedistribute after Coalesce root_latch_.unlock()");
-  //   *root_is_latched = false;
-  //   root_latch_.unlock();
-  // }
-
-  if (parent_should_delete) {
-    transaction->AddIntoDeletedPageSet(parent->GetPageId());
-  }
-
-  // NOTE: parent unlock is finished in Coalesce
-  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-
-  sibling_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
-
-  return true;  // node需要被删除
+  Coalesce(sibling_node, node, parent, index, ctx, level);
 }
 
 /*
- * 合并(Coalesce)函数是和直接前驱进行合并，也就是和它左边的node进行合并
- * neighbor_node是node的前结点，node结点是需要被删除的
+ * 合并(Coalesce)函数是和直接前驱进行合并，也就是把右边的结点合并到左边的结点
+ * 若index=0，说明node为neighbor前驱，此时把neighbor合并到node，被删除的是neighbor
  * Move all the key & value pairs from one page to its sibling page, and notify
  * buffer pool manager to delete this page. Parent page must be adjusted to
  * take info of deletion into account. Remember to deal with coalesce or
@@ -539,49 +484,42 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction, b
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
  * @param   parent             parent page of input "node"
- * @return  true means parent node should be deleted, false means no deletion
- * happend
+ * @param   level              index of the guard of node in ctx->write_set_
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
-                              BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent, int index,
-                              Transaction *transaction, bool *root_is_latched) {
-  // Assume that *neighbor_node is the left sibling of *node (neighbor -> node)
+void BPLUSTREE_TYPE::Coalesce(N *neighbor_node, N *node, InternalPage *parent, int index, Context *ctx,
+                              size_t level) {
   // index表示node在parent中的孩子指针(value)的下标
-  // key_index表示 交换后的 node在parent中的孩子指针(value)的下标
-  // 若index=0，说明node为neighbor前驱，要保证neighbor为node的前驱，则交换变量neighbor和node，且key_index=1
+  // key_index表示 右边结点 在parent中的孩子指针(value)的下标
+  // 若index=0，则交换变量neighbor和node，保证neighbor_node是左边的结点，node是右边被删除的结点
   int key_index = index;
   if (index == 0) {
-    std::swap(neighbor_node, node);  // 保证neighbor_node为node的前驱
+    std::swap(neighbor_node, node);
     key_index = 1;
   }
-  KeyType middle_key = (*parent)->KeyAt(key_index);  // middle_key only used in internal_node->MoveAllTo
+  KeyType middle_key = parent->KeyAt(key_index);  // middle_key only used in internal_node->MoveAllTo
 
   // Move items from node to neighbor_node
-  if ((*node)->IsLeafPage()) {
-    LeafPage *leaf_node = reinterpret_cast<LeafPage *>(*node);
-    LeafPage *neighbor_leaf_node = reinterpret_cast<LeafPage *>(*neighbor_node);
+  if (node->IsLeafPage()) {
+    LeafPage *leaf_node = reinterpret_cast<LeafPage *>(node);
+    LeafPage *neighbor_leaf_node = reinterpret_cast<LeafPage *>(neighbor_node);
     leaf_node->MoveAllTo(neighbor_leaf_node);
     neighbor_leaf_node->SetNextPageId(leaf_node->GetNextPageId());
-    // LOG_INFO("Coalesce leaf, index=%d, pid=%d neighbor->node", index, (*node)->GetPageId());
   } else {
-    InternalPage *internal_node = reinterpret_cast<InternalPage *>(*node);
-    InternalPage *neighbor_internal_node = reinterpret_cast<InternalPage *>(*neighbor_node);
+    InternalPage *internal_node = reinterpret_cast<InternalPage *>(node);
+    InternalPage *neighbor_internal_node = reinterpret_cast<InternalPage *>(neighbor_node);
     // MoveAllTo do this: set node's first key to middle_key and move node to neighbor
     internal_node->MoveAllTo(neighbor_internal_node, middle_key, buffer_pool_manager_);
-    // LOG_INFO("Coalesce internal, index=%d, pid=%d neighbor->node", index, (*node)->GetPageId());
   }
-
-  // 在缓冲池中删除node
-  // buffer_pool_manager_->UnpinPage((*node)->GetPageId(), true);
-  // buffer_pool_manager_->DeletePage((*node)->GetPageId());
+  // 右边的结点已经为空，在所有page释放后删除
+  ctx->deleted_pages_.push_back(node->GetPageId());
 
   // 删除node在parent中的kv信息
-  (*parent)->Remove(key_index);  // 注意，是key_index，不是index
+  parent->Remove(key_index);  // 注意，是key_index，不是index
 
   // 因为parent中删除了kv对，所以递归调用CoalesceOrRedistribute函数判断parent结点是否需要被删除
-  return CoalesceOrRedistribute(*parent, transaction, root_is_latched);
+  CoalesceOrRedistribute(parent, ctx, level - 1);
 }
 
 /*
@@ -592,13 +530,11 @@ bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
+ * @param   parent             parent page of input "node"
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
-  Page *parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  InternalPage *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());  // parent of node
-
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index) {
   // node是之前刚被删除过一个key的结点
   // index=0，则neighbor是node后继结点，表示：node(left)      neighbor(right)
   // index>0，则neighbor是node前驱结点，表示：neighbor(left)  node(right)
@@ -608,13 +544,11 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
     LeafPage *leaf_node = reinterpret_cast<LeafPage *>(node);
     LeafPage *neighbor_leaf_node = reinterpret_cast<LeafPage *>(neighbor_node);
     if (index == 0) {  // node -> neighbor
-      // LOG_INFO("Redistribute leaf, index=0, pid=%d node->neighbor", node->GetPageId());
       // move neighbor's first to node's end
       neighbor_leaf_node->MoveFirstToEndOf(leaf_node);
       parent->SetKeyAt(1, neighbor_leaf_node->KeyAt(0));
     } else {  // neighbor -> node
       // move neighbor's last to node's front
-      // LOG_INFO("Redistribute leaf, index=%d, pid=%d neighbor->node", index, node->GetPageId());
       neighbor_leaf_node->MoveLastToFrontOf(leaf_node);
       parent->SetKeyAt(index, leaf_node->KeyAt(0));
     }
@@ -622,7 +556,6 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
     InternalPage *internal_node = reinterpret_cast<InternalPage *>(node);
     InternalPage *neighbor_internal_node = reinterpret_cast<InternalPage *>(neighbor_node);
     if (index == 0) {  // case: node(left) and neighbor(right)
-      // LOG_INFO("Redistribute internal, index=0, pid=%d node->neighbor", node->GetPageId());
       // MoveFirstToEndOf do this:
       // 1 set neighbor's first key to parent's second key（详见MoveFirstToEndOf函数）
       // 2 move neighbor's first to node's end
@@ -630,7 +563,6 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
       // set parent's second key to neighbor's "new" first key
       parent->SetKeyAt(1, neighbor_internal_node->KeyAt(0));
     } else {  // case: neighbor(left) and node(right)
-      // LOG_INFO("Redistribute internal, index=%d, pid=%d neighbor->node", index, node->GetPageId());
       // MoveLastToFrontOf do this:
       // 1 set node's first key to parent's index key（详见MoveLastToFrontOf函数）
       // 2 move neighbor's last to node's front
@@ -639,8 +571,6 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
       parent->SetKeyAt(index, internal_node->KeyAt(0));
     }
   }
-  buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-  // LOG_INFO("END redistribute");
 }
 /*
  * Update root page if necessary
@@ -649,7 +579,8 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
  * case 1: when you delete the last element in root page, but root page still
  * has one last child
  * case 2: when you delete the last element in whole b+ tree
- * @return : true means root page should be deleted, false means no deletion
+ * 调用时持有root_latch_和old_root_node的写锁
+ * @return : true means root page should be deleted (after the reads that may still fetch it), false means no deletion
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
@@ -657,49 +588,25 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
   // Case 1: old_root_node是内部结点，且大小为1。表示内部结点其实已经没有key了，所以要把它的孩子更新成新的根结点
   // old_root_node (internal node) has only one size
   if (!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
-    // LOG_INFO("AdjustRoot: delete the last element in root page, but root page still has one last child");
     // get child page as new root page
     InternalPage *internal_node = reinterpret_cast<InternalPage *>(old_root_node);
     page_id_t child_page_id = internal_node->RemoveAndReturnOnlyChild();
 
-    // NOTE: don't need to unpin old_root_node, this operation will be done in CoalesceOrRedistribute function
-    // buffer_pool_manager_->UnpinPage(old_root_node->GetPageId(), true);
-
     // update root page id
     root_page_id_ = child_page_id;
     UpdateRootPageId(0);
-    // update parent page id of new root node
-    Page *new_root_page = buffer_pool_manager_->FetchPage(root_page_id_);
-    InternalPage *new_root_node = reinterpret_cast<InternalPage *>(new_root_page->GetData());
-    new_root_node->SetParentPageId(INVALID_PAGE_ID);
-
-    // if (root_is_latched) {
-    //   root_latch_.unlock();
-    // }
-
-    buffer_pool_manager_->UnpinPage(new_root_page->GetPageId(), true);
+    // update parent page id of new root node（孩子结点在合并时已经被这个线程写锁住，所以这里不再加锁）
+    buffer_pool_manager_->FetchPageBasic(child_page_id).AsMut<BPlusTreePage>()->SetParentPageId(INVALID_PAGE_ID);
     return true;
   }
   // Case 2: old_root_node是叶结点，且大小为0。直接更新root page id
   // all elements deleted from the B+ tree
   if (old_root_node->IsLeafPage() && old_root_node->GetSize() == 0) {
-    // LOG_INFO("AdjustRoot: all elements deleted from the B+ tree");
-    // NOTE: don't need to unpin old_root_node, this operation will be done in Remove function
     root_page_id_ = INVALID_PAGE_ID;
     UpdateRootPageId(0);
-
-    // if (root_is_latched) {
-    //   root_latch_.unlock();
-    // }
-
     return true;
   }
 
-  // DEBUG
-  // if (root_is_latched) {
-  //   root_latch_.unlock();
-  // }
-
   // 否则不需要有page被删除，直接返回false
   return false;
 }
@@ -715,11 +622,9 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
   // find leftmost leaf page
-  // KeyType key{};  // not used
-  // Page *leaf_page = FindLeafPage(key, true);  // pin leftmost leaf page
-  Page *leaf_page = FindLeafPageByOperation(KeyType(), Operation::FIND, nullptr, true).first;
-  // LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
-  return INDEXITERATOR_TYPE(buffer_pool_manager_, leaf_page, 0);  // 最左边的叶子且index=0
+  ReadPageGuard leaf_guard = FindLeafRead(KeyType(), true);
+  // 最左边的叶子且index=0
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(leaf_guard), 0, read_ahead_pages_);
 }
 
 /*
@@ -729,16 +634,10 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  // LOG_INFO("ENTER Begin()");
-
   // find leaf page that contains the input key
-  // Page *leaf_page = FindLeafPage(key, false, nullptr, Operation::FIND, nullptr, false);  // pin leaf page
-  Page *leaf_page = FindLeafPageByOperation(key, Operation::FIND).first;
-  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
-  int index = leaf_node->KeyIndex(key, comparator_);  // 此处直接用KeyIndex，而不是Lookup
-  // LOG_INFO("Tree.Begin before return INDEX class, index=%d leaf page id=%d leaf node page id=%d", index,
-  //          leaf_page->GetPageId(), leaf_node->GetPageId());
-  return INDEXITERATOR_TYPE(buffer_pool_manager_, leaf_page, index);
+  ReadPageGuard leaf_guard = FindLeafRead(key);
+  int index = leaf_guard.As<LeafPage>()->KeyIndex(key, comparator_);  // 此处直接用KeyIndex，而不是Lookup
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(leaf_guard), index, read_ahead_pages_);
 }
 
 /*
@@ -748,27 +647,15 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() {
-  // LOG_INFO("Enter tree.end()");
-  // find leftmost leaf page
-  // KeyType key{};  // not used
-  // Page *leaf_page = FindLeafPage(key, false, nullptr, Operation::FIND, nullptr, true);  // pin leftmost leaf page
-  Page *leaf_page = FindLeafPageByOperation(KeyType(), Operation::FIND, nullptr, false, true).first;
-  LeafPage *leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
-  // 从左向右开始遍历叶子层结点，直到最后一个
-  // while (leaf_node->GetNextPageId() != INVALID_PAGE_ID) {
-  //   int next_page_id = leaf_node->GetNextPageId();
-  //   buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);        // unpin current leaf page
-  //   Page *next_leaf_page = buffer_pool_manager_->FetchPage(next_page_id);  // pin next leaf page
-  //   leaf_page = next_leaf_page;                                            // update current leaf page to next leaf
-  //   page leaf_node = reinterpret_cast<LeafPage *>(leaf_page->GetData());
-  // }  // 结束循环时，leaf_node为叶子层的最后一个结点（rightmost leaf page）
+  // find rightmost leaf page
+  ReadPageGuard leaf_guard = FindLeafRead(KeyType(), false, true);
   // 注意传入的index为leaf_node->GetSize()
-  return INDEXITERATOR_TYPE(buffer_pool_manager_, leaf_page, leaf_node->GetSize());  // 注意：此时leaf_node没有unpin
+  int index = leaf_guard.As<LeafPage>()->GetSize();
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(leaf_guard), index, 0);
 }
 
 /*****************************************************************************
  * UTILITIES AND DEBUG
- * 注意，本函数结束时返回的leaf page会被pin，一定记得在函数外进行unpin
  * 从整个B+树的根结点开始，一直向下找到叶子结点
  * 因为B+树是多路搜索树，所以整个向下搜索就是通过key值进行比较
  * 其中内部结点向下搜索的过程中调用InternalPage的Lookup函数
@@ -776,251 +663,253 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() {
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * 注意，本函数返回的leaf page会被pin（但没有加锁），一定记得在函数外进行unpin
  */
-// INDEX_TEMPLATE_ARGUMENTS
-// Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost, Transaction *transaction, Operation op,
-//                                    bool *root_is_latched_, bool rightMost) {
-//   // std::scoped_lock lock{latch_};  // DEBUG
-
-//   // LOG_INFO("ENTER FindLeafPage key=%ld Thread=%lu", key.ToString(), getThreadId());  // DEBUG
-
-//   // 直接访问root_page_id_是不安全的，只有保证root_page_id_不会被修改才能通过
-//   // 只有当根节点是安全的情况下，才不存在修改root_page_id_的可能
-//   root_latch_.lock();  // 将成员变量root_page_id_锁住
-
-//   // LOG_INFO("32 ENTER FindLeafPage key=%ld Thread=%lu", key.ToString(), getThreadId());  // DEBUG
-
-//   bool root_is_latched = true;
-
-//   // LOG_INFO("42 ENTER FindLeafPage key=%ld Thread=%lu", key.ToString(), getThreadId());  // DEBUG
-
-//   if (IsEmpty()) {
-//     assert(!IsEmpty());  // 一般不会运行到这里
-//     return nullptr;
-//   }
-
-//   //  LOG_INFO("12 ENTER FindLeafPage key=%ld Thread=%lu", key.ToString(), getThreadId());  // DEBUG
-
-//   Page *page = buffer_pool_manager_->FetchPage(root_page_id_);               // pin root page
-//   BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());  // transform page to tree node
-//   // 锁住root page
-//   if (op == Operation::FIND) {
-//     page->RLatch();
-//     root_is_latched = false;
-//     root_latch_.unlock();
-//     // LOG_INFO("unlock root page id=%d Thread=%ld", page->GetPageId(), getThreadId());  // DEBUG
-//   } else {
-//     // if (transaction != nullptr) {
-//     //   transaction->AddIntoPageSet(page);
-//     // }
-
-//     page->WLatch();
-//     if (IsSafe(node, op)) {
-//       root_is_latched = false;
-//       root_latch_.unlock();
-//       // LOG_INFO("unlock root page id=%d Thread=%ld", page->GetPageId(), getThreadId());  // DEBUG
-//     }
-//   }
-
-//   while (!node->IsLeafPage()) {
-//     InternalPage *internal_node = reinterpret_cast<InternalPage *>(node);
-//     page_id_t child_page_id = INVALID_PAGE_ID;
-//     // get child page id
-//     if (leftMost) {
-//       child_page_id = internal_node->ValueAt(0);  // ValueType被指定为page_id_t类型
-//     } else {
-//       if (rightMost) {
-//         child_page_id = internal_node->ValueAt(internal_node->GetSize() - 1);
-//       } else {
-//         child_page_id = internal_node->Lookup(key, comparator_);
-//       }
-//     }
-
-//     // buffer_pool_manager_->UnpinPage(page->GetPageId(), false);          // unpin now page
-//     Page *child_page = buffer_pool_manager_->FetchPage(child_page_id);  // pin child page
-//     BPlusTreePage *child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
-
-//     if (op == Operation::FIND) {  // 1 读操作
-//       child_page->RLatch();       // 加读锁
-
-//       page->RUnlatch();  // 释放父节点的读锁
-//       buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-//       // UnlockUnpinPages(transaction, op);  // unlock and unpin all ancester pages
-//     } else {                         // 2 写操作
-//                                      // 在事务中只保存写操作的page
-//       if (transaction != nullptr) {  // if (!node->IsRootPage() && transaction != nullptr) {
-//         transaction->AddIntoPageSet(page);
-//       }
-
-//       child_page->WLatch();          // 加写锁
-//       if (IsSafe(child_node, op)) {  // 孩子结点是安全的
-//         root_is_latched = false;
-//         root_latch_.unlock();
-//       }
-
-//       UnlockUnpinPages(transaction, op);  // unlock and unpin all ancester pages
-//     }
-//     page = child_page;  // update now page to child page
-//     node = child_node;  // update now node to child node
-//   }                     // end while
-//   // LOG_INFO("END FindLeafPage key=%ld Thread=%lu", key.ToString(), getThreadId());  // DEBUG
-//   // bool* a=new bool;
-//   if (root_is_latched_ != nullptr) {
-//     *root_is_latched_ = root_is_latched;
-//   }
-//   return page;
-// }
-
 INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
-  return FindLeafPageByOperation(key, Operation::FIND, nullptr, leftMost, false).first;
+  ReadPageGuard leaf_guard = FindLeafRead(key, leftMost);
+  if (!leaf_guard.IsValid()) {
+    return nullptr;
+  }
+  // 多pin一次再释放guard，返回的page仍然是pin住的
+  return buffer_pool_manager_->FetchPage(leaf_guard.PageId());
 }
 
+/*
+ * 读操作的latch crabbing：先锁住孩子结点，再释放父结点
+ * 根结点不加root_latch_：读取root_page_id_后读锁住这个page，再验证root_page_id_没有改变，否则重试
+ * 修改root_page_id_的写操作都持有旧根结点的写锁，所以读锁住的page通过验证后，在释放前一直是根结点
+ * 旧的root page id可能已经不是根结点，用OptimisticReadScope登记，它在登记的读操作结束前不会被删除
+ * @return : guard of the leaf page, pinned and R Latched, empty if the tree is empty
+ */
 INDEX_TEMPLATE_ARGUMENTS
-std::pair<Page *, bool> BPLUSTREE_TYPE::FindLeafPageByOperation(const KeyType &key, Operation operation,
-                                                                Transaction *transaction, bool leftMost,
-                                                                bool rightMost) {
-  assert(operation == Operation::FIND ? !(leftMost && rightMost) : transaction != nullptr);
-
-  // LOG_INFO("BEGIN FindLeafPage key=%ld Thread=%lu Operation=%d", key.ToString(), getThreadId(),
-  //          OpToString(operation));  // DEBUG
-
-  root_latch_.lock();
-  bool is_root_page_id_latched = true;
-
-  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
-  BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
-
-  if (operation == Operation::FIND) {
-    page->RLatch();
-    is_root_page_id_latched = false;
-    root_latch_.unlock();
-  } else {
-    page->WLatch();
-    if (IsSafe(node, operation)) {
-      is_root_page_id_latched = false;
-      root_latch_.unlock();
+ReadPageGuard BPLUSTREE_TYPE::FindLeafRead(const KeyType &key, bool leftMost, bool rightMost) {
+  assert(!(leftMost && rightMost));
+  if (optimistic_reads_) {
+    // 乐观锁耦合：只读锁住leaf，加锁后leaf的版本没变，说明它就是不加锁时找到的leaf
+    OptimisticReadScope scope(this);
+    while (true) {
+      uint64_t version;
+      BasicPageGuard leaf_guard = FindLeafOptimisticRead(key, leftMost, rightMost, &version);
+      if (!leaf_guard.IsValid()) {
+        return ReadPageGuard();  // 空树
+      }
+      ReadPageGuard guard = leaf_guard.UpgradeRead();
+      if (guard.ValidateVersion(version)) {
+        return guard;
+      }
     }
   }
 
-  while (!node->IsLeafPage()) {
-    InternalPage *i_node = reinterpret_cast<InternalPage *>(node);
+  OptimisticReadScope scope(this);
+  ReadPageGuard guard;
+  while (true) {
+    page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      return ReadPageGuard();  // 空树
+    }
+    guard = buffer_pool_manager_->FetchPageRead(root_page_id);
+    if (root_page_id_ == root_page_id) {
+      break;
+    }
+  }
 
-    page_id_t child_node_page_id;
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    const InternalPage *internal_node = guard.As<InternalPage>();
+    page_id_t child_page_id;
     if (leftMost) {
-      child_node_page_id = i_node->ValueAt(0);
+      child_page_id = internal_node->ValueAt(0);
     } else if (rightMost) {
-      child_node_page_id = i_node->ValueAt(i_node->GetSize() - 1);
+      child_page_id = internal_node->ValueAt(internal_node->GetSize() - 1);
     } else {
-      child_node_page_id = i_node->Lookup(key, comparator_);
+      child_page_id = internal_node->Lookup(key, comparator_);
     }
+    // 赋值guard时才会释放父结点，此时孩子结点已经锁住
+    ReadPageGuard child_guard = buffer_pool_manager_->FetchPageRead(child_page_id);
+    guard = std::move(child_guard);
+  }
+  return guard;
+}
 
-    auto child_page = buffer_pool_manager_->FetchPage(child_node_page_id);
-    auto child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
-
-    if (operation == Operation::FIND) {
-      child_page->RLatch();
-      page->RUnlatch();
-      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    } else {
-      child_page->WLatch();
-      transaction->AddIntoPageSet(page);
-      // child node is safe, release all locks on ancestors
-      if (IsSafe(child_node, operation)) {
-        if (is_root_page_id_latched) {
-          is_root_page_id_latched = false;
-          root_latch_.unlock();
-        }
-        UnlockUnpinPages(transaction);
+/*
+ * 乐观锁耦合（optimistic lock coupling）的读操作：向下查找时不加读锁，只pin住page，读取后验证page的版本
+ * 读出孩子结点的page id后先验证父结点的版本再fetch孩子结点，fetch后再验证一次父结点，这时孩子结点一定还在树中
+ * 任何一次验证失败，或者遇到被写锁住的结点，都从根结点重新开始
+ * 调用前必须用OptimisticReadScope登记，被合并掉的page在登记的读操作结束前不会被删除
+ * @param[out] version the version of the leaf page, the caller validates it after reading the leaf page
+ * @return : guard of the leaf page, pinned but not latched, empty if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+BasicPageGuard BPLUSTREE_TYPE::FindLeafOptimisticRead(const KeyType &key, bool leftMost, bool rightMost,
+                                                      uint64_t *version) {
+  while (true) {
+    page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      return BasicPageGuard();
+    }
+    BasicPageGuard guard = buffer_pool_manager_->FetchPageBasic(root_page_id);
+    uint64_t guard_version = guard.Version();
+    // 修改root_page_id_的写操作都持有旧根结点的写锁，所以只要版本不变，这个page就一直是根结点
+    bool valid = (guard_version & 1) == 0 && root_page_id_ == root_page_id;
+    while (valid && !guard.As<BPlusTreePage>()->IsLeafPage()) {
+      const InternalPage *internal_node = guard.As<InternalPage>();
+      page_id_t child_page_id;
+      if (leftMost) {
+        child_page_id = internal_node->ValueAt(0);
+      } else if (rightMost) {
+        child_page_id = internal_node->ValueAt(internal_node->GetSize() - 1);
+      } else {
+        child_page_id = internal_node->Lookup(key, comparator_);
+      }
+      // 没有验证过的page id可能是写操作写了一半的数据，不能拿去fetch
+      if (!guard.ValidateVersion(guard_version)) {
+        valid = false;
+        break;
+      }
+      BasicPageGuard child_guard = buffer_pool_manager_->FetchPageBasic(child_page_id);
+      uint64_t child_version = child_guard.Version();
+      if ((child_version & 1) != 0 || !guard.ValidateVersion(guard_version)) {
+        valid = false;
+        break;
       }
+      guard = std::move(child_guard);
+      guard_version = child_version;
     }
-
-    page = child_page;
-    node = child_node;
-  }  // end while
-
-  // LOG_INFO("END FindLeafPage key=%ld Thread=%lu Operation=%d", key.ToString(), getThreadId(),
-  //          OpToString(operation));  // DEBUG
-
-  return std::make_pair(page, is_root_page_id_latched);
+    if (valid) {
+      *version = guard_version;
+      return guard;
+    }
+    std::this_thread::yield();  // 多半是有写操作正在修改路径上的结点
+  }
 }
 
-/* unlock all pages */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::UnlockPages(Transaction *transaction) {
-  if (transaction == nullptr) {
-    return;
+BPLUSTREE_TYPE::OptimisticReadScope::OptimisticReadScope(BPlusTree *tree) {
+  static thread_local const size_t slot = std::hash<std::thread::id>()(std::this_thread::get_id()) % READER_SLOTS;
+  while (true) {
+    uint64_t epoch = tree->epoch_;
+    count_ = &tree->reader_slots_[slot].count_[epoch & 1];
+    count_->fetch_add(1);
+    // 登记后epoch_没变，WaitForOptimisticReads就一定会等这个读操作
+    if (tree->epoch_ == epoch) {
+      return;
+    }
+    count_->fetch_sub(1);
   }
+}
 
-  // unlock 和 unpin 事务经过的所有parent page
-  for (Page *page : *transaction->GetPageSet()) {  // 前面加*是因为page set是shared_ptr类型
-    page->WUnlatch();
+/*
+ * 被合并掉的page和换下来的旧根结点已经从树中摘除，之后开始的读操作都不会再读到它的page id，登记在新的epoch中
+ * 之前开始的读操作登记在旧的epoch中，等它们都结束后就可以删除这些page了
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::WaitForOptimisticReads() {
+  std::scoped_lock lock(epoch_latch_);
+  uint64_t epoch = epoch_.fetch_add(1);
+  for (ReaderSlot &reader_slot : reader_slots_) {
+    while (reader_slot.count_[epoch & 1] != 0) {
+      std::this_thread::yield();
+    }
   }
-  transaction->GetPageSet()->clear();  // 清空page set
-
-  // 如果root的mutex被此线程锁住则解锁
-  // if (root_is_latched_) {
-  //   root_is_latched_ = false;
-  //   root_latch_.unlock();
-  // }
 }
 
-/* unlock and unpin all pages */
+/*
+ * 在缓冲池中删除page。被其它线程（例如预取）暂时pin住的page删除失败，留到下一次删除page时重试，
+ * 否则它在文件中的空间永远不会被释放
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::UnlockUnpinPages(Transaction *transaction) {
-  // LOG_INFO("ENTER UnlockUnpinPages Thread=%ld", getThreadId());
+void BPLUSTREE_TYPE::DeletePages(const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock lock(pending_deletes_latch_);
+  pending_deletes_.insert(pending_deletes_.end(), page_ids.begin(), page_ids.end());
+  auto end = std::remove_if(pending_deletes_.begin(), pending_deletes_.end(),
+                            [this](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); });
+  pending_deletes_.erase(end, pending_deletes_.end());
+}
 
-  // 如果root的mutex被此线程锁住则解锁
-  // if (root_is_latched_) {
-  //   root_is_latched_ = false;
-  //   root_latch_.unlock();
-  // }
+/*
+ * 写操作的latch crabbing：锁住孩子结点后，如果孩子结点是安全的（不会拆分或合并），就释放root_latch_和所有祖先结点
+ * 调用前ctx->root_lock_必须已经锁住，且树非空
+ * 结束后ctx->write_set_.back()是leaf page，它前面是所有仍然锁住的（不安全的）祖先结点
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FindLeafWrite(const KeyType &key, Operation op, Context *ctx) {
+  assert(ctx->root_lock_.owns_lock() && !IsEmpty());
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(root_page_id_);
+  if (IsSafe(guard.As<BPlusTreePage>(), op)) {
+    ctx->root_lock_.unlock();
+  }
 
-  if (transaction == nullptr) {
-    return;
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    page_id_t child_page_id = guard.As<InternalPage>()->Lookup(key, comparator_);
+    WritePageGuard child_guard = buffer_pool_manager_->FetchPageWrite(child_page_id);
+    ctx->write_set_.push_back(std::move(guard));
+    // child node is safe, release all locks on ancestors
+    if (IsSafe(child_guard.As<BPlusTreePage>(), op)) {
+      if (ctx->root_lock_.owns_lock()) {
+        ctx->root_lock_.unlock();
+      }
+      ctx->write_set_.clear();
+    }
+    guard = std::move(child_guard);
   }
+  ctx->write_set_.push_back(std::move(guard));
+}
 
-  // auto pages = transaction->GetPageSet().get();
-  // LOG_INFO("transaction page set size = %d", (int)pages->size());
-
-  // unlock 和 unpin 事务经过的所有parent page
-  for (Page *page : *transaction->GetPageSet()) {  // 前面加*是因为page set是shared_ptr类型
-    // BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
-    // LOG_INFO("unlock page id=%d Thread=%ld", page->GetPageId(), getThreadId());
-    // if (node->IsRootPage() && root_is_latched_) {
-    //   LOG_INFO("unlock root page id=%d Thread=%ld", page->GetPageId(), getThreadId());
-    //   root_latch_.unlock();
-    //   root_is_latched_ = false;
-    // }
-
-    page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);  // 疑问：此处dirty为false还是true？
-    // 应该是false，此函数只在向下find leaf page时使用，向上进行修改时是手动一步步unpin true，这里是一次性unpin
-
-    // if (op == Operation::FIND) {
-    //   // 释放读锁
-    //   page->RUnlatch();
-    //   buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    // } else {
-    //   // 释放写锁
-    //   page->WUnlatch();
-    //   buffer_pool_manager_->UnpinPage(page->GetPageId(), false);  // 疑问：此处dirty为false还是true？
-    // }
+/*
+ * 乐观的latch crabbing：和读操作一样用读锁向下，只写锁leaf page
+ * leaf安全时（不会拆分或合并）只修改leaf，不需要锁住任何祖先结点，写操作之间就不会在根结点上排队
+ * 孩子结点的类型在加锁前读取：page的类型初始化后就不变，并且父结点的读锁保证孩子结点不会被合并删除
+ * @return : true if ctx->write_set_ holds the W Latched leaf page and it is safe, false if the tree is empty or the
+ * leaf is not safe (nothing is latched then)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, Operation op, Context *ctx) {
+  // 和FindLeafRead一样，不加root_latch_，锁住根结点后验证root_page_id_没有改变，否则重试
+  OptimisticReadScope scope(this);
+  ReadPageGuard guard;
+  while (true) {
+    page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+    BasicPageGuard root_guard = buffer_pool_manager_->FetchPageBasic(root_page_id);
+    // 加锁前读取的类型只是猜测：这个page可能已经不是根结点，验证时要再检查一次
+    if (root_guard.As<BPlusTreePage>()->IsLeafPage()) {
+      // 根结点就是leaf
+      WritePageGuard leaf_guard = root_guard.UpgradeWrite();
+      if (root_page_id_ == root_page_id && leaf_guard.As<BPlusTreePage>()->IsLeafPage()) {
+        ctx->write_set_.push_back(std::move(leaf_guard));
+        break;
+      }
+    } else {
+      guard = root_guard.UpgradeRead();
+      if (root_page_id_ == root_page_id && !guard.As<BPlusTreePage>()->IsLeafPage()) {
+        break;
+      }
+      guard.Drop();  // 下面用guard是否有效区分根结点是不是leaf
+    }
+  }
+  while (guard.IsValid()) {
+    page_id_t child_page_id = guard.As<InternalPage>()->Lookup(key, comparator_);
+    BasicPageGuard child_guard = buffer_pool_manager_->FetchPageBasic(child_page_id);
+    if (child_guard.As<BPlusTreePage>()->IsLeafPage()) {
+      // 写锁住leaf后才释放父结点的读锁
+      ctx->write_set_.push_back(child_guard.UpgradeWrite());
+      break;
+    }
+    guard = child_guard.UpgradeRead();
+  }
+  const WritePageGuard &leaf_guard = ctx->write_set_.back();
+  if (!IsSafe(leaf_guard.As<BPlusTreePage>(), op)) {
+    ctx->write_set_.clear();
+    return false;
   }
-  transaction->GetPageSet()->clear();  // 清空page set
-
-  // delete page 疑问：此处需要区分operation是否为delete吗？
-  // if (op == Operation::DELETE) {
-  //   for (page_id_t page_id : *transaction->GetDeletedPageSet()) {
-  //     buffer_pool_manager_->DeletePage(page_id);
-  //   }
-  //   transaction->GetDeletedPageSet()->clear();  // 清空deleted page set
-  // }
+  return true;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::IsSafe(N *node, Operation op) {
+bool BPLUSTREE_TYPE::IsSafe(const N *node, Operation op) {
   if (node->IsRootPage()) {
     return (op == Operation::INSERT && node->GetSize() < node->GetMaxSize() - 1) ||
            (op == Operation::DELETE && node->GetSize() > 2);
@@ -1036,8 +925,6 @@ bool BPLUSTREE_TYPE::IsSafe(N *node, Operation op) {
     return node->GetSize() > node->GetMinSize();
   }
 
-  // LOG_INFO("IsSafe Thread=%ld", getThreadId());
-
   return true;
 }
 
@@ -1051,7 +938,8 @@ bool BPLUSTREE_TYPE::IsSafe(N *node, Operation op) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  WritePageGuard header_guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  HeaderPage *header_page = header_guard.AsMut<HeaderPage>();
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
@@ -1059,7 +947,6 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -1225,4 +1112,7 @@ template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class BPlusTree<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>>;
+template class BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>>;
+
 }  // namespace bustub
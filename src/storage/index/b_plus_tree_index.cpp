@@ -9,6 +9,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+
 #include "storage/index/b_plus_tree_index.h"
 
 namespace bustub {
@@ -16,10 +18,11 @@ namespace bustub {
  * Constructor
  */
 INDEX_TEMPLATE_ARGUMENTS
-BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager)
+BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(IndexMetadata *metadata, BufferPoolManager *buffer_pool_manager,
+                                     file_id_t file_id)
     : Index(metadata),
       comparator_(metadata->GetKeySchema()),
-      container_(metadata->GetName(), buffer_pool_manager, comparator_) {}
+      container_(metadata->GetName(), buffer_pool_manager, comparator_, LEAF_PAGE_SIZE, INTERNAL_PAGE_SIZE, file_id) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
@@ -48,6 +51,20 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, T
   container_.GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(std::vector<std::pair<KeyType, ValueType>> *entries) {
+  // stable sort, so that the first entry of a key is the one kept
+  std::stable_sort(entries->begin(), entries->end(), [this](const auto &left, const auto &right) {
+    return comparator_(left.first, right.first) < 0;
+  });
+  auto last = std::unique(entries->begin(), entries->end(), [this](const auto &left, const auto &right) {
+    return comparator_(left.first, right.first) == 0;
+  });
+  entries->erase(last, entries->end());
+
+  container_.BulkLoad(*entries);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator() { return container_.begin(); }
 
@@ -63,4 +80,7 @@ template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class BPlusTreeIndex<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>>;
+template class BPlusTreeIndex<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>>;
+
 }  // namespace bustub
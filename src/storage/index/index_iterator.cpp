@@ -2,6 +2,7 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
 #include "storage/index/index_iterator.h"
 
@@ -12,23 +13,12 @@ namespace bustub {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, Page *page, int index)
-    : buffer_pool_manager_(bpm), page_(page), index_(index) {
-  leaf_ = reinterpret_cast<LeafPage *>(page_->GetData());
-  // LOG_INFO("ENTER IndexIterator()");
-  // LOG_INFO("LEAVE IndexIterator()");
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index, size_t read_ahead_pages)
+    : buffer_pool_manager_(bpm), guard_(std::move(guard)), index_(index), read_ahead_pages_(read_ahead_pages) {
+  leaf_ = guard_.As<LeafPage>();
+  ReadAhead();
 }
 
-INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {
-  // LOG_INFO("ENTER ~IndexIterator()");
-  // assert(leaf_ != nullptr);
-  // assert(leaf_->GetPageId());
-  page_->RUnlatch();
-  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
-  // LOG_INFO("LEAVE ~IndexIterator()");
-}  // 记得unpin leaf
-
 INDEX_TEMPLATE_ARGUMENTS
 bool INDEXITERATOR_TYPE::isEnd() { return leaf_->GetNextPageId() == INVALID_PAGE_ID && index_ == leaf_->GetSize(); }
 
@@ -45,19 +35,26 @@ INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
   // 若index加1后指向当前leaf末尾（但不是整个叶子层的末尾），则进入下一个leaf且index置0
   index_++;
   if (index_ == leaf_->GetSize() && leaf_->GetNextPageId() != INVALID_PAGE_ID) {
-    Page *next_page = buffer_pool_manager_->FetchPage(leaf_->GetNextPageId());  // pin next leaf page
-    next_page->RLatch();
-
-    page_->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);  // unpin current leaf page
-
-    page_ = next_page;
-    leaf_ = reinterpret_cast<LeafPage *>(page_->GetData());  // update leaf page to next page
-    index_ = 0;                                              // reset index to zero
+    // 先锁住next leaf，再释放当前leaf（赋值guard时自动unlatch和unpin）
+    ReadPageGuard next_guard = buffer_pool_manager_->FetchPageRead(leaf_->GetNextPageId());
+    guard_ = std::move(next_guard);
+    leaf_ = guard_.As<LeafPage>();  // update leaf page to next page
+    index_ = 0;                     // reset index to zero
+    ReadAhead();
   }
   return *this;
 }
 
+/**
+ * 预读当前leaf之后的read_ahead_pages_个leaf。已经在缓冲池中的leaf会被很快跳过，所以顺序扫描时每个leaf只会新读一个
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::ReadAhead() {
+  if (read_ahead_pages_ > 0) {
+    buffer_pool_manager_->PrefetchPage(leaf_->GetNextPageId(), NextLeafPageId, read_ahead_pages_);
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 bool INDEXITERATOR_TYPE::operator==(const IndexIterator &itr) const {
   return leaf_->GetPageId() == itr.leaf_->GetPageId() && index_ == itr.index_;  // leaf page和index均相同
@@ -76,4 +73,8 @@ template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
 
 template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class IndexIterator<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>>;
+
+template class IndexIterator<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>>;
+
 }  // namespace bustub
@@ -210,18 +210,17 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient
  * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(const MappingType *items, int size,
+                                               BufferPoolManager *buffer_pool_manager) {
   // [items,items+size)复制到当前page的array最后一个之后的空间
   std::copy(items, items + size, array + GetSize());
   // 修改array中的value的parent page id，其中array范围为[GetSize(), GetSize() + size)
   for (int i = GetSize(); i < GetSize() + size; i++) {
     // ValueAt(i)得到的是array中的value指向的孩子结点的page id
-    Page *child_page = buffer_pool_manager->FetchPage(ValueAt(i));
-    BPlusTreePage *child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());  // 记得加上GetData()
     // Since it is an internal page, the moved entry(page)'s parent needs to be updated
-    child_node->SetParentPageId(GetPageId());  // 特别注意这里，别写成child_page->GetPageId()
-    // 注意，UnpinPage的dirty参数要为true，因为修改了page->data转为node后的ParentPageId，即修改了page->data
-    buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
+    // 通过AsMut修改page->data转为node后的ParentPageId，guard析构时会以dirty的状态unpin
+    BasicPageGuard child_guard = buffer_pool_manager->FetchPageBasic(ValueAt(i));
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());  // 特别注意这里，别写成child的page id
   }
   // 复制后空间增大了size
   IncreaseSize(size);
@@ -307,10 +306,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &item, Buffe
   array[GetSize()] = item;
 
   // update parent page id of child page
-  Page *child_page = buffer_pool_manager->FetchPage(ValueAt(GetSize()));
-  BPlusTreePage *child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
-  child_node->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
+  BasicPageGuard child_guard = buffer_pool_manager->FetchPageBasic(ValueAt(GetSize()));
+  child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
 
   IncreaseSize(1);
 }
@@ -348,10 +345,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &item, Buff
   array[0] = item;
 
   // update parent page id of child page
-  Page *child_page = buffer_pool_manager->FetchPage(ValueAt(0));
-  BPlusTreePage *child_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
-  child_node->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(child_page->GetPageId(), true);
+  BasicPageGuard child_guard = buffer_pool_manager->FetchPageBasic(ValueAt(0));
+  child_guard.AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
 
   IncreaseSize(1);
 }
@@ -362,4 +357,7 @@ template class BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator
 template class BPlusTreeInternalPage<GenericKey<16>, page_id_t, GenericComparator<16>>;
 template class BPlusTreeInternalPage<GenericKey<32>, page_id_t, GenericComparator<32>>;
 template class BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+
+template class BPlusTreeInternalPage<IntegerKey<int32_t>, page_id_t, IntegerComparator<int32_t>>;
+template class BPlusTreeInternalPage<IntegerKey<int64_t>, page_id_t, IntegerComparator<int64_t>>;
 }  // namespace bustub
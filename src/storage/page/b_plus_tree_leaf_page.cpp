@@ -103,7 +103,7 @@ KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
+const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const {
   // replace with your own code
   return array[index];
 }
@@ -157,7 +157,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
  * Copy starting from items, and copy {size} number of elements into me.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(const MappingType *items, int size) {
   std::copy(items, items + size, array + GetSize());  // [items,items+size)复制到该page的array最后一个之后的空间
   IncreaseSize(size);                                 // 复制后空间增大了size
 }
@@ -305,4 +305,7 @@ template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeLeafPage<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeLeafPage<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+template class BPlusTreeLeafPage<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>>;
+template class BPlusTreeLeafPage<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>>;
 }  // namespace bustub
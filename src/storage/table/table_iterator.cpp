@@ -11,13 +11,19 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <memory>
+#include <utility>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+/** Follows the linked list of table pages, for BufferPoolManager::PrefetchPage. */
+static page_id_t NextTablePageId(Page *page) { return static_cast<TablePage *>(page)->GetNextPageId(); }
+
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(std::move(strategy)) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
@@ -35,20 +41,18 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
+  auto cur_page = buffer_pool_manager->FetchPageRead(tuple_->rid_.GetPageId(), strategy_);
+  assert(cur_page.IsValid());  // all pages are pinned
+  ReadAhead(cur_page.As<TablePage>());
 
   RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 &next_tuple_rid)) {  // end of this page
-    while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
-      if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
+  if (!cur_page.As<TablePage>()->GetNextTupleRid(tuple_->rid_,
+                                                 &next_tuple_rid)) {  // end of this page
+    while (cur_page.As<TablePage>()->GetNextPageId() != INVALID_PAGE_ID) {
+      auto next_page = buffer_pool_manager->FetchPageRead(cur_page.As<TablePage>()->GetNextPageId(), strategy_);
+      cur_page = std::move(next_page);
+      ReadAhead(cur_page.As<TablePage>());
+      if (cur_page.As<TablePage>()->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
     }
@@ -59,11 +63,19 @@ TableIterator &TableIterator::operator++() {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
   // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
   return *this;
 }
 
+void TableIterator::ReadAhead(const TablePage *page) {
+  if (table_heap_->read_ahead_pages_ == 0 || page->GetTablePageId() == read_ahead_page_id_) {
+    return;
+  }
+  read_ahead_page_id_ = page->GetTablePageId();
+  // The pages already in the buffer pool are skipped quickly, so in a steady scan this reads one new page per page
+  table_heap_->buffer_pool_manager_->PrefetchPage(page->GetNextPageId(), NextTablePageId,
+                                                  table_heap_->read_ahead_pages_, strategy_);
+}
+
 TableIterator TableIterator::operator++(int) {
   TableIterator clone(*this);
   ++(*this);
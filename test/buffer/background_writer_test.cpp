@@ -0,0 +1,172 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// background_writer_test.cpp
+//
+// Identification: test/buffer/background_writer_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BackgroundWriterTest, CleansVictimsTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: fill the pool with dirty, unpinned pages.
+  page_id_t page_id;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the writer cleans the victims in the background.
+  BackgroundWriterOptions options;
+  options.interval_ = std::chrono::milliseconds(1);
+  options.low_watermark_ = buffer_pool_size;
+  options.high_watermark_ = buffer_pool_size;
+  bpm->RunBackgroundWriter(options);
+  for (int i = 0; i < 1000 && bpm->GetNumBackgroundWriteBacks() < buffer_pool_size; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(buffer_pool_size, bpm->GetNumBackgroundWriteBacks());
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_FALSE(bpm->GetPages()[i].IsDirty());
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  // Scenario: evicting the cleaned pages needs no synchronous write-back, and their content survives.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->GetNumSyncWriteBacks());
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BackgroundWriterTest, FlushAllPagesTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+
+  // Scenario: the writer has taken the page and cleared its dirty flag, but waits for the page latch to write it.
+  page->WLatch();
+  BackgroundWriterOptions options;
+  options.interval_ = std::chrono::milliseconds(1);
+  options.low_watermark_ = buffer_pool_size;
+  options.high_watermark_ = buffer_pool_size;
+  bpm->RunBackgroundWriter(options);
+  for (int i = 0; i < 1000 && page->IsDirty(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_FALSE(page->IsDirty());
+
+  // Scenario: flushing all pages writes it anyway, the sync that follows must not miss it.
+  bpm->FlushAllPages();
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(page_id, data);
+  EXPECT_EQ(0, strcmp(data, ("page " + std::to_string(page_id)).c_str()));
+  page->WUnlatch();
+  bpm->StopBackgroundWriter();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BackgroundWriterTest, ConcurrentModificationTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t num_pages = 64;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(4, buffer_pool_size / 4, disk_manager);
+
+  BackgroundWriterOptions options;
+  options.interval_ = std::chrono::milliseconds(1);
+  bpm->RunBackgroundWriter(options);
+
+  // Scenario: threads keep updating counters stored in pages while the writers clean them.
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  for (size_t i = 0; i < num_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    page_ids.push_back(page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  const int num_threads = 4;
+  const int rounds = 50;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, &page_ids, tid]() {
+      for (int round = 0; round < rounds; round++) {
+        for (size_t i = tid; i < page_ids.size(); i += num_threads) {
+          Page *page = bpm->FetchPage(page_ids[i]);
+          ASSERT_NE(nullptr, page);
+          page->WLatch();
+          ++*reinterpret_cast<int *>(page->GetData());
+          page->WUnlatch();
+          bpm->UnpinPage(page_ids[i], true);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  bpm->StopBackgroundWriter();
+
+  // Scenario: no update was lost, whether the page was written back in the background or on eviction.
+  for (page_id_t id : page_ids) {
+    Page *page = bpm->FetchPage(id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(rounds, *reinterpret_cast<int *>(page->GetData()));
+    bpm->UnpinPage(id, false);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
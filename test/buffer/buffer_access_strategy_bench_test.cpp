@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy_bench_test.cpp
+//
+// Identification: test/buffer/buffer_access_strategy_bench_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Benchmark of an OLTP workload running next to sequential scans, with and without a buffer ring for the scans.
+ *
+ * Workload:
+ *    buffer pool: 64 frames
+ *    OLTP: 48 hot pages, one random page fetched every 50 tuples of the scan
+ *    scans: 3 full scans of a table of 10000 random tuples (~95 pages)
+ *
+ * Result:
+ * [BENCHMARK: BufferAccessStrategyBenchTest] ring=off oltp_hit_ratio=X
+ * [BENCHMARK: BufferAccessStrategyBenchTest] ring=on oltp_hit_ratio=Y
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "logging/common.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+const size_t POOL_SIZE = 64;
+const size_t NUM_HOT_PAGES = 48;
+const int NUM_TUPLES = 10000;
+const int NUM_SCANS = 3;
+
+double RunMixedWorkload(bool use_ring) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(POOL_SIZE, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *transaction = new Transaction(0);
+  auto *table = new TableHeap(bpm, lock_manager, log_manager, transaction);
+  Column col1{"a", TypeId::VARCHAR, 200};
+  Column col2{"b", TypeId::BIGINT};
+  Schema schema{{col1, col2}};
+  for (int i = 0; i < NUM_TUPLES; i++) {
+    RID rid;
+    EXPECT_TRUE(table->InsertTuple(ConstructTuple(&schema), &rid, transaction));
+  }
+  std::vector<page_id_t> hot_page_ids(NUM_HOT_PAGES);
+  for (auto &page_id : hot_page_ids) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, true);
+  }
+
+  std::default_random_engine rng(15445);
+  std::uniform_int_distribution<size_t> dist(0, NUM_HOT_PAGES - 1);
+  size_t oltp_accesses = 0;
+  size_t oltp_hits = 0;
+  for (int scan = 0; scan < NUM_SCANS; scan++) {
+    auto strategy = use_ring ? std::make_shared<BufferAccessStrategy>() : nullptr;
+    int count = 0;
+    for (auto itr = table->Begin(transaction, strategy); itr != table->End(); ++itr) {
+      if (++count % 50 != 0) {
+        continue;
+      }
+      page_id_t page_id = hot_page_ids[dist(rng)];
+      size_t hits = bpm->GetNumHits();
+      Page *page = bpm->FetchPage(page_id);
+      EXPECT_NE(nullptr, page);
+      oltp_accesses++;
+      oltp_hits += bpm->GetNumHits() - hits;
+      bpm->UnpinPage(page_id, false);
+    }
+    EXPECT_EQ(NUM_TUPLES, count);
+  }
+  double hit_ratio = static_cast<double>(oltp_hits) / oltp_accesses;
+  std::cout << "[BENCHMARK: BufferAccessStrategyBenchTest] ring=" << (use_ring ? "on" : "off")
+            << " oltp_hit_ratio=" << hit_ratio << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete transaction;
+  delete log_manager;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+  return hit_ratio;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyBenchTest, OltpHitRatio) {
+  double without_ring = RunMixedWorkload(false);
+  double with_ring = RunMixedWorkload(true);
+  EXPECT_GT(with_ring, without_ring);
+}
+
+}  // namespace bustub
@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy_test.cpp
+//
+// Identification: test/buffer/buffer_access_strategy_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyTest, RingTest) {
+  const size_t buffer_pool_size = 10;
+  const size_t ring_size = 3;
+  const size_t num_hot_pages = 5;
+  const size_t num_scan_pages = 20;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: create the pages to be scanned, then the hot pages, which stay in the buffer pool.
+  std::vector<page_id_t> scan_page_ids(num_scan_pages);
+  for (auto &page_id : scan_page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  std::vector<page_id_t> hot_page_ids(num_hot_pages);
+  for (auto &page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a scan through the strategy reads every page correctly, and only uses ring_size frames.
+  auto strategy = std::make_shared<BufferAccessStrategy>(ring_size);
+  EXPECT_EQ(ring_size, strategy->GetRingSize());
+  for (page_id_t page_id : scan_page_ids) {
+    auto *page = bpm->FetchPage(page_id, strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  size_t hits = bpm->GetNumHits();
+  for (page_id_t page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(hits + num_hot_pages, bpm->GetNumHits());
+
+  // Scenario: a pinned ring frame is not reused, the scan takes another victim instead.
+  ASSERT_NE(nullptr, bpm->FetchPage(scan_page_ids[num_scan_pages - ring_size]));
+  for (size_t i = 0; i < ring_size; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(scan_page_ids[i], strategy));
+    EXPECT_TRUE(bpm->UnpinPage(scan_page_ids[i], false));
+  }
+  auto *page = bpm->FetchPage(scan_page_ids[num_scan_pages - ring_size]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(2, page->GetPinCount());
+  EXPECT_TRUE(bpm->UnpinPage(scan_page_ids[num_scan_pages - ring_size], false));
+  EXPECT_TRUE(bpm->UnpinPage(scan_page_ids[num_scan_pages - ring_size], false));
+
+  // Scenario: the same scan without the strategy flushes the hot pages out of the buffer pool.
+  for (page_id_t page_id : scan_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  hits = bpm->GetNumHits();
+  for (page_id_t page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(hits, bpm->GetNumHits());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferAccessStrategyTest, ParallelRingTest) {
+  const size_t num_instances = 4;
+  const size_t ring_size = 2;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(num_instances, 4, disk_manager);
+  auto strategy = std::make_shared<BufferAccessStrategy>(ring_size);
+
+  // Scenario: bulk-create pages through the strategy, every shard keeps its own ring.
+  std::vector<page_id_t> page_ids(32);
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id, strategy);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Two frames of every shard are still free
+  std::vector<page_id_t> other_page_ids(num_instances * 2);
+  for (auto &page_id : other_page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  for (page_id_t page_id : other_page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: read the pages back through the strategy, without evicting the other pages.
+  for (page_id_t page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id, strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  size_t misses = bpm->GetNumMisses();
+  for (page_id_t page_id : other_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(misses, bpm->GetNumMisses());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
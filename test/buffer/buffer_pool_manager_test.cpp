@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include <cstdio>
 #include <random>
 #include <string>
@@ -260,4 +261,101 @@ TEST(BufferPoolManagerTest, my_concurrent_SampleTest) {
   delete disk_manager;
 }
 
+// Fills the 32 frames of the pool with new pages, and leaves pages 10 to 14 clean
+static void CheckFlushAllPages(BufferPoolManager *bpm, DiskManager *disk_manager) {
+  page_id_t page_id;
+  for (int i = 0; i < 32; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+  }
+  for (page_id = 0; page_id < 32; page_id++) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, page_id < 10 || page_id > 14));
+  }
+
+  // Two runs of adjacent dirty pages, two writes
+  bpm->FlushAllPages();
+  EXPECT_EQ(27, bpm->GetNumFlushedPages());
+  EXPECT_EQ(2, bpm->GetNumFlushWrites());
+  char data[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  for (page_id = 0; page_id < 32; page_id++) {
+    if (page_id >= 10 && page_id <= 14) {
+      continue;
+    }
+    disk_manager->ReadPage(page_id, data);
+    snprintf(expected, PAGE_SIZE, "page %d", page_id);
+    EXPECT_STREQ(expected, data);
+  }
+
+  // Everything is clean now
+  bpm->FlushAllPages();
+  EXPECT_EQ(27, bpm->GetNumFlushedPages());
+  EXPECT_EQ(2, bpm->GetNumFlushWrites());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManager(32, disk_manager);
+    CheckFlushAllPages(bpm, disk_manager);
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.fsm");
+  }
+  {
+    // The shards hold interleaved page ids, their dirty pages are written together
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new ParallelBufferPoolManager(4, 8, disk_manager);
+    CheckFlushAllPages(bpm, disk_manager);
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.fsm");
+  }
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, DeletePageTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(3, disk_manager);
+  page_id_t page_ids[3];
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // A pinned page is not deleted, a deleted dirty page is not written back
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[1]));
+  EXPECT_FALSE(bpm->DeletePage(page_ids[1]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[1], false));
+  int writes = disk_manager->GetNumWrites();
+  EXPECT_TRUE(bpm->DeletePage(page_ids[1]));
+  EXPECT_EQ(writes, disk_manager->GetNumWrites());
+  EXPECT_FALSE(disk_manager->IsAllocated(page_ids[1]));
+
+  // The frame is free exactly once: the whole pool can be pinned, and no more
+  page_id_t new_page_ids[3];
+  for (auto &page_id : new_page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  EXPECT_EQ(page_ids[1], new_page_ids[0]);
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  for (auto new_page_id : new_page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(new_page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
 }  // namespace bustub
@@ -19,7 +19,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +59,42 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const size_t num_frames = 64;
+  const size_t num_threads = 8;
+  ClockReplacer clock_replacer(num_frames);
+
+  // Scenario: every thread owns num_frames / num_threads frames and repeatedly pins and unpins them.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&clock_replacer, tid]() {
+      for (int round = 0; round < 1000; round++) {
+        for (size_t i = tid; i < num_frames; i += num_threads) {
+          clock_replacer.Unpin(static_cast<frame_id_t>(i));
+          clock_replacer.Pin(static_cast<frame_id_t>(i));
+        }
+      }
+      // leave every owned frame unpinned
+      for (size_t i = tid; i < num_frames; i += num_threads) {
+        clock_replacer.Unpin(static_cast<frame_id_t>(i));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+
+  // Scenario: every frame is victimized exactly once.
+  std::vector<bool> victimized(num_frames, false);
+  int value;
+  for (size_t i = 0; i < num_frames; i++) {
+    ASSERT_TRUE(clock_replacer.Victim(&value));
+    EXPECT_FALSE(victimized[value]);
+    victimized[value] = true;
+  }
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
 }  // namespace bustub
@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// direct_io_bench_test.cpp
+//
+// Identification: test/buffer/direct_io_bench_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Benchmark of the memory footprint and throughput of the buffer pool with a buffered and a direct I/O database file.
+ *
+ * Workload:
+ *    database: 16384 pages (64 MB), buffer pool: 2048 frames (8 MB), so the working set is 8 times the pool
+ *    100000 uniformly random fetches, 10% of them dirty the page; the file is dropped from the OS page cache before
+ *    each run. The footprint is the resident set of the process plus the pages of the file in the OS page cache.
+ *
+ * Result:
+ * [BENCHMARK: DirectIOBenchTest] direct_io=0 fetches_per_sec=X rss_mb=R page_cache_mb=C
+ * [BENCHMARK: DirectIOBenchTest] direct_io=1 fetches_per_sec=Y rss_mb=S page_cache_mb=D
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+const size_t POOL_SIZE = 2048;
+const page_id_t NUM_PAGES = 16384;
+const int NUM_FETCHES = 100000;
+
+static void DropFromPageCache(const char *file_name) {
+  int fd = open(file_name, O_RDONLY);
+  ASSERT_NE(-1, fd);
+  fsync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+/** @return the resident set of the process in MB */
+static double ResidentSetMB() {
+  std::ifstream statm("/proc/self/statm");
+  size_t size = 0;
+  size_t resident = 0;
+  statm >> size >> resident;
+  return static_cast<double>(resident) * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+/** @return the size of the part of the file that is in the OS page cache in MB */
+static double PageCacheMB(const char *file_name) {
+  int fd = open(file_name, O_RDONLY);
+  struct stat stat_buf;
+  fstat(fd, &stat_buf);
+  size_t size = stat_buf.st_size;
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  size_t os_page_size = sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> in_core((size + os_page_size - 1) / os_page_size);
+  mincore(addr, size, in_core.data());
+  munmap(addr, size);
+  size_t cached = 0;
+  for (unsigned char page : in_core) {
+    cached += page & 1;
+  }
+  return static_cast<double>(cached) * os_page_size / (1024 * 1024);
+}
+
+/** @return the page cache footprint of the run in MB */
+static double RandomFetches(bool direct_io) {
+  DropFromPageCache("test.db");
+  auto *disk_manager = new DiskManager("test.db", direct_io);
+  auto *bpm = new BufferPoolManager(POOL_SIZE, disk_manager);
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<page_id_t> page_dist(0, NUM_PAGES - 1);
+  std::uniform_int_distribution<int> percent(0, 99);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < NUM_FETCHES; i++) {
+    page_id_t page_id = page_dist(rng);
+    Page *page = bpm->FetchPage(page_id);
+    EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+    bpm->UnpinPage(page_id, percent(rng) < 10);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double rss_mb = ResidentSetMB();
+  double page_cache_mb = PageCacheMB("test.db");
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << "[BENCHMARK: DirectIOBenchTest] direct_io=" << disk_manager->UsesDirectIO()
+            << " fetches_per_sec=" << static_cast<uint64_t>(NUM_FETCHES / seconds) << " rss_mb=" << rss_mb
+            << " page_cache_mb=" << page_cache_mb << std::endl;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  return page_cache_mb;
+}
+
+// NOLINTNEXTLINE
+TEST(DirectIOBenchTest, FootprintTest) {
+  {
+    // Every page starts with its own page id
+    DiskManager disk_manager("test.db");
+    std::vector<char> data(PAGE_SIZE);
+    for (page_id_t page_id = 0; page_id < NUM_PAGES; page_id++) {
+      memcpy(data.data(), &page_id, sizeof(page_id));
+      disk_manager.WritePage(page_id, data.data());
+    }
+    disk_manager.ShutDown();
+  }
+
+  double buffered_mb = RandomFetches(false);
+  double direct_mb = RandomFetches(true);
+  // With O_DIRECT the pages are only cached by the buffer pool, unless the file system does not support it
+  DiskManager probe("test.db", true);
+  if (probe.UsesDirectIO()) {
+    EXPECT_LT(direct_mb, buffered_mb / 2);
+  }
+  probe.ShutDown();
+
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+}  // namespace bustub
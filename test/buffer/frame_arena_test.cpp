@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+static void CheckArena(FrameArena *arena) {
+  Page *pages = arena->GetPages();
+  for (size_t i = 0; i < arena->GetNumFrames(); i++) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    // The data is page aligned and contiguous, the metadata is cache line aligned
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages[i].GetData()) % PAGE_SIZE);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(&pages[i]) % 64);
+    EXPECT_EQ(arena->GetFrameData(0) + i * PAGE_SIZE, pages[i].GetData());
+    EXPECT_EQ(arena->GetFrameData(frame_id), pages[i].GetData());
+    EXPECT_EQ(INVALID_PAGE_ID, pages[i].GetPageId());
+    EXPECT_EQ(0, pages[i].GetPinCount());
+    EXPECT_FALSE(pages[i].IsDirty());
+    for (int j = 0; j < PAGE_SIZE; j++) {
+      ASSERT_EQ(0, pages[i].GetData()[j]);
+    }
+  }
+  // Every frame can be written without touching its neighbours
+  for (size_t i = 0; i < arena->GetNumFrames(); i++) {
+    memset(pages[i].GetData(), static_cast<int>(i % 128), PAGE_SIZE);
+  }
+  for (size_t i = 0; i < arena->GetNumFrames(); i++) {
+    EXPECT_EQ(static_cast<char>(i % 128), pages[i].GetData()[0]);
+    EXPECT_EQ(static_cast<char>(i % 128), pages[i].GetData()[PAGE_SIZE - 1]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, SmallArenaTest) {
+  FrameArena arena(10);
+  EXPECT_EQ(10, arena.GetNumFrames());
+  // Too small to be worth explicit huge pages
+  EXPECT_FALSE(arena.UsesHugePages());
+  CheckArena(&arena);
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, LargeArenaTest) {
+  // Whether huge pages are used depends on the system, both paths must give the same frames
+  FrameArena huge_arena(1000);
+  CheckArena(&huge_arena);
+  FrameArena arena(1000, false);
+  EXPECT_FALSE(arena.UsesHugePages());
+  CheckArena(&arena);
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, BufferPoolTest) {
+  const size_t buffer_pool_size = 16;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+    EXPECT_GE(page, bpm->GetPages());
+    EXPECT_LT(page, bpm->GetPages() + buffer_pool_size);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t i = 0; i < static_cast<page_id_t>(2 * buffer_pool_size); i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // A page outside of a buffer pool still has its own data
+  Page page;
+  EXPECT_EQ(0, page.GetData()[0]);
+  page.GetData()[PAGE_SIZE - 1] = 'x';
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
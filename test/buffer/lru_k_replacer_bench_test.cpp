@@ -0,0 +1,93 @@
+/**
+ * lru_k_replacer_bench_test.cpp
+ *
+ * THIS TEST WILL NOT BE RUN ON GRADESCOPE
+ *
+ * Benchmark of the buffer pool hit ratio for a point-lookup workload that runs next to a
+ * full sequential scan, comparing the LRU replacer with the LRU-K replacer.
+ *
+ * Configuration:
+ *    buffer pool size: 64
+ *    hot pages (point lookups, uniformly random): 32
+ *    scanned pages (each read once per pass): 1024
+ *    interleaving: 2 scanned pages per point lookup, 4 scan passes
+ *
+ * Result:
+ * [BENCHMARK: LRUKReplacerBenchTest] replacer=LRU lookup_hit_ratio=X overall_hit_ratio=Y
+ * [BENCHMARK: LRUKReplacerBenchTest] replacer=LRU-2 lookup_hit_ratio=X overall_hit_ratio=Y
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+const size_t POOL_SIZE = 64;
+const size_t NUM_HOT_PAGES = 32;
+const size_t NUM_SCAN_PAGES = 1024;
+const size_t SCAN_PAGES_PER_LOOKUP = 2;
+const size_t NUM_SCAN_PASSES = 4;
+
+// Fetch and unpin one page, return true if it was a buffer pool hit.
+bool Touch(BufferPoolManager *bpm, page_id_t page_id) {
+  size_t hits = bpm->GetNumHits();
+  Page *page = bpm->FetchPage(page_id);
+  EXPECT_NE(nullptr, page);
+  bpm->UnpinPage(page_id, false);
+  return bpm->GetNumHits() > hits;
+}
+
+// Run the mixed workload and return the hit ratio of the point lookups.
+double RunMixedWorkload(BufferPoolManager *bpm) {
+  // pages [0, NUM_HOT_PAGES) are hot, the rest belong to the scanned table
+  page_id_t page_id;
+  for (size_t i = 0; i < NUM_HOT_PAGES + NUM_SCAN_PAGES; i++) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, true);
+  }
+
+  std::default_random_engine rng(15445);
+  std::uniform_int_distribution<page_id_t> hot_dist(0, NUM_HOT_PAGES - 1);
+  size_t lookups = 0;
+  size_t lookup_hits = 0;
+  for (size_t pass = 0; pass < NUM_SCAN_PASSES; pass++) {
+    for (size_t i = 0; i < NUM_SCAN_PAGES; i++) {
+      Touch(bpm, static_cast<page_id_t>(NUM_HOT_PAGES + i));
+      if (i % SCAN_PAGES_PER_LOOKUP == 0) {
+        lookups++;
+        lookup_hits += Touch(bpm, hot_dist(rng)) ? 1 : 0;
+      }
+    }
+  }
+  return static_cast<double>(lookup_hits) / lookups;
+}
+
+void RunBenchmark(const std::string &name, ReplacerType replacer_type) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(POOL_SIZE, disk_manager, replacer_type, 2);
+
+  double lookup_hit_ratio = RunMixedWorkload(bpm);
+  double overall_hit_ratio = static_cast<double>(bpm->GetNumHits()) / (bpm->GetNumHits() + bpm->GetNumMisses());
+  std::cout << "[BENCHMARK: LRUKReplacerBenchTest] replacer=" << name << " lookup_hit_ratio=" << lookup_hit_ratio
+            << " overall_hit_ratio=" << overall_hit_ratio << std::endl;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(LRUKReplacerBenchTest, ScanWithPointLookups) {
+  RunBenchmark("LRU", ReplacerType::LRU);
+  RunBenchmark("LRU-2", ReplacerType::LRU_K);
+}
+
+}  // namespace bustub
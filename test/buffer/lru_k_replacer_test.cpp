@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: access frames 1~6 once and frame 1 a second time, then unpin them all.
+  // Frame 1 now has two accesses, every other frame has +inf backward k-distance.
+  for (frame_id_t frame_id = 1; frame_id <= 6; frame_id++) {
+    lru_replacer.RecordAccess(frame_id);
+  }
+  lru_replacer.RecordAccess(1);
+  for (frame_id_t frame_id = 1; frame_id <= 6; frame_id++) {
+    lru_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(6, lru_replacer.Size());
+
+  // Scenario: frames with +inf distance go first, in order of their first access. Frame 1 goes last.
+  int value;
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(3, lru_replacer.Size());
+
+  // Scenario: pin frame 5. It keeps its history but can't be victimized.
+  lru_replacer.Pin(5);
+  EXPECT_EQ(2, lru_replacer.Size());
+
+  // Scenario: access frame 5 again and unpin it, it now has two accesses too.
+  // Frame 1's second most recent access is older than frame 5's, so frame 1 goes before frame 5.
+  lru_replacer.RecordAccess(5);
+  lru_replacer.Unpin(5);
+  EXPECT_EQ(3, lru_replacer.Size());
+
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(0, lru_replacer.Size());
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  LRUKReplacer lru_replacer(10, 2);
+
+  // Scenario: frame 0 is accessed twice, then a scan touches frames 1~9 once each.
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(0);
+  lru_replacer.Unpin(0);
+  for (frame_id_t frame_id = 1; frame_id < 10; frame_id++) {
+    lru_replacer.RecordAccess(frame_id);
+    lru_replacer.Unpin(frame_id);
+  }
+
+  // Scenario: every scanned frame is evicted before the hot frame, although frame 0 is the least recently used.
+  int value;
+  for (frame_id_t frame_id = 1; frame_id < 10; frame_id++) {
+    lru_replacer.Victim(&value);
+    EXPECT_EQ(frame_id, value);
+  }
+  lru_replacer.Victim(&value);
+  EXPECT_EQ(0, value);
+}
+
+}  // namespace bustub
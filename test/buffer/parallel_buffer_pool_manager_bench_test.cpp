@@ -0,0 +1,101 @@
+/**
+ * parallel_buffer_pool_manager_bench_test.cpp
+ *
+ * THIS TEST WILL NOT BE RUN ON GRADESCOPE
+ *
+ * Benchmark of the FetchPage/UnpinPage hit path under a growing number of threads,
+ * comparing a single BufferPoolManager (one global latch) with a ParallelBufferPoolManager.
+ *
+ * Configuration:
+ *    resident pages: 1024 (every fetch is a buffer pool hit)
+ *    shards: 16
+ *    threads: 1, 2, 4, 8, 16
+ *    fetch/unpin pairs per thread: 100000
+ *
+ * Result:
+ * [BENCHMARK: ParallelBufferPoolManagerBenchTest] threads=N single=X ops/s parallel=Y ops/s
+ */
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+const size_t NUM_PAGES = 1024;
+const size_t NUM_SHARDS = 16;
+const size_t OPS_PER_THREAD = 100000;
+
+// Run OPS_PER_THREAD fetch/unpin pairs of resident pages on each thread, return the throughput in ops/s.
+double HitPathThroughput(BufferPoolManager *bpm, const std::vector<page_id_t> &page_ids, size_t num_threads) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, &page_ids, tid]() {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+      for (size_t i = 0; i < OPS_PER_THREAD; i++) {
+        page_id_t page_id = page_ids[dist(rng)];
+        Page *page = bpm->FetchPage(page_id);
+        EXPECT_NE(nullptr, page);
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+  return static_cast<double>(num_threads * OPS_PER_THREAD) / seconds;
+}
+
+// Fill the pool with NUM_PAGES unpinned pages so that every later fetch is a hit.
+std::vector<page_id_t> CreatePages(BufferPoolManager *bpm) {
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < NUM_PAGES; i++) {
+    page_id_t page_id;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, false);
+    page_ids.push_back(page_id);
+  }
+  return page_ids;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerBenchTest, HitPathScaling) {
+  auto *single_disk_manager = new DiskManager("test_single.db");
+  auto *parallel_disk_manager = new DiskManager("test_parallel.db");
+  auto *single_bpm = new BufferPoolManager(NUM_PAGES, single_disk_manager);
+  auto *parallel_bpm = new ParallelBufferPoolManager(NUM_SHARDS, NUM_PAGES / NUM_SHARDS, parallel_disk_manager);
+
+  std::vector<page_id_t> single_page_ids = CreatePages(single_bpm);
+  std::vector<page_id_t> parallel_page_ids = CreatePages(parallel_bpm);
+
+  for (size_t num_threads = 1; num_threads <= 16; num_threads *= 2) {
+    double single = HitPathThroughput(single_bpm, single_page_ids, num_threads);
+    double parallel = HitPathThroughput(parallel_bpm, parallel_page_ids, num_threads);
+    std::cout << "[BENCHMARK: ParallelBufferPoolManagerBenchTest] threads=" << num_threads
+              << " single=" << static_cast<uint64_t>(single) << " ops/s parallel=" << static_cast<uint64_t>(parallel)
+              << " ops/s" << std::endl;
+  }
+
+  single_disk_manager->ShutDown();
+  parallel_disk_manager->ShutDown();
+  remove("test_single.db");
+  remove("test_single.log");
+  remove("test_parallel.db");
+  remove("test_parallel.log");
+  delete single_bpm;
+  delete parallel_bpm;
+  delete single_disk_manager;
+  delete parallel_disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  EXPECT_EQ(num_instances * buffer_pool_size, bpm->GetPoolSize());
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  snprintf(page0->GetData(), PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: We should be able to create new pages until we fill up the buffer pool.
+  // Every page id must be served by the shard it hashes to.
+  std::vector<page_id_t> page_ids{page_id_temp};
+  for (size_t i = 1; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(bpm->GetBufferPoolManager(page_id_temp), bpm->GetBufferPoolManager(page_id_temp % num_instances));
+    page_ids.push_back(page_id_temp);
+  }
+
+  // Scenario: Once the buffer pool is full, we should not be able to create any new pages.
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: After unpinning every page, new pages can be created again. Creating one page per shard
+  // evicts the least recently used page of each shard, which is page 0 in shard 0.
+  for (page_id_t page_id : page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  for (size_t i = 0; i < num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: We should be able to fetch the data we wrote a while ago.
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+  EXPECT_EQ(true, bpm->DeletePage(0));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const int num_threads = 8;
+  const int num_runs = 20;
+  for (int run = 0; run < num_runs; run++) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new ParallelBufferPoolManager(4, 25, disk_manager);
+    std::vector<std::thread> threads;
+
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([bpm]() {
+        page_id_t temp_page_id;
+        std::vector<page_id_t> page_ids;
+        for (int i = 0; i < 10; i++) {
+          auto *new_page = bpm->NewPage(&temp_page_id);
+          ASSERT_NE(nullptr, new_page);
+          strcpy(new_page->GetData(), std::to_string(temp_page_id).c_str());  // NOLINT
+          page_ids.push_back(temp_page_id);
+        }
+        for (int i = 0; i < 10; i++) {
+          EXPECT_EQ(1, bpm->UnpinPage(page_ids[i], true));
+        }
+        for (int j = 0; j < 10; j++) {
+          auto *page = bpm->FetchPage(page_ids[j]);
+          ASSERT_NE(nullptr, page);
+          EXPECT_EQ(0, std::strcmp(std::to_string(page_ids[j]).c_str(), (page->GetData())));
+          EXPECT_EQ(1, bpm->UnpinPage(page_ids[j], true));
+        }
+        for (int j = 0; j < 10; j++) {
+          EXPECT_EQ(1, bpm->DeletePage(page_ids[j]));
+        }
+      });
+    }
+
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.log");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+}  // namespace bustub
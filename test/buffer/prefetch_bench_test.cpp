@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prefetch_bench_test.cpp
+//
+// Identification: test/buffer/prefetch_bench_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Benchmark of a full scan of a cold table, with and without read-ahead.
+ *
+ * Workload:
+ *    table: 20000 random tuples (~190 pages), buffer pool: 64 frames
+ *    before each scan the buffer pool is recreated and the file is dropped from the OS page cache
+ *    the scan does a little work per tuple, which read-ahead can overlap with the next reads
+ *
+ * Result:
+ * [BENCHMARK: PrefetchBenchTest] read_ahead=0 scan_ms=X misses=N prefetches=0
+ * [BENCHMARK: PrefetchBenchTest] read_ahead=8 scan_ms=Y misses=M prefetches=K
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "logging/common.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+const size_t POOL_SIZE = 64;
+const int NUM_TUPLES = 20000;
+
+static void DropFromPageCache(const char *file_name) {
+  int fd = open(file_name, O_RDONLY);
+  ASSERT_NE(-1, fd);
+  fsync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+static void ScanColdTable(DiskManager *disk_manager, page_id_t first_page_id, size_t read_ahead) {
+  DropFromPageCache("test.db");
+  auto *bpm = new BufferPoolManager(POOL_SIZE, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *transaction = new Transaction(0);
+  auto *table = new TableHeap(bpm, lock_manager, log_manager, first_page_id);
+  table->SetReadAheadPages(read_ahead);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  int count = 0;
+  uint64_t checksum = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    for (uint32_t i = 0; i < itr->GetLength(); i++) {
+      checksum = checksum * 31 + static_cast<uint8_t>(itr->GetData()[i]);
+    }
+    count++;
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  EXPECT_EQ(NUM_TUPLES, count);
+
+  std::cout << "[BENCHMARK: PrefetchBenchTest] read_ahead=" << read_ahead
+            << " scan_ms=" << std::chrono::duration<double, std::milli>(end - start).count()
+            << " misses=" << bpm->GetNumMisses() << " prefetches=" << bpm->GetNumPrefetches()
+            << " checksum=" << checksum % 1000 << std::endl;
+
+  delete table;
+  delete transaction;
+  delete log_manager;
+  delete lock_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchBenchTest, ColdTableScan) {
+  auto *disk_manager = new DiskManager("test.db");
+  page_id_t first_page_id;
+  {
+    auto *bpm = new BufferPoolManager(POOL_SIZE, disk_manager);
+    auto *lock_manager = new LockManager();
+    auto *log_manager = new LogManager(disk_manager);
+    auto *transaction = new Transaction(0);
+    auto *table = new TableHeap(bpm, lock_manager, log_manager, transaction);
+    Column col1{"a", TypeId::VARCHAR, 200};
+    Column col2{"b", TypeId::BIGINT};
+    Schema schema{{col1, col2}};
+    for (int i = 0; i < NUM_TUPLES; i++) {
+      RID rid;
+      ASSERT_TRUE(table->InsertTuple(ConstructTuple(&schema), &rid, transaction));
+    }
+    first_page_id = table->GetFirstPageId();
+    bpm->FlushAllPages();
+    delete table;
+    delete transaction;
+    delete log_manager;
+    delete lock_manager;
+    delete bpm;
+  }
+
+  ScanColdTable(disk_manager, first_page_id, 0);
+  ScanColdTable(disk_manager, first_page_id, 8);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+}
+
+}  // namespace bustub
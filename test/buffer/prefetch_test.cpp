@@ -0,0 +1,205 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prefetch_test.cpp
+//
+// Identification: test/buffer/prefetch_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "logging/common.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+// The test pages form a linked list, each page stores the id of the next one at the start of its data.
+static page_id_t NextTestPageId(Page *page) { return *reinterpret_cast<page_id_t *>(page->GetData()); }
+
+static void WaitForPrefetches(BufferPoolManager *bpm, size_t num_prefetches) {
+  for (int i = 0; i < 1000 && bpm->GetNumPrefetches() < num_prefetches; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, PrefetchPageTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: create twice as many pages as fit in the pool, so that the first ones are evicted.
+  page_id_t page_id;
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a prefetched page is in the pool but not pinned, and fetching it is a hit.
+  EXPECT_TRUE(bpm->PrefetchPage(0));
+  WaitForPrefetches(bpm, 1);
+  EXPECT_EQ(1, bpm->GetNumPrefetches());
+  size_t hits = bpm->GetNumHits();
+  auto *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(hits + 1, bpm->GetNumHits());
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 0"));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+
+  // Scenario: prefetching a page that is already in the pool does not read it again.
+  EXPECT_TRUE(bpm->PrefetchPage(0));
+  EXPECT_TRUE(bpm->PrefetchPage(1));
+  WaitForPrefetches(bpm, 2);
+  EXPECT_EQ(2, bpm->GetNumPrefetches());
+
+  // Scenario: prefetched pages can be evicted like any unpinned page.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id - i, false));
+  }
+
+  // Scenario: a page deleted while its prefetch is queued is not read in, so that the new page that reuses its id
+  // is the one in the page table, and is written back to it.
+  EXPECT_TRUE(bpm->DeletePage(2));
+  EXPECT_TRUE(bpm->PrefetchPage(2));
+  EXPECT_TRUE(bpm->PrefetchPage(3));
+  WaitForPrefetches(bpm, 3);
+  EXPECT_EQ(3, bpm->GetNumPrefetches());
+  page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(2, page_id);
+  snprintf(page->GetData(), PAGE_SIZE, "new page 2");
+  EXPECT_TRUE(bpm->UnpinPage(2, true));
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  page = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "new page 2"));
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, PrefetchListTest) {
+  const size_t num_pages = 32;
+  const size_t read_ahead = 8;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(4, 4, disk_manager);
+
+  // Scenario: build a linked list of pages spread over all shards, in reverse order of creation.
+  std::vector<page_id_t> page_ids(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    page_id_t next_page_id = i == 0 ? INVALID_PAGE_ID : page_ids[i - 1];
+    memcpy(page->GetData(), &next_page_id, sizeof(page_id_t));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+  bpm->FlushAllPages();
+
+  // Scenario: evict the list, then prefetch the head of the list and the pages that follow it.
+  std::vector<page_id_t> other_page_ids(16);
+  for (auto &other_page_id : other_page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&other_page_id));
+    EXPECT_TRUE(bpm->UnpinPage(other_page_id, false));
+  }
+  EXPECT_TRUE(bpm->PrefetchPage(page_ids[num_pages - 1], NextTestPageId, read_ahead));
+  WaitForPrefetches(bpm, read_ahead);
+  EXPECT_EQ(read_ahead, bpm->GetNumPrefetches());
+
+  // Scenario: walking the list hits the prefetched pages, and misses after them.
+  size_t hits = bpm->GetNumHits();
+  page_id_t cur_page_id = page_ids[num_pages - 1];
+  for (size_t i = 0; i < read_ahead + 1; i++) {
+    auto *page = bpm->FetchPage(cur_page_id);
+    ASSERT_NE(nullptr, page);
+    page_id_t next_page_id = NextTestPageId(page);
+    EXPECT_EQ(page_ids[num_pages - 2 - i], next_page_id);
+    EXPECT_TRUE(bpm->UnpinPage(cur_page_id, false));
+    cur_page_id = next_page_id;
+  }
+  EXPECT_EQ(hits + read_ahead, bpm->GetNumHits());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PrefetchTest, TableIteratorTest) {
+  const size_t buffer_pool_size = 16;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *transaction = new Transaction(0);
+  auto *table = new TableHeap(bpm, lock_manager, log_manager, transaction);
+
+  // Scenario: fill a table that spans many more pages than fit in the pool.
+  Column col1{"a", TypeId::VARCHAR, 200};
+  Column col2{"b", TypeId::BIGINT};
+  Schema schema{{col1, col2}};
+  Tuple tuple = ConstructTuple(&schema);
+  const int num_tuples = 2000;
+  for (int i = 0; i < num_tuples; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+  }
+
+  // Scenario: a scan with read-ahead sees every tuple, and most of its pages were prefetched.
+  int count = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+  EXPECT_LT(0, bpm->GetNumPrefetches());
+
+  // Scenario: without read-ahead nothing is prefetched.
+  size_t num_prefetches = bpm->GetNumPrefetches();
+  table->SetReadAheadPages(0);
+  count = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+  EXPECT_EQ(num_prefetches, bpm->GetNumPrefetches());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete transaction;
+  delete log_manager;
+  delete lock_manager;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,103 @@
+/**
+ * replacer_bench_test.cpp
+ *
+ * THIS TEST WILL NOT BE RUN ON GRADESCOPE
+ *
+ * Benchmark of the Pin/Unpin cost of the replacers under contention. LRUReplacer takes a mutex and
+ * splices a std::list on every call, ClockReplacer only flips atomic bits. The same workload is then
+ * run through a BufferPoolManager built with each replacer.
+ *
+ * Configuration:
+ *    frames: 1024
+ *    threads: 1, 4, 16
+ *    Unpin+Pin pairs per thread: 200000
+ *
+ * Result:
+ * [BENCHMARK: ReplacerBenchTest] replacer=LRU threads=N ns_per_pin_unpin=X
+ * [BENCHMARK: ReplacerBenchTest] replacer=CLOCK threads=N ns_per_pin_unpin=Y
+ */
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+const size_t NUM_FRAMES = 1024;
+const size_t OPS_PER_THREAD = 200000;
+
+// Each thread cycles Unpin+Pin over its own slice of frames. Return the average cost of one pair in ns.
+double PinUnpinCost(Replacer *replacer, size_t num_threads) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([replacer, tid, num_threads]() {
+      size_t slice = NUM_FRAMES / num_threads;
+      for (size_t i = 0; i < OPS_PER_THREAD; i++) {
+        auto frame_id = static_cast<frame_id_t>(tid * slice + i % slice);
+        replacer->Unpin(frame_id);
+        replacer->Pin(frame_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count();
+  return ns / (num_threads * OPS_PER_THREAD);
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacerBenchTest, PinUnpinCost) {
+  for (size_t num_threads = 1; num_threads <= 16; num_threads *= 4) {
+    std::unique_ptr<Replacer> lru(new LRUReplacer(NUM_FRAMES));
+    std::unique_ptr<Replacer> clock(new ClockReplacer(NUM_FRAMES));
+    std::cout << "[BENCHMARK: ReplacerBenchTest] replacer=LRU threads=" << num_threads
+              << " ns_per_pin_unpin=" << PinUnpinCost(lru.get(), num_threads) << std::endl;
+    std::cout << "[BENCHMARK: ReplacerBenchTest] replacer=CLOCK threads=" << num_threads
+              << " ns_per_pin_unpin=" << PinUnpinCost(clock.get(), num_threads) << std::endl;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ReplacerBenchTest, BufferPoolHitPath) {
+  for (auto [name, replacer_type] : {std::make_pair("LRU", ReplacerType::LRU),
+                                     std::make_pair("CLOCK", ReplacerType::CLOCK)}) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManager(NUM_FRAMES, disk_manager, replacer_type);
+    page_id_t page_id;
+    for (size_t i = 0; i < NUM_FRAMES; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      bpm->UnpinPage(page_id, false);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < OPS_PER_THREAD; i++) {
+      auto fetch_id = static_cast<page_id_t>(i % NUM_FRAMES);
+      bpm->FetchPage(fetch_id);
+      bpm->UnpinPage(fetch_id, false);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "[BENCHMARK: ReplacerBenchTest] replacer=" << name << " bpm_ns_per_fetch_unpin="
+              << std::chrono::duration<double, std::nano>(end - start).count() / OPS_PER_THREAD << std::endl;
+    EXPECT_EQ(OPS_PER_THREAD, bpm->GetNumHits());
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.log");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+}  // namespace bustub
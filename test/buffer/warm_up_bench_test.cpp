@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// warm_up_bench_test.cpp
+//
+// Identification: test/buffer/warm_up_bench_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Benchmark of a restart, with and without warming up the buffer pool from the pages saved at shutdown.
+ *
+ * Workload:
+ *    database: 2000 pages, buffer pool: 200 frames
+ *    90% of the fetches go to a hot set of 180 random pages, the others to any page
+ *    the first run measures the steady state hit ratio (average of its last 20 windows of 100 fetches) and saves the
+ *    resident pages, then the buffer pool is recreated and the file is dropped from the OS page cache before each
+ *    restart. A restart has reached the steady state once a window hits at least 95% as often as the first run.
+ *
+ * Result:
+ * [BENCHMARK: WarmUpBenchTest] steady_hit_ratio=R
+ * [BENCHMARK: WarmUpBenchTest] warm_up=0 first_window_hit_ratio=A fetches_to_steady=N ms_to_steady=X warm_up_reads=0
+ * [BENCHMARK: WarmUpBenchTest] warm_up=1 first_window_hit_ratio=B fetches_to_steady=M ms_to_steady=Y warm_up_reads=K
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+const size_t POOL_SIZE = 200;
+const int NUM_PAGES = 2000;
+const int NUM_HOT_PAGES = 180;
+const int WINDOW = 100;
+const int MAX_WINDOWS = 200;
+const char *const WARM_UP_FILE = "test.warm_up";
+
+static void DropFromPageCache(const char *file_name) {
+  int fd = open(file_name, O_RDONLY);
+  ASSERT_NE(-1, fd);
+  fsync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+/** Skewed fetches, the same sequence for every run. */
+class Workload {
+ public:
+  explicit Workload(const std::vector<page_id_t> &hot_pages) : hot_pages_(hot_pages) {}
+
+  page_id_t Next() {
+    if (percent_(rng_) < 90) {
+      return hot_pages_[hot_(rng_)];
+    }
+    return any_(rng_);
+  }
+
+ private:
+  const std::vector<page_id_t> &hot_pages_;
+  std::mt19937 rng_{15445};
+  std::uniform_int_distribution<int> percent_{0, 99};
+  std::uniform_int_distribution<size_t> hot_{0, NUM_HOT_PAGES - 1};
+  std::uniform_int_distribution<page_id_t> any_{0, NUM_PAGES - 1};
+};
+
+/** @return the hit ratio of the next window of fetches */
+static double RunWindow(BufferPoolManager *bpm, Workload *workload) {
+  size_t hits = bpm->GetNumHits();
+  for (int i = 0; i < WINDOW; i++) {
+    page_id_t page_id = workload->Next();
+    auto *page = bpm->FetchPage(page_id);
+    EXPECT_NE(nullptr, page);
+    EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+    bpm->UnpinPage(page_id, false);
+  }
+  return static_cast<double>(bpm->GetNumHits() - hits) / WINDOW;
+}
+
+struct RestartResult {
+  double first_window_hit_ratio_;
+  int fetches_to_steady_;
+};
+
+static RestartResult Restart(DiskManager *disk_manager, const std::vector<page_id_t> &hot_pages, double steady,
+                             bool warm_up) {
+  DropFromPageCache("test.db");
+  auto *bpm = new BufferPoolManager(POOL_SIZE, disk_manager);
+  Workload workload(hot_pages);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  if (warm_up) {
+    EXPECT_TRUE(bpm->WarmUp(WARM_UP_FILE));
+  }
+  RestartResult result{0, MAX_WINDOWS * WINDOW};
+  for (int window = 0; window < MAX_WINDOWS; window++) {
+    double hit_ratio = RunWindow(bpm, &workload);
+    if (window == 0) {
+      result.first_window_hit_ratio_ = hit_ratio;
+    }
+    if (hit_ratio >= 0.95 * steady) {
+      result.fetches_to_steady_ = (window + 1) * WINDOW;
+      break;
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  bpm->WaitForWarmUp();
+
+  std::cout << "[BENCHMARK: WarmUpBenchTest] warm_up=" << warm_up
+            << " first_window_hit_ratio=" << result.first_window_hit_ratio_
+            << " fetches_to_steady=" << result.fetches_to_steady_
+            << " ms_to_steady=" << std::chrono::duration<double, std::milli>(end - start).count()
+            << " warm_up_reads=" << bpm->GetNumWarmUpReads() << std::endl;
+  delete bpm;
+  return result;
+}
+
+// NOLINTNEXTLINE
+TEST(WarmUpBenchTest, RestartTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  std::vector<page_id_t> hot_pages(NUM_PAGES);
+  for (page_id_t i = 0; i < NUM_PAGES; i++) {
+    hot_pages[i] = i;
+  }
+  std::shuffle(hot_pages.begin(), hot_pages.end(), std::mt19937(15721));
+  hot_pages.resize(NUM_HOT_PAGES);
+
+  // Every page starts with its own page id
+  double steady = 0;
+  {
+    auto *bpm = new BufferPoolManager(POOL_SIZE, disk_manager);
+    page_id_t page_id;
+    for (int i = 0; i < NUM_PAGES; i++) {
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      *reinterpret_cast<page_id_t *>(page->GetData()) = page_id;
+      bpm->UnpinPage(page_id, true);
+    }
+    bpm->FlushAllPages();
+    Workload workload(hot_pages);
+    for (int window = 0; window < MAX_WINDOWS; window++) {
+      double hit_ratio = RunWindow(bpm, &workload);
+      if (window >= MAX_WINDOWS - 20) {
+        steady += hit_ratio / 20;
+      }
+    }
+    ASSERT_TRUE(bpm->SaveResidentPages(WARM_UP_FILE));
+    delete bpm;
+  }
+  std::cout << "[BENCHMARK: WarmUpBenchTest] steady_hit_ratio=" << steady << std::endl;
+
+  RestartResult cold = Restart(disk_manager, hot_pages, steady, false);
+  RestartResult warm = Restart(disk_manager, hot_pages, steady, true);
+  EXPECT_LE(warm.fetches_to_steady_, cold.fetches_to_steady_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(WARM_UP_FILE);
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,205 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// warm_up_test.cpp
+//
+// Identification: test/buffer/warm_up_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+const char *const WARM_UP_FILE = "test.warm_up";
+
+static void CreatePages(BufferPoolManager *bpm, int num_pages) {
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  bpm->FlushAllPages();
+}
+
+static void FetchAndCheck(BufferPoolManager *bpm, page_id_t page_id) {
+  auto *page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+  bpm->UnpinPage(page_id, false);
+}
+
+static std::vector<page_id_t> ReadWarmUpFile() {
+  std::vector<page_id_t> page_ids;
+  std::ifstream in(WARM_UP_FILE);
+  page_id_t page_id;
+  while (in >> page_id) {
+    page_ids.push_back(page_id);
+  }
+  return page_ids;
+}
+
+// NOLINTNEXTLINE
+TEST(WarmUpTest, SaveAndWarmUpTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  CreatePages(bpm, 30);
+
+  // Pages 12..21 are resident, 21 is the most recently used and 15 is pinned
+  for (page_id_t page_id = 12; page_id < 22; page_id++) {
+    FetchAndCheck(bpm, page_id);
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(15));
+  EXPECT_TRUE(bpm->SaveResidentPages(WARM_UP_FILE));
+  std::vector<page_id_t> page_ids = ReadWarmUpFile();
+  ASSERT_EQ(buffer_pool_size, page_ids.size());
+  EXPECT_EQ(15, page_ids[0]);
+  EXPECT_EQ(21, page_ids[1]);
+  EXPECT_EQ(12, page_ids.back());
+  std::set<page_id_t> resident(page_ids.begin(), page_ids.end());
+  EXPECT_EQ(buffer_pool_size, resident.size());
+  EXPECT_EQ(12, *resident.begin());
+  EXPECT_EQ(21, *resident.rbegin());
+  bpm->UnpinPage(15, false);
+  delete bpm;
+
+  // After a restart the warm-up reads the saved pages back, and fetching them costs no read
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  EXPECT_FALSE(bpm->WarmUp("missing.warm_up"));
+  EXPECT_TRUE(bpm->WarmUp(WARM_UP_FILE));
+  bpm->WaitForWarmUp();
+  EXPECT_EQ(buffer_pool_size, bpm->GetNumWarmUpReads());
+  for (page_id_t page_id = 12; page_id < 22; page_id++) {
+    FetchAndCheck(bpm, page_id);
+  }
+  EXPECT_EQ(0, bpm->GetNumMisses());
+  EXPECT_EQ(buffer_pool_size, bpm->GetNumHits());
+  delete bpm;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(WARM_UP_FILE);
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(WarmUpTest, NoEvictionTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  CreatePages(bpm, 30);
+  for (page_id_t page_id = 0; page_id < 10; page_id++) {
+    FetchAndCheck(bpm, page_id);
+  }
+  EXPECT_TRUE(bpm->SaveResidentPages(WARM_UP_FILE));
+  delete bpm;
+
+  // Pages fetched before the warm-up starts are neither read again nor evicted by it. The 4 frames left are filled
+  // with the lowest saved page ids, page 4 does not fit.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (page_id_t page_id = 5; page_id < 11; page_id++) {
+    FetchAndCheck(bpm, page_id);
+  }
+  EXPECT_TRUE(bpm->WarmUp(WARM_UP_FILE));
+  EXPECT_FALSE(bpm->WarmUp(WARM_UP_FILE));
+  bpm->WaitForWarmUp();
+  EXPECT_EQ(4, bpm->GetNumWarmUpReads());
+  size_t misses = bpm->GetNumMisses();
+  for (page_id_t page_id = 0; page_id < 11; page_id++) {
+    if (page_id != 4) {
+      FetchAndCheck(bpm, page_id);
+    }
+  }
+  EXPECT_EQ(misses, bpm->GetNumMisses());
+  delete bpm;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(WARM_UP_FILE);
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(WarmUpTest, DeletedPageTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  CreatePages(bpm, 20);
+  for (page_id_t page_id = 0; page_id < 10; page_id++) {
+    FetchAndCheck(bpm, page_id);
+  }
+  EXPECT_TRUE(bpm->SaveResidentPages(WARM_UP_FILE));
+  delete bpm;
+
+  // A saved page deleted since is not read in, so that the new page that reuses its id is the one in the page table
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  EXPECT_TRUE(bpm->DeletePage(3));
+  EXPECT_TRUE(bpm->WarmUp(WARM_UP_FILE));
+  bpm->WaitForWarmUp();
+  EXPECT_EQ(buffer_pool_size - 1, bpm->GetNumWarmUpReads());
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(3, page_id);
+  snprintf(page->GetData(), PAGE_SIZE, "page 3");
+  bpm->UnpinPage(page_id, true);
+  for (page_id = 0; page_id < 10; page_id++) {
+    FetchAndCheck(bpm, page_id);
+  }
+  delete bpm;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(WARM_UP_FILE);
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(WarmUpTest, ParallelBufferPoolTest) {
+  const size_t num_instances = 3;
+  const size_t pool_size = 4;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+  CreatePages(bpm, 24);
+  for (page_id_t page_id = 6; page_id < 18; page_id++) {
+    FetchAndCheck(bpm, page_id);
+  }
+  EXPECT_TRUE(bpm->SaveResidentPages(WARM_UP_FILE));
+  std::vector<page_id_t> page_ids = ReadWarmUpFile();
+  ASSERT_EQ(num_instances * pool_size, page_ids.size());
+  // The hottest page of every shard comes first
+  EXPECT_EQ((std::set<page_id_t>{15, 16, 17}), std::set<page_id_t>(page_ids.begin(), page_ids.begin() + 3));
+  delete bpm;
+
+  bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+  EXPECT_TRUE(bpm->WarmUp(WARM_UP_FILE));
+  bpm->WaitForWarmUp();
+  EXPECT_EQ(num_instances * pool_size, bpm->GetNumWarmUpReads());
+  for (page_id_t page_id = 6; page_id < 18; page_id++) {
+    FetchAndCheck(bpm, page_id);
+  }
+  EXPECT_EQ(0, bpm->GetNumMisses());
+  delete bpm;
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove(WARM_UP_FILE);
+  delete disk_manager;
+}
+
+}  // namespace bustub
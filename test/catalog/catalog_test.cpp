@@ -10,13 +10,17 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstdio>
+#include <stdexcept>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
+#include "concurrency/transaction.h"
 #include "gtest/gtest.h"
+#include "logging/common.h"
 #include "type/value_factory.h"
 
 namespace bustub {
@@ -48,4 +52,202 @@ TEST(CatalogTest, DISABLED_CreateTableTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(CatalogTest, DropTableTest) {
+  auto *disk_manager = new DiskManager("catalog_test.db");
+  auto *bpm = new BufferPoolManager(32, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *catalog = new Catalog(bpm, lock_manager, nullptr);
+  Transaction txn(0);
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::BIGINT};
+  Schema schema{{col1, col2}};
+
+  auto *potato = catalog->CreateTable(&txn, "potato", schema);
+  auto *tomato = catalog->CreateTable(&txn, "tomato", schema);
+  EXPECT_EQ(potato, catalog->GetTable("potato"));
+  EXPECT_EQ(tomato, catalog->GetTable(tomato->oid_));
+  // Every table is in a data file of its own
+  file_id_t potato_file = DiskManager::GetFileId(potato->table_->GetFirstPageId());
+  file_id_t tomato_file = DiskManager::GetFileId(tomato->table_->GetFirstPageId());
+  EXPECT_NE(0, potato_file);
+  EXPECT_NE(potato_file, tomato_file);
+  for (int i = 0; i < 1000; i++) {
+    RID rid;
+    EXPECT_TRUE(potato->table_->InsertTuple(ConstructTuple(&schema), &rid, &txn));
+    EXPECT_EQ(potato_file, DiskManager::GetFileId(rid.GetPageId()));
+    EXPECT_TRUE(tomato->table_->InsertTuple(ConstructTuple(&schema), &rid, &txn));
+  }
+  bpm->FlushAllPages();
+  EXPECT_LT(1, disk_manager->GetNumPages(potato_file));
+  EXPECT_EQ(0, disk_manager->GetNumPages());
+
+  // Truncating a table empties its file, the table is usable again
+  EXPECT_TRUE(catalog->TruncateTable(&txn, "tomato"));
+  EXPECT_EQ(tomato, catalog->GetTable("tomato"));
+  EXPECT_TRUE(tomato->table_->Begin(&txn) == tomato->table_->End());
+  bpm->FlushAllPages();
+  EXPECT_EQ(1, disk_manager->GetNumPages(tomato_file));
+  RID rid;
+  EXPECT_TRUE(tomato->table_->InsertTuple(ConstructTuple(&schema), &rid, &txn));
+  EXPECT_EQ(tomato_file, DiskManager::GetFileId(rid.GetPageId()));
+
+  // A table cannot be dropped while one of its pages is pinned, then its file is unlinked
+  page_id_t first_page_id = potato->table_->GetFirstPageId();
+  EXPECT_NE(nullptr, bpm->FetchPage(first_page_id));
+  EXPECT_FALSE(catalog->DropTable("potato"));
+  bpm->UnpinPage(first_page_id, false);
+  EXPECT_TRUE(catalog->DropTable("potato"));
+  EXPECT_THROW(catalog->GetTable("potato"), std::out_of_range);
+  EXPECT_FALSE(disk_manager->HasDataFile(potato_file));
+  EXPECT_EQ(tomato, catalog->GetTable("tomato"));
+
+  delete catalog;
+  delete lock_manager;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  for (const char *file_name : {"catalog_test.db", "catalog_test.log", "catalog_test.fsm", "catalog_test.files",
+                                "catalog_test.1.db", "catalog_test.1.fsm", "catalog_test.2.db", "catalog_test.2.fsm"}) {
+    remove(file_name);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, CreateIndexTest) {
+  auto *disk_manager = new DiskManager("catalog_test.db");
+  auto *bpm = new BufferPoolManager(32, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  auto *lock_manager = new LockManager();
+  auto *catalog = new Catalog(bpm, lock_manager, nullptr);
+  Transaction txn(0);
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::BIGINT};
+  Schema schema{{col1, col2}};
+  Schema key_schema{{col2}};
+
+  // The keys of an existing table are not sorted, and some of them are duplicates
+  auto *potato = catalog->CreateTable(&txn, "potato", schema);
+  std::vector<RID> rids;
+  for (int64_t i = 0; i < 3000; i++) {
+    RID rid;
+    Tuple tuple({ValueFactory::GetVarcharValue("potato"), ValueFactory::GetBigIntValue((i * 7) % 2000)}, &schema);
+    EXPECT_TRUE(potato->table_->InsertTuple(tuple, &rid, &txn));
+    rids.push_back(rid);
+  }
+  IndexInfo *index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(&txn, "potato_b", "potato",
+                                                                                        schema, key_schema, {1}, 8);
+  EXPECT_EQ(index_info, catalog->GetIndex("potato_b", "potato"));
+  EXPECT_EQ(index_info, catalog->GetIndex(index_info->index_oid_));
+  EXPECT_EQ(std::vector<IndexInfo *>{index_info}, catalog->GetTableIndexes("potato"));
+  EXPECT_TRUE(catalog->GetTableIndexes("tomato").empty());
+  EXPECT_THROW(catalog->GetIndex("potato_a", "potato"), std::out_of_range);
+
+  // Every key is found, with the RID of the first tuple that has it
+  for (int64_t key = 0; key < 2000; key++) {
+    std::vector<RID> result;
+    Tuple key_tuple({ValueFactory::GetBigIntValue(key)}, &key_schema);
+    index_info->index_->ScanKey(key_tuple, &result, &txn);
+    ASSERT_EQ(1, result.size());
+    // (i * 7) % 2000 == key for i = key * 7^-1 mod 2000, 7 * 1143 = 8001
+    EXPECT_EQ(rids[(key * 1143) % 2000], result[0]);
+  }
+  std::vector<RID> result;
+  Tuple key_tuple({ValueFactory::GetBigIntValue(2000)}, &key_schema);
+  index_info->index_->ScanKey(key_tuple, &result, &txn);
+  EXPECT_TRUE(result.empty());
+
+  bpm->UnpinPage(header_page_id, true);
+  delete catalog;
+  delete lock_manager;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  for (const char *file_name : {"catalog_test.db", "catalog_test.log", "catalog_test.fsm", "catalog_test.files",
+                                "catalog_test.1.db", "catalog_test.1.fsm", "catalog_test.2.db", "catalog_test.2.fsm"}) {
+    remove(file_name);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, CreateIndexKeyTypeTest) {
+  auto *disk_manager = new DiskManager("catalog_test.db");
+  auto *bpm = new BufferPoolManager(32, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  auto *lock_manager = new LockManager();
+  auto *catalog = new Catalog(bpm, lock_manager, nullptr);
+  Transaction txn(0);
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::BIGINT};
+  Column col3{"c", TypeId::INTEGER};
+  Schema schema{{col1, col2, col3}};
+  Schema b_schema{{col2}};
+  Schema c_schema{{col3}};
+  Schema cb_schema{{col3, col2}};
+
+  // Negative keys too, a plain integer comparison has to order them before the positive ones
+  auto *potato = catalog->CreateTable(&txn, "potato", schema);
+  std::vector<RID> rids;
+  for (int32_t i = 0; i < 1000; i++) {
+    RID rid;
+    Tuple tuple({ValueFactory::GetVarcharValue("potato"), ValueFactory::GetBigIntValue((i - 500) * 10000000000L),
+                 ValueFactory::GetIntegerValue(500 - i)},
+                &schema);
+    EXPECT_TRUE(potato->table_->InsertTuple(tuple, &rid, &txn));
+    rids.push_back(rid);
+  }
+
+  // A single INTEGER or BIGINT column gets an integer key, other keys a generic one
+  IndexInfo *b_index = catalog->CreateIndex(&txn, "potato_b", "potato", schema, b_schema, {1}, 8);
+  IndexInfo *c_index = catalog->CreateIndex(&txn, "potato_c", "potato", schema, c_schema, {2}, 4);
+  IndexInfo *cb_index = catalog->CreateIndex(&txn, "potato_cb", "potato", schema, cb_schema, {2, 1}, 12);
+  auto *b_tree = dynamic_cast<BPlusTreeIndex<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> *>(
+      b_index->index_.get());
+  auto *c_tree = dynamic_cast<BPlusTreeIndex<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>> *>(
+      c_index->index_.get());
+  ASSERT_NE(nullptr, b_tree);
+  ASSERT_NE(nullptr, c_tree);
+  EXPECT_NE(nullptr,
+            (dynamic_cast<BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>> *>(cb_index->index_.get())));
+
+  for (int32_t i = 0; i < 1000; i++) {
+    std::vector<RID> result;
+    b_index->index_->ScanKey(Tuple({ValueFactory::GetBigIntValue((i - 500) * 10000000000L)}, &b_schema), &result,
+                             &txn);
+    c_index->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(500 - i)}, &c_schema), &result, &txn);
+    cb_index->index_->ScanKey(
+        Tuple({ValueFactory::GetIntegerValue(500 - i), ValueFactory::GetBigIntValue((i - 500) * 10000000000L)},
+              &cb_schema),
+        &result, &txn);
+    EXPECT_EQ(std::vector<RID>(3, rids[i]), result);
+  }
+
+  // The trees are in key order: b ascends with the tuples, c descends
+  int32_t i = 0;
+  for (auto iter = b_tree->GetBeginIterator(); iter != b_tree->GetEndIterator(); ++iter, i++) {
+    EXPECT_EQ(rids[i], (*iter).second);
+  }
+  EXPECT_EQ(1000, i);
+  for (auto iter = c_tree->GetBeginIterator(); iter != c_tree->GetEndIterator(); ++iter) {
+    i--;
+    EXPECT_EQ(rids[i], (*iter).second);
+  }
+  EXPECT_EQ(0, i);
+
+  bpm->UnpinPage(header_page_id, true);
+  delete catalog;
+  delete lock_manager;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  for (const char *file_name :
+       {"catalog_test.db", "catalog_test.log", "catalog_test.fsm", "catalog_test.files", "catalog_test.1.db",
+        "catalog_test.1.fsm", "catalog_test.2.db", "catalog_test.2.fsm", "catalog_test.3.db", "catalog_test.3.fsm",
+        "catalog_test.4.db", "catalog_test.4.fsm"}) {
+    remove(file_name);
+  }
+}
+
 }  // namespace bustub
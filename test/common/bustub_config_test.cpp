@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bustub_config_test.cpp
+//
+// Identification: test/common/bustub_config_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include "common/bustub_config.h"
+#include "common/bustub_instance.h"
+#include "common/exception.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BustubConfigTest, SetTest) {
+  BustubConfig config;
+  EXPECT_EQ(BUFFER_POOL_SIZE, config.buffer_pool_size_);
+  EXPECT_EQ(LOG_BUFFER_SIZE, config.GetLogBufferSize());
+  EXPECT_EQ(ReplacerType::LRU, config.replacer_type_);
+  EXPECT_FALSE(config.background_writer_);
+
+  config.Set("buffer_pool_size", "1000000");
+  config.Set("buffer_pool_instances", "4");
+  config.Set("replacer", "clock");
+  config.Set("background_writer", "on");
+  config.Set("background_writer_interval_ms", "50");
+  config.Set("direct_io", "on");
+  config.Set("sync_policy", "group");
+  EXPECT_EQ(1000000, config.buffer_pool_size_);
+  EXPECT_EQ(4, config.buffer_pool_instances_);
+  EXPECT_EQ(static_cast<size_t>(4000001) * PAGE_SIZE, config.GetLogBufferSize());
+  EXPECT_EQ(ReplacerType::CLOCK, config.replacer_type_);
+  EXPECT_TRUE(config.background_writer_);
+  EXPECT_EQ(std::chrono::milliseconds(50), config.background_writer_options_.interval_);
+  EXPECT_TRUE(config.direct_io_);
+  EXPECT_EQ(SyncPolicy::GROUP, config.sync_policy_);
+  config.Set("log_buffer_size", "65536");
+  EXPECT_EQ(65536, config.GetLogBufferSize());
+
+  EXPECT_THROW(config.Set("buffer_pool_size", "ten"), Exception);
+  EXPECT_THROW(config.Set("buffer_pool_size", "-1"), Exception);
+  EXPECT_THROW(config.Set("buffer_pool_size", "0"), Exception);
+  EXPECT_THROW(config.Set("replacer", "mru"), Exception);
+  EXPECT_THROW(config.Set("direct_io", "yes"), Exception);
+  EXPECT_THROW(config.Set("sync_policy", "never"), Exception);
+  EXPECT_THROW(config.Set("pool_size", "10"), Exception);
+}
+
+// NOLINTNEXTLINE
+TEST(BustubConfigTest, FileAndEnvironmentTest) {
+  {
+    std::ofstream file("test.conf");
+    file << "# engine settings\n"
+         << "buffer_pool_size = 64\n"
+         << "\n"
+         << "replacer = lru_k  # scan resistant\n"
+         << "replacer_k=3\n";
+  }
+  BustubConfig config = BustubConfig::FromFile("test.conf");
+  EXPECT_EQ(64, config.buffer_pool_size_);
+  EXPECT_EQ(ReplacerType::LRU_K, config.replacer_type_);
+  EXPECT_EQ(3, config.replacer_k_);
+  remove("test.conf");
+  EXPECT_THROW(BustubConfig::FromFile("test.conf"), Exception);
+
+  // Environment variables override the settings of the file
+  setenv("BUSTUB_BUFFER_POOL_SIZE", "128", 1);
+  setenv("BUSTUB_BACKGROUND_WRITER", "on", 1);
+  config = BustubConfig::FromEnvironment(config);
+  unsetenv("BUSTUB_BUFFER_POOL_SIZE");
+  unsetenv("BUSTUB_BACKGROUND_WRITER");
+  EXPECT_EQ(128, config.buffer_pool_size_);
+  EXPECT_EQ(ReplacerType::LRU_K, config.replacer_type_);
+  EXPECT_TRUE(config.background_writer_);
+}
+
+// NOLINTNEXTLINE
+TEST(BustubConfigTest, BustubInstanceTest) {
+  BustubConfig config;
+  config.buffer_pool_size_ = 32;
+  config.buffer_pool_instances_ = 2;
+  config.replacer_type_ = ReplacerType::CLOCK;
+  config.background_writer_ = true;
+  auto *bustub_instance = new BustubInstance("test.db", config);
+  EXPECT_EQ(64, bustub_instance->buffer_pool_manager_->GetPoolSize());
+  EXPECT_EQ(config.GetLogBufferSize(), bustub_instance->log_manager_->GetLogBufferSize());
+
+  // Every frame of the pool can be used
+  page_id_t page_id;
+  for (int i = 0; i < 64; i++) {
+    EXPECT_NE(nullptr, bustub_instance->buffer_pool_manager_->NewPage(&page_id));
+  }
+  EXPECT_EQ(nullptr, bustub_instance->buffer_pool_manager_->NewPage(&page_id));
+
+  delete bustub_instance;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io_bench_test.cpp
+//
+// Identification: test/storage/async_io_bench_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Benchmark of the queue depth scaling of random page reads through an AsyncIOContext, for both backends.
+ *
+ * Workload:
+ *    database: 16384 pages (64 MB), dropped from the OS page cache before each run
+ *    one thread reads 4000 random pages, keeping up to queue_depth reads in flight; queue depth 1 is the synchronous
+ *    baseline
+ *
+ * Result:
+ * [BENCHMARK: AsyncIOBenchTest] backend=io_uring queue_depth=Q reads_per_sec=X
+ * [BENCHMARK: AsyncIOBenchTest] backend=thread_pool queue_depth=Q reads_per_sec=Y
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/async_io.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+const page_id_t NUM_PAGES = 16384;
+const int NUM_READS = 4000;
+
+static void DropFromPageCache(const char *file_name) {
+  int fd = open(file_name, O_RDONLY);
+  ASSERT_NE(-1, fd);
+  fsync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+static void RandomReads(DiskManager *disk_manager, AsyncIOBackend backend, size_t queue_depth) {
+  DropFromPageCache("test.db");
+  std::unique_ptr<AsyncIOContext> io = disk_manager->NewAsyncIOContext(queue_depth, backend);
+  std::vector<char> buffers(queue_depth * PAGE_SIZE);
+  std::vector<page_id_t> page_ids(queue_depth);
+  std::vector<size_t> free_slots;
+  for (size_t slot = 0; slot < queue_depth; slot++) {
+    free_slots.push_back(slot);
+  }
+  std::vector<AsyncIOCompletion> completions;
+  auto check = [&](size_t min_completions) {
+    completions.clear();
+    io->Complete(&completions, min_completions);
+    for (const auto &completion : completions) {
+      page_id_t stored;
+      memcpy(&stored, &buffers[completion.tag_ * PAGE_SIZE], sizeof(stored));
+      EXPECT_EQ(page_ids[completion.tag_], stored);
+      free_slots.push_back(completion.tag_);
+    }
+  };
+
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<page_id_t> page_dist(0, NUM_PAGES - 1);
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < NUM_READS; i++) {
+    if (free_slots.empty()) {
+      check(1);
+    }
+    size_t slot = free_slots.back();
+    free_slots.pop_back();
+    page_ids[slot] = page_dist(rng);
+    io->SubmitRead(page_ids[slot], 1, &buffers[slot * PAGE_SIZE], slot);
+    check(0);
+  }
+  while (io->GetNumPending() > 0) {
+    check(1);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << "[BENCHMARK: AsyncIOBenchTest] backend="
+            << (io->GetBackend() == AsyncIOBackend::IO_URING ? "io_uring" : "thread_pool")
+            << " queue_depth=" << queue_depth << " reads_per_sec=" << static_cast<uint64_t>(NUM_READS / seconds)
+            << std::endl;
+}
+
+// NOLINTNEXTLINE
+TEST(AsyncIOBenchTest, QueueDepthScalingTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  {
+    // Every page starts with its own page id
+    std::unique_ptr<AsyncIOContext> io = disk_manager->NewAsyncIOContext(1, AsyncIOBackend::THREAD_POOL);
+    std::vector<char> data(256 * PAGE_SIZE);
+    std::vector<AsyncIOCompletion> completions;
+    for (page_id_t first = 0; first < NUM_PAGES; first += 256) {
+      for (page_id_t i = 0; i < 256; i++) {
+        page_id_t page_id = first + i;
+        memcpy(&data[i * PAGE_SIZE], &page_id, sizeof(page_id));
+      }
+      io->SubmitWrite(first, 256, data.data(), 0);
+      io->Complete(&completions);
+    }
+  }
+
+  for (AsyncIOBackend backend : {AsyncIOBackend::IO_URING, AsyncIOBackend::THREAD_POOL}) {
+    for (size_t queue_depth : {1, 2, 4, 8, 16, 32}) {
+      RandomReads(disk_manager, backend, queue_depth);
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io_test.cpp
+//
+// Identification: test/storage/async_io_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/async_io.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+class AsyncIOTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.fsm");
+    remove("test.files");
+  }
+
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+    remove("test.fsm");
+    remove("test.files");
+  }
+};
+
+static void FillPage(char *data, page_id_t page_id) {
+  memset(data, 0, PAGE_SIZE);
+  snprintf(data, PAGE_SIZE, "page %d", page_id);
+  data[PAGE_SIZE - 1] = static_cast<char>(page_id);
+}
+
+static void CheckReadWrite(AsyncIOBackend backend) {
+  const size_t num_pages = 64;
+  const size_t queue_depth = 8;
+  DiskManager disk_manager("test.db");
+  std::unique_ptr<AsyncIOContext> io = disk_manager.NewAsyncIOContext(queue_depth, backend);
+  // io_uring falls back to the thread pool on kernels without it
+  if (backend == AsyncIOBackend::THREAD_POOL) {
+    EXPECT_EQ(AsyncIOBackend::THREAD_POOL, io->GetBackend());
+  }
+  EXPECT_EQ(queue_depth, io->GetQueueDepth());
+
+  // More requests than the queue depth: submitting waits for a free slot, no completion is lost
+  std::vector<char> data(num_pages * PAGE_SIZE);
+  for (size_t i = 0; i < num_pages; i++) {
+    FillPage(&data[i * PAGE_SIZE], static_cast<page_id_t>(i));
+    io->SubmitWrite(static_cast<page_id_t>(i), 1, &data[i * PAGE_SIZE], i);
+    EXPECT_LE(io->GetNumPending(), num_pages);
+  }
+  std::vector<AsyncIOCompletion> completions;
+  while (io->GetNumPending() > 0) {
+    io->Complete(&completions);
+  }
+  ASSERT_EQ(num_pages, completions.size());
+  std::set<uint64_t> tags;
+  for (const auto &completion : completions) {
+    EXPECT_EQ(PAGE_SIZE, completion.result_);
+    tags.insert(completion.tag_);
+  }
+  EXPECT_EQ(num_pages, tags.size());
+  EXPECT_EQ(static_cast<int>(num_pages), disk_manager.GetNumWrites());
+
+  // The synchronous path sees the asynchronous writes
+  char page[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_pages); page_id++) {
+    disk_manager.ReadPage(page_id, page);
+    FillPage(expected, page_id);
+    EXPECT_EQ(0, memcmp(expected, page, PAGE_SIZE));
+  }
+
+  // Multi-page reads, the last one runs past the end of the file
+  std::vector<char> read(num_pages * PAGE_SIZE, 1);
+  io->SubmitRead(0, 16, &read[0], 0);
+  io->SubmitRead(16, 16, &read[16 * PAGE_SIZE], 1);
+  io->SubmitRead(56, 16, &read[32 * PAGE_SIZE], 2);
+  completions.clear();
+  EXPECT_EQ(3, io->Complete(&completions, 3));
+  EXPECT_EQ(0, io->GetNumPending());
+  for (const auto &completion : completions) {
+    EXPECT_EQ(completion.tag_ == 2 ? 8 * PAGE_SIZE : 16 * PAGE_SIZE, completion.result_);
+  }
+  EXPECT_EQ(0, memcmp(&data[0], &read[0], 32 * PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(&data[56 * PAGE_SIZE], &read[32 * PAGE_SIZE], 8 * PAGE_SIZE));
+  for (size_t i = 40 * PAGE_SIZE; i < 48 * PAGE_SIZE; i++) {
+    ASSERT_EQ(0, read[i]);
+  }
+
+  // Nothing pending: Complete returns at once
+  completions.clear();
+  EXPECT_EQ(0, io->Complete(&completions, 1));
+
+  // A data file dropped with a request in flight stays open until the request completes
+  file_id_t file_id = disk_manager.CreateDataFile();
+  page_id_t dropped_page_id = DiskManager::MakePageId(file_id, 0);
+  disk_manager.WritePage(dropped_page_id, &data[0]);
+  io->SubmitRead(dropped_page_id, 1, &read[0], 0);
+  disk_manager.DropDataFile(file_id);
+  completions.clear();
+  EXPECT_EQ(1, io->Complete(&completions, 1));
+  EXPECT_EQ(PAGE_SIZE, completions[0].result_);
+  EXPECT_EQ(0, memcmp(&data[0], &read[0], PAGE_SIZE));
+
+  // Requests still in flight are waited for by the destructor
+  io->SubmitRead(0, 1, &read[0], 0);
+  io.reset();
+  EXPECT_EQ(0, memcmp(&data[0], &read[0], PAGE_SIZE));
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(AsyncIOTest, IOUringTest) { CheckReadWrite(AsyncIOBackend::IO_URING); }
+
+// NOLINTNEXTLINE
+TEST_F(AsyncIOTest, ThreadPoolTest) { CheckReadWrite(AsyncIOBackend::THREAD_POOL); }
+
+}  // namespace bustub
@@ -0,0 +1,111 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bulk_load_bench_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bulk_load_bench_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Benchmark of building a B+ tree over existing keys: inserting them one by one, and sorting them then loading the
+ * tree bottom-up with BulkLoad.
+ *
+ * Workload:
+ *    buffer pool: 1024 frames, default leaf and internal max sizes
+ *    1000000 keys in random order (scaled down from 10M so that the test runs in seconds), every build flushed
+ *
+ * Result:
+ * [BENCHMARK: BPlusTreeBulkLoadBenchTest] method=insert keys=N build_ms=X file_pages=P
+ * [BENCHMARK: BPlusTreeBulkLoadBenchTest] method=bulk_load keys=N build_ms=Y file_pages=Q
+ */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "b_plus_tree_test_util.h"  // NOLINT
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+
+namespace bustub {
+
+const int64_t BULK_LOAD_KEYS = 1000000;
+
+/** @return the pages of the database file after building a tree over keys, with BulkLoad or with Insert */
+static int64_t Build(const std::vector<int64_t> &keys, bool bulk_load) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(1024, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  if (bulk_load) {
+    std::vector<std::pair<GenericKey<8>, RID>> entries(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      entries[i].first.SetFromInteger(keys[i]);
+      entries[i].second = RID(keys[i]);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [&comparator](const auto &left, const auto &right) { return comparator(left.first, right.first) < 0; });
+    EXPECT_TRUE(tree.BulkLoad(entries));
+  } else {
+    GenericKey<8> index_key;
+    for (int64_t key : keys) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(key));
+    }
+  }
+  bpm->FlushAllPages();
+  auto end = std::chrono::high_resolution_clock::now();
+  int64_t file_pages = disk_manager->GetNumPages();
+  std::cout << "[BENCHMARK: BPlusTreeBulkLoadBenchTest] method=" << (bulk_load ? "bulk_load" : "insert")
+            << " keys=" << keys.size()
+            << " build_ms=" << std::chrono::duration<double, std::milli>(end - start).count()
+            << " file_pages=" << file_pages << std::endl;
+
+  // Both trees hold every key, in order
+  int64_t expected = 0;
+  for (auto &pair : tree) {
+    EXPECT_EQ(expected, pair.first.ToString());
+    expected++;
+  }
+  EXPECT_EQ(static_cast<int64_t>(keys.size()), expected);
+
+  delete bpm;
+  delete disk_manager;
+  delete key_schema;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  return file_pages;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBulkLoadBenchTest, BuildTest) {
+  std::vector<int64_t> keys(BULK_LOAD_KEYS);
+  for (int64_t i = 0; i < BULK_LOAD_KEYS; i++) {
+    keys[i] = i;
+  }
+  std::mt19937 rng(15445);
+  std::shuffle(keys.begin(), keys.end(), rng);
+
+  int64_t insert_pages = Build(keys, false);
+  int64_t bulk_load_pages = Build(keys, true);
+  // Random inserts leave the pages about 70% full, the bulk load fills them to 90%
+  EXPECT_LT(bulk_load_pages, insert_pages);
+}
+
+}  // namespace bustub
@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_churn_bench_test.cpp
+//
+// Identification: test/storage/b_plus_tree_churn_bench_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Benchmark of the size of the database file under insert/delete churn in a B+ tree.
+ *
+ * Workload:
+ *    buffer pool: 64 frames, leaf and internal max size: 32
+ *    8 cycles, each inserts 20000 keys in random order then removes them all, so that coalescing deletes every page
+ *    of the tree. The pages deleted in one cycle are allocated again by the next one.
+ *
+ * Result:
+ * [BENCHMARK: BPlusTreeChurnBenchTest] cycle=C file_pages=P allocated_pages=A cycle_ms=X
+ */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "b_plus_tree_test_util.h"  // NOLINT
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeChurnBenchTest, InsertDeleteCycleTest) {
+  const int num_cycles = 8;
+  const int64_t num_keys = 20000;
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(64, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 32, 32);
+  GenericKey<8> index_key;
+  auto *transaction = new Transaction(0);
+
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+
+  std::vector<int64_t> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; i++) {
+    keys[i] = i;
+  }
+  std::mt19937 rng(15445);
+  int64_t first_file_pages = 0;
+  int64_t file_pages = 0;
+  for (int cycle = 0; cycle < num_cycles; cycle++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    std::shuffle(keys.begin(), keys.end(), rng);
+    for (int64_t key : keys) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(static_cast<int32_t>(key >> 32), static_cast<int>(key)), transaction);
+    }
+    bpm->FlushAllPages();
+    file_pages = disk_manager->GetNumPages();
+    int64_t allocated_pages = 0;
+    for (page_id_t page_id = 0; page_id < file_pages; page_id++) {
+      allocated_pages += disk_manager->IsAllocated(page_id) ? 1 : 0;
+    }
+
+    std::shuffle(keys.begin(), keys.end(), rng);
+    for (int64_t key : keys) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, transaction);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    EXPECT_TRUE(tree.IsEmpty());
+    if (cycle == 0) {
+      first_file_pages = file_pages;
+    }
+    std::cout << "[BENCHMARK: BPlusTreeChurnBenchTest] cycle=" << cycle << " file_pages=" << file_pages
+              << " allocated_pages=" << allocated_pages
+              << " cycle_ms=" << std::chrono::duration<double, std::milli>(end - start).count() << std::endl;
+  }
+  // The file stays flat: a full tree never needs much more than the pages the first cycle allocated
+  EXPECT_LE(file_pages, first_file_pages * 11 / 10);
+
+  delete transaction;
+  delete bpm;
+  delete disk_manager;
+  delete key_schema;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+}  // namespace bustub
@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_comparator_bench_test.cpp
+//
+// Identification: test/storage/b_plus_tree_comparator_bench_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Benchmark of the key comparisons of a B+ tree on a BIGINT column: GenericKey<8> compared through the key schema by
+ * GenericComparator, and IntegerKey<int64_t> compared as a plain integer by IntegerComparator.
+ *
+ * Workload:
+ *    a full leaf page (default max size) of the odd keys, searched with KeyIndex and Lookup for random keys of which
+ *    half are in the page
+ *    a binary search over size keys makes log2(size + 1) comparisons
+ *
+ * Result:
+ * [BENCHMARK: BPlusTreeComparatorBenchTest] key=generic size=N ns_per_key_index=X ns_per_lookup=Y ns_per_comparison=Z
+ * [BENCHMARK: BPlusTreeComparatorBenchTest] key=integer size=N ns_per_key_index=U ns_per_lookup=V ns_per_comparison=W
+ */
+
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "b_plus_tree_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+
+namespace bustub {
+
+const int COMPARATOR_PROBES = 1000000;
+
+/** @return the nanoseconds per key comparison of KeyIndex on a full leaf page */
+template <typename KeyType, typename KeyComparator>
+static double SearchLeaf(const char *key_name, const KeyComparator &comparator) {
+  using LeafPage = BPlusTreeLeafPage<KeyType, RID, KeyComparator>;
+  std::vector<char> data(PAGE_SIZE);
+  auto *leaf = reinterpret_cast<LeafPage *>(data.data());
+  leaf->Init(0);
+  int size = leaf->GetMaxSize() - 1;
+  KeyType key;
+  for (int64_t i = 0; i < size; i++) {
+    key.SetFromInteger(2 * i + 1);
+    leaf->Insert(key, RID(i), comparator);
+  }
+
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<int64_t> dist(0, 2 * size);
+  std::vector<KeyType> probes(COMPARATOR_PROBES);
+  for (auto &probe : probes) {
+    probe.SetFromInteger(dist(rng));
+  }
+
+  int64_t index_sum = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (const auto &probe : probes) {
+    index_sum += leaf->KeyIndex(probe, comparator);
+  }
+  auto middle = std::chrono::high_resolution_clock::now();
+  int64_t found = 0;
+  RID rid;
+  for (const auto &probe : probes) {
+    found += leaf->Lookup(probe, &rid, comparator) ? 1 : 0;
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+
+  // both key types find the same entries
+  int64_t expected_index_sum = 0;
+  int64_t expected_found = 0;
+  for (const auto &probe : probes) {
+    expected_index_sum += probe.ToString() / 2;
+    expected_found += probe.ToString() % 2 == 1 ? 1 : 0;
+  }
+  EXPECT_EQ(expected_index_sum, index_sum);
+  EXPECT_EQ(expected_found, found);
+
+  double ns_per_key_index = std::chrono::duration<double, std::nano>(middle - start).count() / COMPARATOR_PROBES;
+  double ns_per_lookup = std::chrono::duration<double, std::nano>(end - middle).count() / COMPARATOR_PROBES;
+  double ns_per_comparison = ns_per_key_index / std::log2(size + 1);
+  std::cout << "[BENCHMARK: BPlusTreeComparatorBenchTest] key=" << key_name << " size=" << size
+            << " ns_per_key_index=" << ns_per_key_index << " ns_per_lookup=" << ns_per_lookup
+            << " ns_per_comparison=" << ns_per_comparison << std::endl;
+  return ns_per_comparison;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeComparatorBenchTest, LeafSearchTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  double generic_ns = SearchLeaf<GenericKey<8>>("generic", GenericComparator<8>(key_schema));
+  double integer_ns = SearchLeaf<IntegerKey<int64_t>>("integer", IntegerComparator<int64_t>(key_schema));
+  // GenericComparator deserializes both keys into Values on every comparison, about 8x slower
+  EXPECT_LT(integer_ns, generic_ns);
+  delete key_schema;
+}
+
+}  // namespace bustub
@@ -172,4 +172,62 @@ TEST(BPlusTreeTests, DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, DeleteFreesPagesTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5);
+  GenericKey<8> index_key;
+
+  // every time the tree grows and shrinks back to empty, the pages of its roots are freed with the others
+  for (int round = 0; round < 2; round++) {
+    for (int64_t key = 0; key < 500; key++) {
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Insert(index_key, RID(0, key)));
+    }
+    for (int64_t key = 0; key < 500; key++) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+    for (page_id_t page_id = 0; page_id < 1000; page_id++) {
+      EXPECT_EQ(page_id == header_page_id, disk_manager->IsAllocated(page_id)) << page_id;
+    }
+  }
+
+  // a page that is still pinned when it is merged away is deleted by a later Remove, once it is unpinned
+  for (int round = 0; round < 2; round++) {
+    for (int64_t key = 0; key < 500; key++) {
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Insert(index_key, RID(0, key)));
+    }
+    index_key.SetFromInteger(499);
+    Page *pinned_leaf = round == 0 ? tree.FindLeafPage(index_key) : nullptr;
+    for (int64_t key = 0; key < 500; key++) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+    if (pinned_leaf != nullptr) {
+      EXPECT_TRUE(disk_manager->IsAllocated(pinned_leaf->GetPageId()));
+      bpm->UnpinPage(pinned_leaf->GetPageId(), false);
+    }
+  }
+  for (page_id_t page_id = 0; page_id < 1000; page_id++) {
+    EXPECT_EQ(page_id == header_page_id, disk_manager->IsAllocated(page_id)) << page_id;
+  }
+
+  bpm->UnpinPage(header_page_id, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
 }  // namespace bustub
@@ -144,4 +144,72 @@ TEST(BPlusTreeTests, DISABLED_InsertTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  // the odd keys, several levels of small pages
+  std::vector<std::pair<GenericKey<8>, RID>> entries;
+  for (int64_t key = 1; key < 2000; key += 2) {
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(key);
+    entries.emplace_back(index_key, RID(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF));
+  }
+  for (double fill_factor : {0.5, 0.9, 1.0}) {
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5);
+    EXPECT_TRUE(tree.BulkLoad(entries, fill_factor));
+    EXPECT_FALSE(tree.BulkLoad(entries, fill_factor));
+
+    GenericKey<8> index_key;
+    std::vector<RID> rids;
+    for (int64_t key = 0; key < 2000; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_EQ(key % 2 == 1, tree.GetValue(index_key, &rids));
+    }
+    int64_t current_key = 1;
+    for (auto &pair : tree) {
+      EXPECT_EQ(current_key, pair.second.GetSlotNum());
+      current_key += 2;
+    }
+    EXPECT_EQ(2001, current_key);
+
+    // the loaded tree splits and merges like an inserted one
+    for (int64_t key = 0; key < 2000; key += 2) {
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Insert(index_key, RID(0, key)));
+    }
+    for (int64_t key = 0; key < 1500; key++) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+    current_key = 1500;
+    for (auto &pair : tree) {
+      EXPECT_EQ(current_key, pair.second.GetSlotNum());
+      current_key++;
+    }
+    EXPECT_EQ(2000, current_key);
+  }
+
+  // a single leaf is the root
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5);
+  EXPECT_TRUE(tree.BulkLoad({entries[0]}));
+  std::vector<RID> rids;
+  EXPECT_TRUE(tree.GetValue(entries[0].first, &rids));
+  EXPECT_EQ(entries[0].second, rids[0]);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
 }  // namespace bustub
@@ -10,11 +10,19 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <unistd.h>
+
+#include <cstdio>
 #include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/lz_codec.h"
 
 namespace bustub {
 
@@ -24,12 +32,26 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.files");
+    remove("test.1.db");
+    remove("test.1.fsm");
+    remove("test.1.map");
+    remove("test.2.db");
+    remove("test.2.fsm");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.files");
+    remove("test.1.db");
+    remove("test.1.fsm");
+    remove("test.1.map");
+    remove("test.2.db");
+    remove("test.2.fsm");
   };
 };
 
@@ -55,6 +77,351 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeFileTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Pages around the 2 GB and 4 GB offsets, the file stays sparse so only these pages take disk space
+  const page_id_t pages_per_gb = (1 << 30) / PAGE_SIZE;
+  const std::vector<page_id_t> page_ids{0, 2 * pages_per_gb - 1, 2 * pages_per_gb, 4 * pages_per_gb - 1,
+                                        4 * pages_per_gb, 4 * pages_per_gb + 1};
+  for (page_id_t page_id : page_ids) {
+    std::memset(data, 0, sizeof(data));
+    snprintf(data, sizeof(data), "page %d", page_id);
+    dm.WritePage(page_id, data);
+  }
+  EXPECT_EQ(static_cast<int64_t>(4) * pages_per_gb + 2, dm.GetNumPages());
+  for (page_id_t page_id : page_ids) {
+    std::memset(data, 0, sizeof(data));
+    snprintf(data, sizeof(data), "page %d", page_id);
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0) << "page " << page_id;
+  }
+
+  // A hole reads as zeros
+  std::memset(buf, 1, sizeof(buf));
+  dm.ReadPage(3 * pages_per_gb, buf);
+  std::memset(data, 0, sizeof(data));
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePageReuseTest) {
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    for (page_id_t page_id = 0; page_id < 10; page_id++) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+      dm.WritePage(page_id, data);
+    }
+    // Freed pages are reused lowest first, before the file grows
+    dm.DeallocatePage(7);
+    dm.DeallocatePage(3);
+    dm.DeallocatePage(3);
+    EXPECT_FALSE(dm.IsAllocated(3));
+    EXPECT_EQ(3, dm.AllocatePage());
+    EXPECT_TRUE(dm.IsAllocated(3));
+    dm.DeallocatePage(5);
+    dm.ShutDown();
+  }
+  {
+    // The free pages survive a restart
+    auto dm = DiskManager(db_file);
+    EXPECT_TRUE(dm.IsAllocated(9));
+    EXPECT_FALSE(dm.IsAllocated(5));
+    EXPECT_FALSE(dm.IsAllocated(7));
+    EXPECT_EQ(5, dm.AllocatePage());
+    // A shard of a parallel buffer pool only gets its own page ids, the ids it skips stay free for the others
+    EXPECT_EQ(7, dm.AllocatePage(3, 1));
+    EXPECT_EQ(12, dm.AllocatePage(3, 0));
+    EXPECT_EQ(10, dm.AllocatePage(3, 1));
+    EXPECT_EQ(11, dm.AllocatePage());
+    EXPECT_EQ(13, dm.AllocatePage());
+    dm.ShutDown();
+  }
+  {
+    // A database file without free space map has all its pages allocated
+    remove("test.fsm");
+    auto dm = DiskManager(db_file);
+    EXPECT_TRUE(dm.IsAllocated(5));
+    EXPECT_EQ(10, dm.AllocatePage());
+    dm.ShutDown();
+  }
+  {
+    // A new database file starts from scratch, even next to a stale free space map
+    remove("test.db");
+    auto dm = DiskManager(db_file);
+    EXPECT_FALSE(dm.IsAllocated(5));
+    EXPECT_EQ(0, dm.AllocatePage());
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ExtentAllocationTest) {
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file, false, 8);
+    segment_id_t a = dm.CreateSegment();
+    segment_id_t b = dm.CreateSegment();
+    EXPECT_NE(a, b);
+    // Two segments growing at the same time each get their own extents
+    std::vector<page_id_t> pages_a;
+    std::vector<page_id_t> pages_b;
+    for (int i = 0; i < 10; i++) {
+      pages_a.push_back(dm.AllocatePage(1, 0, a));
+      pages_b.push_back(dm.AllocatePage(1, 0, b));
+    }
+    EXPECT_EQ((std::vector<page_id_t>{0, 1, 2, 3, 4, 5, 6, 7, 16, 17}), pages_a);
+    EXPECT_EQ((std::vector<page_id_t>{8, 9, 10, 11, 12, 13, 14, 15, 24, 25}), pages_b);
+    // The free pages of an extent are kept for its segment
+    EXPECT_FALSE(dm.IsAllocated(18));
+    EXPECT_EQ(32, dm.AllocatePage());
+
+    // A freed page goes back to its segment, a freed extent back to the file
+    dm.DeallocatePage(9);
+    EXPECT_FALSE(dm.IsAllocated(9));
+    EXPECT_EQ(9, dm.AllocatePage(1, 0, b));
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      dm.DeallocatePage(page_id);
+    }
+    EXPECT_EQ(0, dm.AllocatePage());
+    // A new extent starts on an extent boundary, the pages skipped to reach it are free
+    segment_id_t c = dm.CreateSegment();
+    EXPECT_EQ(40, dm.AllocatePage(1, 0, c));
+    EXPECT_FALSE(dm.IsAllocated(33));
+    EXPECT_EQ(1, dm.AllocatePage());
+    // A shard of a parallel buffer pool takes the pages of its residue from the extent
+    EXPECT_EQ(43, dm.AllocatePage(4, 3, c));
+    EXPECT_EQ(41, dm.AllocatePage(1, 0, c));
+    char data[PAGE_SIZE] = {0};
+    dm.WritePage(43, data);
+    dm.ShutDown();
+  }
+  {
+    // After a restart the free pages of the extents are free pages like any other
+    auto dm = DiskManager(db_file, false, 8);
+    EXPECT_TRUE(dm.IsAllocated(9));
+    EXPECT_FALSE(dm.IsAllocated(18));
+    EXPECT_EQ(2, dm.AllocatePage());
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DataFileTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  page_id_t table_page_id;
+  {
+    auto dm = DiskManager(db_file, false, 8);
+    file_id_t table_file = dm.CreateDataFile();
+    file_id_t index_file = dm.CreateDataFile();
+    EXPECT_EQ(1, table_file);
+    EXPECT_EQ(2, index_file);
+    // The pages of a segment are numbered from 0 in the data file of the segment
+    segment_id_t table = dm.CreateSegment(table_file);
+    segment_id_t index = dm.CreateSegment(index_file);
+    table_page_id = dm.AllocatePage(1, 0, table);
+    EXPECT_EQ(table_file, DiskManager::GetFileId(table_page_id));
+    EXPECT_EQ(0, DiskManager::GetPageNumber(table_page_id));
+    EXPECT_EQ(DiskManager::MakePageId(index_file, 0), dm.AllocatePage(1, 0, index));
+    EXPECT_EQ(0, dm.AllocatePage());
+    // A shard of a parallel buffer pool gets the page ids of its residue in every file
+    EXPECT_EQ(1, dm.AllocatePage(3, 1, table) % 3);
+
+    std::strncpy(data, "A table page.", sizeof(data));
+    dm.WritePage(table_page_id, data);
+    dm.ReadPage(table_page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+    EXPECT_EQ(1, dm.GetNumPages(table_file));
+    EXPECT_EQ(0, dm.GetNumPages());
+
+    // Dropping a file unlinks it, its segments cannot allocate anymore
+    dm.WritePage(DiskManager::MakePageId(index_file, 0), data);
+    dm.DropDataFile(index_file);
+    EXPECT_FALSE(dm.HasDataFile(index_file));
+    EXPECT_NE(0, access("test.2.db", F_OK));
+    EXPECT_FALSE(dm.IsAllocated(DiskManager::MakePageId(index_file, 0)));
+    EXPECT_THROW(dm.AllocatePage(1, 0, index), Exception);
+    dm.ShutDown();
+  }
+  {
+    // The data files and their free space maps survive a restart
+    auto dm = DiskManager(db_file, false, 8);
+    EXPECT_TRUE(dm.HasDataFile(1));
+    EXPECT_FALSE(dm.HasDataFile(2));
+    EXPECT_TRUE(dm.IsAllocated(table_page_id));
+    dm.ReadPage(table_page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+    // Truncating a file deallocates all its pages, its segments allocate from its start again
+    segment_id_t table = dm.CreateSegment(1);
+    dm.TruncateDataFile(1);
+    EXPECT_FALSE(dm.IsAllocated(table_page_id));
+    EXPECT_EQ(0, dm.GetNumPages(1));
+    EXPECT_EQ(table_page_id, dm.AllocatePage(1, 0, table));
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LZCodecTest) {
+  char page[PAGE_SIZE];
+  // an incompressible page grows a little
+  char compressed[PAGE_SIZE + 64];
+  char decompressed[PAGE_SIZE];
+  // Runs and repeated records compress, random bytes do not
+  std::memset(page, 0, PAGE_SIZE);
+  for (int i = 0; i < 100; i++) {
+    std::snprintf(page + i * 24, 24, "tuple %d, value %d", i, i % 7);
+  }
+  size_t size = LZCompress(page, PAGE_SIZE, compressed, PAGE_SIZE);
+  EXPECT_GT(size, 0);
+  EXPECT_LT(size, PAGE_SIZE / 4);
+  EXPECT_TRUE(LZDecompress(compressed, size, decompressed, PAGE_SIZE));
+  EXPECT_EQ(0, std::memcmp(page, decompressed, PAGE_SIZE));
+
+  std::mt19937 rng(15445);
+  for (char &c : page) {
+    c = static_cast<char>(rng());
+  }
+  EXPECT_EQ(0, LZCompress(page, PAGE_SIZE, compressed, PAGE_SIZE - COMPRESSED_SLOT_SIZE));
+  size = LZCompress(page, PAGE_SIZE, compressed, sizeof(compressed));
+  EXPECT_GT(size, 0);
+  EXPECT_TRUE(LZDecompress(compressed, size, decompressed, PAGE_SIZE));
+  EXPECT_EQ(0, std::memcmp(page, decompressed, PAGE_SIZE));
+
+  // Corrupt or truncated input is rejected
+  std::memset(page, 'a', PAGE_SIZE);
+  size = LZCompress(page, PAGE_SIZE, compressed, PAGE_SIZE);
+  EXPECT_FALSE(LZDecompress(compressed, size - 1, decompressed, PAGE_SIZE));
+  EXPECT_FALSE(LZDecompress(compressed, size, decompressed, PAGE_SIZE - 1));
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressionTest) {
+  std::string db_file("test.db");
+  std::vector<char> text(PAGE_SIZE, 0);
+  std::vector<char> random(PAGE_SIZE);
+  std::vector<char> buf(PAGE_SIZE);
+  std::strncpy(text.data(), "A compressed page.", PAGE_SIZE);
+  std::mt19937 rng(15445);
+  for (char &c : random) {
+    c = static_cast<char>(rng());
+  }
+  file_id_t file_id;
+  {
+    auto dm = DiskManager(db_file);
+    file_id = dm.CreateDataFile("", true);
+    EXPECT_TRUE(dm.IsCompressed(file_id));
+    EXPECT_FALSE(dm.IsCompressed(0));
+    page_id_t page_id = DiskManager::MakePageId(file_id, 0);
+    dm.WritePage(page_id, text.data());
+    dm.ReadPage(page_id, buf.data());
+    EXPECT_EQ(text, buf);
+    EXPECT_LE(dm.GetDataFileSize(file_id), COMPRESSED_SLOT_SIZE);
+
+    // An incompressible page is stored as it is, pages that change their size move to another slot
+    dm.WritePage(page_id + 1, random.data());
+    for (int i = 0; i < 10; i++) {
+      dm.WritePage(page_id, random.data());
+      dm.WritePage(page_id, text.data());
+    }
+    dm.ReadPage(page_id, buf.data());
+    EXPECT_EQ(text, buf);
+    dm.ReadPage(page_id + 1, buf.data());
+    EXPECT_EQ(random, buf);
+    EXPECT_LE(dm.GetDataFileSize(file_id), 2 * PAGE_SIZE + COMPRESSED_SLOT_SIZE);
+
+    // A page of another size in as many units moves too, its old slot is not overwritten before the page map changes
+    std::vector<char> longer_text(text);
+    std::strncpy(longer_text.data(), "A compressed page, a bit longer.", PAGE_SIZE);
+    dm.WritePage(page_id, longer_text.data());
+    dm.ReadPage(page_id, buf.data());
+    EXPECT_EQ(longer_text, buf);
+    dm.WritePage(page_id, text.data());
+    EXPECT_EQ(2, dm.GetNumPages(file_id));
+
+    const char *pages[] = {random.data(), text.data(), text.data()};
+    dm.WritePages(page_id + 2, pages, 3);
+    dm.ShutDown();
+  }
+  {
+    // The page map survives a restart, and the asynchronous contexts read the pages synchronously
+    auto dm = DiskManager(db_file);
+    EXPECT_TRUE(dm.IsCompressed(file_id));
+    page_id_t page_id = DiskManager::MakePageId(file_id, 0);
+    std::vector<char> pages(6 * PAGE_SIZE);
+    dm.ReadPages(page_id, 6, pages.data());
+    EXPECT_EQ(0, std::memcmp(pages.data(), text.data(), PAGE_SIZE));
+    EXPECT_EQ(0, std::memcmp(pages.data() + PAGE_SIZE, random.data(), PAGE_SIZE));
+    EXPECT_EQ(0, std::memcmp(pages.data() + 2 * PAGE_SIZE, random.data(), PAGE_SIZE));
+    EXPECT_EQ(0, std::memcmp(pages.data() + 4 * PAGE_SIZE, text.data(), PAGE_SIZE));
+    EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(pages.data() + 5 * PAGE_SIZE, PAGE_SIZE));
+
+    auto context = dm.NewAsyncIOContext(4);
+    context->SubmitRead(page_id + 1, 1, buf.data(), 7);
+    std::vector<AsyncIOCompletion> completions;
+    EXPECT_EQ(1, context->Complete(&completions));
+    EXPECT_EQ(7, completions[0].tag_);
+    EXPECT_EQ(PAGE_SIZE, completions[0].result_);
+    EXPECT_EQ(random, buf);
+    context.reset();
+
+    dm.TruncateDataFile(file_id);
+    EXPECT_EQ(0, dm.GetNumPages(file_id));
+    dm.ReadPage(page_id, buf.data());
+    EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), buf);
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIOTest) {
+  std::string db_file("test.db");
+  // Falls back to buffered I/O on file systems without O_DIRECT, the pages read the same either way
+  auto dm = DiskManager(db_file, true);
+  auto *aligned = static_cast<char *>(::operator new[](4 * PAGE_SIZE, std::align_val_t{PAGE_SIZE}));
+  std::vector<char> unaligned(PAGE_SIZE + 1);
+  char *data = unaligned.data() + 1;
+  for (page_id_t page_id = 0; page_id < 3; page_id++) {
+    std::memset(data, 'a' + page_id, PAGE_SIZE);
+    dm.WritePage(page_id, data);
+  }
+  std::memset(aligned, 'z', PAGE_SIZE);
+  dm.WritePage(3, aligned);
+
+  dm.ReadPage(1, data);
+  EXPECT_EQ(std::string(PAGE_SIZE, 'b'), std::string(data, PAGE_SIZE));
+  dm.ReadPage(3, data);
+  EXPECT_EQ(std::string(PAGE_SIZE, 'z'), std::string(data, PAGE_SIZE));
+  dm.ReadPage(0, aligned);
+  EXPECT_EQ(std::string(PAGE_SIZE, 'a'), std::string(aligned, PAGE_SIZE));
+
+  // Past the end of the file: the last two pages read as zeros
+  dm.ReadPages(2, 4, aligned);
+  EXPECT_EQ(std::string(PAGE_SIZE, 'c'), std::string(aligned, PAGE_SIZE));
+  EXPECT_EQ(std::string(PAGE_SIZE, 'z'), std::string(aligned + PAGE_SIZE, PAGE_SIZE));
+  EXPECT_EQ(std::string(2 * PAGE_SIZE, '\0'), std::string(aligned + 2 * PAGE_SIZE, 2 * PAGE_SIZE));
+  ::operator delete[](aligned, std::align_val_t{PAGE_SIZE});
+  dm.ShutDown();
+
+  // A buffered disk manager sees the same file
+  auto buffered = DiskManager(db_file);
+  EXPECT_FALSE(buffered.UsesDirectIO());
+  buffered.ReadPage(2, data);
+  EXPECT_EQ(std::string(PAGE_SIZE, 'c'), std::string(data, PAGE_SIZE));
+  buffered.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -72,6 +439,47 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, SyncPolicyTest) {
+  char data[PAGE_SIZE] = {0};
+  std::vector<const char *> pages(4, data);
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  EXPECT_EQ(SyncPolicy::ON_CHECKPOINT, dm.GetSyncPolicy());
+
+  // Page writes are only synced by a checkpoint, the log always
+  for (page_id_t page_id = 0; page_id < SYNC_GROUP_PAGES; page_id++) {
+    dm.WritePage(page_id, data);
+  }
+  dm.WriteLog(data, 16);
+  EXPECT_EQ(0, dm.GetNumDataSyncs());
+  EXPECT_EQ(1, dm.GetNumLogSyncs());
+  dm.SyncDataFile();
+  EXPECT_EQ(1, dm.GetNumDataSyncs());
+
+  // One sync per write, a vectored write is one write
+  dm.SetSyncPolicy(SyncPolicy::PER_WRITE);
+  dm.WritePage(0, data);
+  dm.WritePages(0, pages.data(), pages.size());
+  EXPECT_EQ(3, dm.GetNumDataSyncs());
+
+  // One sync per group of pages
+  dm.SetSyncPolicy(SyncPolicy::GROUP);
+  for (page_id_t page_id = 0; page_id < SYNC_GROUP_PAGES - 1; page_id++) {
+    dm.WritePage(page_id, data);
+  }
+  EXPECT_EQ(3, dm.GetNumDataSyncs());
+  dm.WritePages(0, pages.data(), pages.size());
+  EXPECT_EQ(4, dm.GetNumDataSyncs());
+  for (page_id_t page_id = 0; page_id < SYNC_GROUP_PAGES; page_id++) {
+    dm.WritePage(page_id, data);
+  }
+  EXPECT_EQ(5, dm.GetNumDataSyncs());
+  EXPECT_EQ(1, dm.GetNumLogSyncs());
+
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
@@ -16,13 +16,29 @@
  *
  * Result:
  * [BENCHMARK: BPlusTreeTest.BPlusTreeBenchmark] 378.25 (ms per iter)
+ *
+ * Write-heavy benchmark, with pessimistic and with optimistic latch crabbing:
+ *    number of threads: 1, 2, 4, 8, 16
+ *    insert total keys: 40000, in random order, then delete every other key, every thread its share
+ *
+ * Result:
+ * [BENCHMARK: BPlusTreeTest.BPlusTreeWriteBenchmark] threads=T pessimistic_ops_per_sec=X optimistic_ops_per_sec=Y
+ *
+ * Read-only benchmark, with latch crabbing and with optimistic lock coupling:
+ *    number of threads: 1, 2, 4, 8, 16
+ *    insert total keys: 40000, then every thread looks up all the keys, in random order
+ *
+ * Result:
+ * [BENCHMARK: BPlusTreeTest.BPlusTreeReadBenchmark] threads=T crabbing_lookups_per_sec=X optimistic_lookups_per_sec=Y
  */
 
+#include <algorithm>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
 #include <future>  // NOLINT
 #include <iostream>
+#include <random>
 #include <thread>  // NOLINT
 
 #include "b_plus_tree_test_util.h"  // NOLINT
@@ -235,6 +251,87 @@ void BPlusTreeBenchmarkCall() {
   std::cout << ss.str() << std::endl;
 }
 
+/** @return insertions and deletions per second of num_threads writers */
+double WriteBenchmarkCall(size_t num_threads, bool optimistic) {
+  const size_t total_keys = 40000;
+  std::vector<int64_t> insert_keys;
+  std::vector<int64_t> delete_keys;
+  for (size_t i = 1; i <= total_keys; i++) {
+    insert_keys.push_back(i);
+    if (i % 2 == 0) {
+      delete_keys.push_back(i);
+    }
+  }
+  std::mt19937 rng(15445);
+  std::shuffle(insert_keys.begin(), insert_keys.end(), rng);
+  std::shuffle(delete_keys.begin(), delete_keys.end(), rng);
+
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(1024, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
+  tree.SetOptimisticLatching(optimistic);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  LaunchParallelTest(num_threads, 0, InsertHelperSplit, &tree, insert_keys, num_threads);
+  LaunchParallelTest(num_threads, num_threads, DeleteHelperSplit, &tree, delete_keys, num_threads);
+  auto end = std::chrono::high_resolution_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  // the odd keys remain, in order
+  int64_t expected = 1;
+  for (auto &pair : tree) {
+    EXPECT_EQ(expected, pair.first.ToString());
+    expected += 2;
+  }
+  EXPECT_EQ(static_cast<int64_t>(total_keys) + 1, expected);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  return (insert_keys.size() + delete_keys.size()) / seconds;
+}
+
+/** @return point lookups per second of num_threads readers */
+double ReadBenchmarkCall(size_t num_threads, bool optimistic_reads) {
+  const size_t total_keys = 40000;
+  std::vector<int64_t> keys;
+  for (size_t i = 1; i <= total_keys; i++) {
+    keys.push_back(i);
+  }
+  std::mt19937 rng(15445);
+  std::shuffle(keys.begin(), keys.end(), rng);
+
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(1024, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
+  tree.SetOptimisticReads(optimistic_reads);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  InsertHelper(&tree, keys, 0);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  LaunchParallelTest(num_threads, 0, LookupHelper, &tree, keys);
+  auto end = std::chrono::high_resolution_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  return num_threads * keys.size() / seconds;
+}
+
 /*
  * Score: 0
  * Description: Benchmark that first insert 3000 keys using
@@ -251,4 +348,33 @@ TEST(BPlusTreeTest, BPlusTreeBenchmark) {
   TEST_TIMEOUT_FAIL_END(1000 * 300)
 }
 
+/*
+ * Description: Benchmark of concurrent writers: with optimistic latch crabbing a writer only W Latches its leaf
+ * unless the leaf splits or merges, so the writers do not queue up on the root page.
+ */
+TEST(BPlusTreeTest, BPlusTreeWriteBenchmark) {
+  for (size_t num_threads : {1, 2, 4, 8, 16}) {
+    double pessimistic = WriteBenchmarkCall(num_threads, false);
+    double optimistic = WriteBenchmarkCall(num_threads, true);
+    std::cout << "[BENCHMARK: BPlusTreeTest.BPlusTreeWriteBenchmark] threads=" << num_threads
+              << " pessimistic_ops_per_sec=" << static_cast<uint64_t>(pessimistic)
+              << " optimistic_ops_per_sec=" << static_cast<uint64_t>(optimistic) << std::endl;
+  }
+}
+
+/*
+ * Description: Benchmark of concurrent readers: the readers never take an exclusive lock, they read the root page id
+ * without any lock and validate it once the root page is latched. With latch crabbing they R Latch every page on the
+ * way down, with optimistic lock coupling they latch no page at all and validate the page versions instead.
+ */
+TEST(BPlusTreeTest, BPlusTreeReadBenchmark) {
+  for (size_t num_threads : {1, 2, 4, 8, 16}) {
+    double crabbing = ReadBenchmarkCall(num_threads, false);
+    double optimistic = ReadBenchmarkCall(num_threads, true);
+    std::cout << "[BENCHMARK: BPlusTreeTest.BPlusTreeReadBenchmark] threads=" << num_threads
+              << " crabbing_lookups_per_sec=" << static_cast<uint64_t>(crabbing)
+              << " optimistic_lookups_per_sec=" << static_cast<uint64_t>(optimistic) << std::endl;
+  }
+}
+
 }  // namespace bustub
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_compression_bench_test.cpp
+//
+// Identification: test/storage/page_compression_bench_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Benchmark of the compression of the data files: the size on disk of the test tables of TableGenerator, and the
+ * throughput of reading their pages back, with plain and with compressed data files.
+ *
+ * Workload:
+ *    the test tables of TableGenerator, each one in its own data file, flushed to disk
+ *    every page of the tables is read with ReadPage 500 times (from the kernel page cache), and test_1 is scanned
+ *    through a buffer pool of 8 frames
+ *
+ * Result:
+ * [BENCHMARK: PageCompressionBenchTest] compressed=0 pages=P logical_kb=L disk_kb=D ratio=R pages_per_sec=X
+ * [BENCHMARK: PageCompressionBenchTest] compressed=1 pages=P logical_kb=L disk_kb=E ratio=S pages_per_sec=Y
+ */
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/table_generator.h"
+#include "concurrency/transaction_manager.h"
+#include "execution/executor_context.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+const int READ_ROUNDS = 500;
+
+static void RemoveFiles() {
+  for (const char *extension : {".db", ".fsm", ".map"}) {
+    remove((std::string("test") + extension).c_str());
+    for (int file_id = 1; file_id <= 8; file_id++) {
+      remove(("test." + std::to_string(file_id) + extension).c_str());
+    }
+  }
+  remove("test.log");
+  remove("test.files");
+}
+
+/** @return the compression ratio of the data files of the test tables */
+static double GenerateAndRead(bool compressed) {
+  RemoveFiles();
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager.get());
+  auto lock_manager = std::make_unique<LockManager>();
+  auto txn_mgr = std::make_unique<TransactionManager>(lock_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), lock_manager.get(), nullptr, compressed);
+  Transaction *txn = txn_mgr->Begin();
+  auto exec_ctx = std::make_unique<ExecutorContext>(txn, catalog.get(), bpm.get(), txn_mgr.get(), lock_manager.get());
+  TableGenerator gen{exec_ctx.get()};
+  gen.GenerateTestTables();
+  txn_mgr->Commit(txn);
+  bpm->FlushAllPages();
+
+  // every table is in a data file of its own
+  std::vector<page_id_t> page_ids;
+  int64_t disk_size = 0;
+  for (file_id_t file_id = 1; disk_manager->HasDataFile(file_id); file_id++) {
+    EXPECT_EQ(compressed, disk_manager->IsCompressed(file_id));
+    for (page_id_t page_number = 0; page_number < disk_manager->GetNumPages(file_id); page_number++) {
+      page_ids.push_back(DiskManager::MakePageId(file_id, page_number));
+    }
+    disk_size += disk_manager->GetDataFileSize(file_id);
+  }
+  int64_t logical_size = static_cast<int64_t>(page_ids.size()) * PAGE_SIZE;
+
+  std::vector<char> data(PAGE_SIZE);
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int round = 0; round < READ_ROUNDS; round++) {
+    for (page_id_t page_id : page_ids) {
+      disk_manager->ReadPage(page_id, data.data());
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  // The tuples read back through a small buffer pool are the ones generated
+  {
+    TableMetadata *test_1 = catalog->GetTable("test_1");
+    BufferPoolManager small_bpm(8, disk_manager.get());
+    TableHeap table(&small_bpm, nullptr, nullptr, test_1->table_->GetFirstPageId());
+    Transaction scan_txn(0);
+    uint32_t num_tuples = 0;
+    for (auto iter = table.Begin(&scan_txn); iter != table.End(); ++iter) {
+      // colA is serial
+      EXPECT_EQ(static_cast<int32_t>(num_tuples), iter->GetValue(&test_1->schema_, 0).GetAs<int32_t>());
+      num_tuples++;
+    }
+    EXPECT_EQ(TEST1_SIZE, num_tuples);
+  }
+
+  double ratio = static_cast<double>(logical_size) / static_cast<double>(disk_size);
+  std::cout << "[BENCHMARK: PageCompressionBenchTest] compressed=" << compressed << " pages=" << page_ids.size()
+            << " logical_kb=" << logical_size / 1024 << " disk_kb=" << disk_size / 1024 << " ratio=" << ratio
+            << " pages_per_sec=" << static_cast<uint64_t>(page_ids.size() * READ_ROUNDS / seconds) << std::endl;
+
+  exec_ctx.reset();
+  catalog.reset();
+  bpm.reset();
+  disk_manager->ShutDown();
+  delete txn;
+  return ratio;
+}
+
+// NOLINTNEXTLINE
+TEST(PageCompressionBenchTest, TestTablesTest) {
+  double plain_ratio = GenerateAndRead(false);
+  double compressed_ratio = GenerateAndRead(true);
+  // the pages of a table heap have their free space in the middle, and the values of a column repeat
+  EXPECT_LT(plain_ratio * 2, compressed_ratio);
+  RemoveFiles();
+}
+
+}  // namespace bustub
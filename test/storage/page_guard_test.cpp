@@ -0,0 +1,217 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "b_plus_tree_test_util.h"  // NOLINT
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/page/page_guard.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+static int PinCount(BufferPoolManager *bpm, page_id_t page_id) {
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    if (bpm->GetPages()[i].GetPageId() == page_id) {
+      return bpm->GetPages()[i].GetPinCount();
+    }
+  }
+  return 0;
+}
+
+static void ExpectNoPinnedPage(BufferPoolManager *bpm) {
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount()) << "page " << bpm->GetPages()[i].GetPageId();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, GuardTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+
+  page_id_t page_id;
+  {
+    BasicPageGuard guard = bpm->NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(1, PinCount(bpm, page_id));
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "Hello");
+
+    // Moving transfers the pin, it is not released twice
+    BasicPageGuard moved = std::move(guard);
+    EXPECT_FALSE(guard.IsValid());  // NOLINT
+    EXPECT_EQ(1, PinCount(bpm, page_id));
+  }
+  EXPECT_EQ(0, PinCount(bpm, page_id));
+
+  // A new page is written back even if nobody wrote into it
+  page_id_t empty_page_id;
+  bpm->NewPageGuarded(&empty_page_id).Drop();
+  bpm->FlushAllPages();
+  int writes = disk_manager->GetNumWrites();
+
+  {
+    // Readers never dirty the page
+    ReadPageGuard guard1 = bpm->FetchPageRead(page_id);
+    ReadPageGuard guard2 = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, PinCount(bpm, page_id));
+    EXPECT_EQ(0, strcmp(guard1.GetData(), "Hello"));
+    guard1.Drop();
+    EXPECT_EQ(1, PinCount(bpm, page_id));
+    guard1.Drop();
+    EXPECT_EQ(1, PinCount(bpm, page_id));
+  }
+  {
+    // Neither do writers that only read
+    WritePageGuard guard = bpm->FetchPageWrite(page_id);
+    EXPECT_EQ(0, strcmp(guard.GetData(), "Hello"));
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes, disk_manager->GetNumWrites());
+
+  {
+    // Assigning a guard releases the page it held, and the write latch is free again afterwards
+    WritePageGuard guard = bpm->FetchPageWrite(page_id);
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "World");
+    guard = bpm->FetchPageWrite(empty_page_id);
+    EXPECT_EQ(0, PinCount(bpm, page_id));
+    EXPECT_EQ(1, PinCount(bpm, empty_page_id));
+    ReadPageGuard read_guard = bpm->FetchPageBasic(page_id).UpgradeRead();
+    EXPECT_EQ(0, strcmp(read_guard.GetData(), "World"));
+  }
+  ExpectNoPinnedPage(bpm);
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + 1, disk_manager->GetNumWrites());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+/*
+ * Operations that change nothing must leave their pages clean, so that they cost no write, and must release every
+ * page they pinned.
+ */
+// NOLINTNEXTLINE
+TEST(PageGuardTest, BPlusTreeDirtyPagesTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 5);
+  GenericKey<8> index_key;
+  auto *transaction = new Transaction(0);
+
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  bpm->UnpinPage(header_page_id, true);
+
+  for (int64_t key = 1; key <= 200; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, RID(key), transaction));
+  }
+  for (int64_t key = 1; key <= 200; key += 3) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  // Splits, merges and redistributions release every page
+  ExpectNoPinnedPage(bpm);
+
+  bpm->FlushAllPages();
+  int writes = disk_manager->GetNumWrites();
+  for (int64_t key = 1; key <= 200; key++) {
+    index_key.SetFromInteger(key);
+    std::vector<RID> rids;
+    EXPECT_EQ(key % 3 != 1, tree.GetValue(index_key, &rids));
+    if (key % 3 != 1) {
+      EXPECT_FALSE(tree.Insert(index_key, RID(key), transaction));  // duplicate
+    } else {
+      tree.Remove(index_key, transaction);  // missing
+    }
+  }
+  int64_t count = 0;
+  for (auto iterator = tree.begin(); iterator != tree.end(); ++iterator) {
+    count++;
+  }
+  EXPECT_EQ(133, count);
+  ExpectNoPinnedPage(bpm);
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes, disk_manager->GetNumWrites());
+
+  delete transaction;
+  delete key_schema;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, TableHeapDirtyPagesTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  auto *txn = new Transaction(0);
+  TableHeap table_heap(bpm, nullptr, nullptr, txn);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::VARCHAR, 256);
+  Schema schema(columns);
+  Tuple tuple({ValueFactory::GetVarcharValue(std::string(200, 'x'))}, &schema);
+
+  // Enough tuples to fill several pages
+  std::vector<RID> rids(100);
+  for (auto &rid : rids) {
+    ASSERT_TRUE(table_heap.InsertTuple(tuple, &rid, txn));
+  }
+  ASSERT_GT(rids.back().GetPageId(), rids.front().GetPageId());
+  ExpectNoPinnedPage(bpm);
+
+  bpm->FlushAllPages();
+  int writes = disk_manager->GetNumWrites();
+  Tuple result;
+  for (const auto &rid : rids) {
+    EXPECT_TRUE(table_heap.GetTuple(rid, &result, txn));
+  }
+  size_t count = 0;
+  for (auto iterator = table_heap.Begin(txn); iterator != table_heap.End(); ++iterator) {
+    count++;
+  }
+  EXPECT_EQ(rids.size(), count);
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes, disk_manager->GetNumWrites());
+
+  // An insert walks past the full pages without dirtying them
+  RID rid;
+  ASSERT_TRUE(table_heap.InsertTuple(tuple, &rid, txn));
+  EXPECT_EQ(rids.back().GetPageId(), rid.GetPageId());
+  ExpectNoPinnedPage(bpm);
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + 1, disk_manager->GetNumWrites());
+
+  delete txn;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
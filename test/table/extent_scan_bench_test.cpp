@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_scan_bench_test.cpp
+//
+// Identification: test/table/extent_scan_bench_test.cpp
+//
+// Copyright (c) 2015-2020, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+/**
+ * Benchmark of a sequential scan of a freshly loaded table, with single page extents (every new page is allocated at
+ * the end of the file, like before segments) and with extents of EXTENT_PAGES pages.
+ *
+ * Workload:
+ *    two tables loaded at the same time, one tuple into each in turn, 30000 random tuples per table (~280 pages);
+ *    buffer pool: 64 frames
+ *    the database is reopened and dropped from the OS page cache, then the first table is scanned. A jump is a page
+ *    of the scan that does not directly follow the previous one in the file.
+ *
+ * Result:
+ * [BENCHMARK: ExtentScanBenchTest] extent_pages=1 pages=P jumps=J scan_mb_per_sec=X
+ * [BENCHMARK: ExtentScanBenchTest] extent_pages=64 pages=P jumps=K scan_mb_per_sec=Y
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "logging/common.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+const size_t POOL_SIZE = 64;
+const int NUM_TUPLES = 30000;
+
+static void DropFromPageCache(const char *file_name) {
+  int fd = open(file_name, O_RDONLY);
+  ASSERT_NE(-1, fd);
+  fsync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+
+/** @return the number of jumps of the scan */
+static size_t LoadAndScan(uint32_t extent_pages) {
+  remove("test.db");
+  remove("test.fsm");
+  Column col1{"a", TypeId::VARCHAR, 200};
+  Column col2{"b", TypeId::BIGINT};
+  Schema schema{{col1, col2}};
+  auto *lock_manager = new LockManager();
+  auto *transaction = new Transaction(0);
+  page_id_t first_page_id;
+  {
+    DiskManager disk_manager("test.db", false, extent_pages);
+    LogManager log_manager(&disk_manager);
+    BufferPoolManager bpm(POOL_SIZE, &disk_manager);
+    TableHeap table(&bpm, lock_manager, &log_manager, transaction);
+    TableHeap other_table(&bpm, lock_manager, &log_manager, transaction);
+    for (int i = 0; i < NUM_TUPLES; i++) {
+      RID rid;
+      EXPECT_TRUE(table.InsertTuple(ConstructTuple(&schema), &rid, transaction));
+      EXPECT_TRUE(other_table.InsertTuple(ConstructTuple(&schema), &rid, transaction));
+    }
+    first_page_id = table.GetFirstPageId();
+    bpm.FlushAllPages();
+    disk_manager.ShutDown();
+  }
+
+  DropFromPageCache("test.db");
+  auto *disk_manager = new DiskManager("test.db", false, extent_pages);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManager(POOL_SIZE, disk_manager);
+  auto *table = new TableHeap(bpm, lock_manager, log_manager, first_page_id);
+  size_t num_tuples = 0;
+  size_t num_pages = 0;
+  size_t jumps = 0;
+  page_id_t last_page_id = INVALID_PAGE_ID;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    page_id_t page_id = itr->GetRid().GetPageId();
+    if (page_id != last_page_id) {
+      num_pages++;
+      jumps += last_page_id != INVALID_PAGE_ID && page_id != last_page_id + 1 ? 1 : 0;
+      last_page_id = page_id;
+    }
+    num_tuples++;
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  EXPECT_EQ(NUM_TUPLES, num_tuples);
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  std::cout << "[BENCHMARK: ExtentScanBenchTest] extent_pages=" << extent_pages << " pages=" << num_pages
+            << " jumps=" << jumps << " scan_mb_per_sec=" << num_pages * PAGE_SIZE / seconds / (1024 * 1024)
+            << std::endl;
+
+  delete table;
+  delete bpm;
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  delete transaction;
+  delete lock_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  return jumps;
+}
+
+// NOLINTNEXTLINE
+TEST(ExtentScanBenchTest, InterleavedLoadTest) {
+  size_t single_page_jumps = LoadAndScan(1);
+  size_t extent_jumps = LoadAndScan(EXTENT_PAGES);
+  // Interleaved single pages jump at every page, extents only once per extent
+  EXPECT_LT(extent_jumps * 10, single_page_jumps);
+}
+
+}  // namespace bustub